@@ -0,0 +1,199 @@
+#include "atlas.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace eng
+{
+
+    skyline_packer::skyline_packer(std::uint32_t width, std::uint32_t height)
+        : page_width(width)
+        , page_height(height)
+        , skyline{ { 0, 0, width } }
+    {
+    }
+
+    bool skyline_packer::fit(std::size_t index, std::uint32_t width,
+                             std::uint32_t height, std::uint32_t& y) const
+    {
+        if (skyline[index].x + width > page_width)
+        {
+            return false;
+        }
+        y                  = 0;
+        std::uint32_t left = width;
+        // segments cover whole page width, so loop ends before running out
+        for (std::size_t i = index; left != 0; ++i)
+        {
+            y = std::max(y, skyline[i].y);
+            if (y + height > page_height)
+            {
+                return false;
+            }
+            left -= std::min(left, skyline[i].width);
+        }
+        return true;
+    }
+
+    bool skyline_packer::insert(std::uint32_t width, std::uint32_t height,
+                                std::uint32_t& x, std::uint32_t& y)
+    {
+        std::size_t   best       = skyline.size();
+        std::uint32_t best_top   = std::numeric_limits<std::uint32_t>::max();
+        std::uint32_t best_width = std::numeric_limits<std::uint32_t>::max();
+        for (std::size_t i = 0; i < skyline.size(); ++i)
+        {
+            std::uint32_t top = 0;
+            if (!fit(i, width, height, top))
+            {
+                continue;
+            }
+            top += height;
+            // lowest top first, then narrowest spot to keep wide ones free
+            if (top < best_top ||
+                (top == best_top && skyline[i].width < best_width))
+            {
+                best       = i;
+                best_top   = top;
+                best_width = skyline[i].width;
+                y          = top - height;
+            }
+        }
+        if (best == skyline.size())
+        {
+            return false;
+        }
+        x = skyline[best].x;
+
+        skyline.insert(skyline.begin() + static_cast<std::ptrdiff_t>(best),
+                       segment{ x, best_top, width });
+        // cut segments now covered by the new one
+        for (std::size_t i = best + 1; i < skyline.size();)
+        {
+            const segment& prev = skyline[i - 1];
+            const std::uint32_t prev_end = prev.x + prev.width;
+            if (skyline[i].x >= prev_end)
+            {
+                break;
+            }
+            const std::uint32_t shrink = prev_end - skyline[i].x;
+            if (skyline[i].width <= shrink)
+            {
+                skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i));
+                continue;
+            }
+            skyline[i].x += shrink;
+            skyline[i].width -= shrink;
+            break;
+        }
+        // join neighbours of same height
+        for (std::size_t i = 0; i + 1 < skyline.size();)
+        {
+            if (skyline[i].y == skyline[i + 1].y)
+            {
+                skyline[i].width += skyline[i + 1].width;
+                skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return true;
+    }
+
+    atlas_allocator::atlas_allocator(std::uint32_t page_size_,
+                                     std::uint32_t padding_)
+        : page_size(page_size_)
+        , padding(padding_)
+    {
+    }
+
+    atlas_allocator::placement atlas_allocator::place(std::uint32_t width,
+                                                      std::uint32_t height)
+    {
+        const std::uint32_t padded_width  = width + 2 * padding;
+        const std::uint32_t padded_height = height + 2 * padding;
+
+        placement     result;
+        std::uint32_t x = 0;
+        std::uint32_t y = 0;
+        for (std::size_t i = 0; i < pages.size(); ++i)
+        {
+            if (pages[i].insert(padded_width, padded_height, x, y))
+            {
+                result.page = i;
+                break;
+            }
+            result.page = i + 1;
+        }
+        if (result.page == pages.size())
+        {
+            pages.emplace_back(std::max(page_size, padded_width),
+                               std::max(page_size, padded_height));
+            const bool inserted =
+                    pages.back().insert(padded_width, padded_height, x, y);
+            assert(inserted);
+            (void)inserted;
+            result.new_page = true;
+        }
+        result.rect        = atlas_rect{ x + padding, y + padding, width, height };
+        result.page_width  = pages[result.page].get_width();
+        result.page_height = pages[result.page].get_height();
+        return result;
+    }
+
+    uv_remap atlas_allocator::get_remap(const placement& p)
+    {
+        const float w = static_cast<float>(p.page_width);
+        const float h = static_cast<float>(p.page_height);
+        uv_remap    result;
+        result.scale  = vec2(p.rect.width / w, p.rect.height / h);
+        result.offset = vec2(p.rect.x / w, p.rect.y / h);
+        return result;
+    }
+
+    image pad_image(const image& img, std::uint32_t padding)
+    {
+        image result;
+        result.width  = img.width + 2 * padding;
+        result.height = img.height + 2 * padding;
+        result.pixels.resize(std::size_t(result.width) * result.height * 4);
+        if (img.width == 0 || img.height == 0)
+        {
+            return result;
+        }
+        const std::size_t src_pitch = std::size_t(img.width) * 4;
+        const std::size_t dst_pitch = std::size_t(result.width) * 4;
+        for (std::uint32_t y = 0; y < result.height; ++y)
+        {
+            const std::uint32_t src_y =
+                    std::min(std::max(y, padding) - padding, img.height - 1);
+            const unsigned char* src = &img.pixels[src_y * src_pitch];
+            unsigned char*       dst = &result.pixels[y * dst_pitch];
+            for (std::uint32_t x = 0; x < padding; ++x)
+            {
+                std::memcpy(dst + x * 4, src, 4);
+                std::memcpy(dst + (padding + img.width + x) * 4,
+                            src + src_pitch - 4, 4);
+            }
+            std::memcpy(dst + padding * 4, src, src_pitch);
+        }
+        return result;
+    }
+
+    void copy_image(const image& src, image& dst, std::uint32_t x, std::uint32_t y)
+    {
+        assert(x + src.width <= dst.width && y + src.height <= dst.height);
+        const std::size_t src_pitch = std::size_t(src.width) * 4;
+        const std::size_t dst_pitch = std::size_t(dst.width) * 4;
+        for (std::uint32_t row = 0; row < src.height; ++row)
+        {
+            std::memcpy(&dst.pixels[(y + row) * dst_pitch + std::size_t(x) * 4],
+                        &src.pixels[row * src_pitch], src_pitch);
+        }
+    }
+
+} // end namespace eng
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "image.hxx"
+#include "math2d.hxx"
+
+namespace eng
+{
+
+/// place of image inside atlas page in pixels, padding not included
+    struct atlas_rect
+    {
+        std::uint32_t x      = 0;
+        std::uint32_t y      = 0;
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+    };
+
+/// maps texture coordinates of sub-texture [0, 1] into its page
+    struct uv_remap
+    {
+        vec2 scale{ 1.f, 1.f };
+        vec2 offset;
+
+        constexpr vec2 apply(const vec2& t) const
+        {
+            return vec2(t.x * scale.x + offset.x, t.y * scale.y + offset.y);
+        }
+    };
+
+/// skyline bottom-left packer for one page: keeps top edge of placed
+/// rectangles as list of horizontal segments, puts every new rectangle
+/// where its top ends lowest
+    class skyline_packer
+    {
+    public:
+        skyline_packer(std::uint32_t width, std::uint32_t height);
+
+        /// return false when rectangle does not fit any more
+        bool insert(std::uint32_t width, std::uint32_t height, std::uint32_t& x,
+                    std::uint32_t& y);
+
+        std::uint32_t get_width() const { return page_width; }
+        std::uint32_t get_height() const { return page_height; }
+
+    private:
+        struct segment
+        {
+            std::uint32_t x;
+            std::uint32_t y;
+            std::uint32_t width;
+        };
+        /// lowest y where rectangle starting at segment index fits, or false
+        bool fit(std::size_t index, std::uint32_t width, std::uint32_t height,
+                 std::uint32_t& y) const;
+
+        std::uint32_t        page_width;
+        std::uint32_t        page_height;
+        std::vector<segment> skyline;
+    };
+
+/// pages of one atlas: finds space for images, opens pages when needed
+    class atlas_allocator
+    {
+    public:
+        /// page_size - side of square page, padding - pixels around
+        /// every image filled with its edge pixels against bleeding
+        atlas_allocator(std::uint32_t page_size, std::uint32_t padding);
+
+        struct placement
+        {
+            std::size_t page = 0;
+            /// image itself, padded block starts padding pixels up and left
+            atlas_rect rect;
+            /// caller has to create page texture of this size first
+            bool          new_page    = false;
+            std::uint32_t page_width  = 0;
+            std::uint32_t page_height = 0;
+        };
+
+        /// images bigger than page get own page of their size
+        placement place(std::uint32_t width, std::uint32_t height);
+
+        std::uint32_t get_padding() const { return padding; }
+
+        static uv_remap get_remap(const placement& p);
+
+    private:
+        std::uint32_t               page_size;
+        std::uint32_t               padding;
+        std::vector<skyline_packer> pages;
+    };
+
+/// img with padding pixels on each side, copies of nearest edge pixel
+    image pad_image(const image& img, std::uint32_t padding);
+
+/// copy src into dst with top left corner at x, y (must fit)
+    void copy_image(const image& src, image& dst, std::uint32_t x, std::uint32_t y);
+
+} // end namespace eng
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+/// timing loop shared by *_bench programs
+
+namespace eng
+{
+
+/// mean time of one f() call: one warm up call first (caches, allocator,
+/// page in of output), then f() runs again and again for 300 ms
+    template <typename F>
+    std::chrono::duration<double, std::nano> time_per_run(F&& f)
+    {
+        using clock = std::chrono::steady_clock;
+        f();
+        std::size_t runs  = 0;
+        const auto  start = clock::now();
+        auto        now   = start;
+        do
+        {
+            f();
+            ++runs;
+            now = clock::now();
+        } while (now - start < std::chrono::milliseconds(300));
+        return std::chrono::duration<double, std::nano>(now - start) / double(runs);
+    }
+
+/// time_per_run in ns divided among count items f() handles
+    template <typename F>
+    double ns_per_item(std::size_t count, F&& f)
+    {
+        return time_per_run(f).count() / double(count);
+    }
+
+} // end namespace eng
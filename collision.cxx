@@ -0,0 +1,477 @@
+#include "collision.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <initializer_list>
+
+#include "transform.hxx"
+
+namespace eng
+{
+
+    namespace
+    {
+        constexpr std::size_t min_buckets = 64;
+
+        struct body_view
+        {
+            const float* cx;
+            const float* cy;
+            const float* ux;
+            const float* uy;
+            const float* vx;
+            const float* vy;
+            const float* inv_u2;
+            const float* inv_v2;
+        };
+
+        void add_contact(std::uint32_t a, std::uint32_t b, std::vector<contact>& out)
+        {
+            out.push_back(a < b ? contact{ a, b } : contact{ b, a });
+        }
+
+        // scalar tests, also tails of simd loops
+
+        bool box_box_scalar(const body_view& w, std::uint32_t a, std::uint32_t b)
+        {
+            const float dx         = w.cx[b] - w.cx[a];
+            const float dy         = w.cy[b] - w.cy[a];
+            const float axes[4][2] = { { w.ux[a], w.uy[a] },
+                                       { w.vx[a], w.vy[a] },
+                                       { w.ux[b], w.uy[b] },
+                                       { w.vx[b], w.vy[b] } };
+            // separating axis theorem, axes need no normalization: both
+            // sides of comparison scale by |n|
+            for (const auto& n : axes)
+            {
+                const float dist = std::abs(dx * n[0] + dy * n[1]);
+                float       r    = 0.f;
+                for (const auto& e : axes)
+                {
+                    r += std::abs(e[0] * n[0] + e[1] * n[1]);
+                }
+                if (dist > r)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool circle_circle_scalar(const body_view& w, std::uint32_t a,
+                                  std::uint32_t b)
+        {
+            const float dx = w.cx[b] - w.cx[a];
+            const float dy = w.cy[b] - w.cy[a];
+            const float r  = w.ux[a] + w.ux[b];
+            return dx * dx + dy * dy <= r * r;
+        }
+
+        /// a is circle: closest point of box b to circle center
+        bool circle_box_scalar(const body_view& w, std::uint32_t a, std::uint32_t b)
+        {
+            const float dx = w.cx[a] - w.cx[b];
+            const float dy = w.cy[a] - w.cy[b];
+            const float s  = std::clamp((dx * w.ux[b] + dy * w.uy[b]) * w.inv_u2[b],
+                                        -1.f, 1.f);
+            const float t  = std::clamp((dx * w.vx[b] + dy * w.vy[b]) * w.inv_v2[b],
+                                        -1.f, 1.f);
+            const float ex = dx - s * w.ux[b] - t * w.vx[b];
+            const float ey = dy - s * w.uy[b] - t * w.vy[b];
+            const float r  = w.ux[a];
+            return ex * ex + ey * ey <= r * r;
+        }
+
+#ifdef eng_HAS_SSE2
+        /// field of four bodies named by pair member
+        __m128 gather(const float* field, const contact* p, std::uint32_t contact::*m)
+        {
+            return _mm_set_ps(field[p[3].*m], field[p[2].*m], field[p[1].*m],
+                              field[p[0].*m]);
+        }
+
+        __m128 abs_ps(__m128 v) { return _mm_andnot_ps(_mm_set1_ps(-0.f), v); }
+
+        __m128 dot(__m128 ax, __m128 ay, __m128 bx, __m128 by)
+        {
+            return _mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by));
+        }
+
+        __m128 clamp_unit(__m128 v)
+        {
+            return _mm_max_ps(_mm_set1_ps(-1.f), _mm_min_ps(_mm_set1_ps(1.f), v));
+        }
+
+        void emit(int hits, const contact* p, std::vector<contact>& out)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                if (hits & (1 << k))
+                {
+                    add_contact(p[k].a, p[k].b, out);
+                }
+            }
+        }
+
+        std::size_t box_box_sse2(const body_view& w, const std::vector<contact>& pairs,
+                                 std::vector<contact>& out)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= pairs.size(); i += 4)
+            {
+                const contact* p  = &pairs[i];
+                const __m128   dx = _mm_sub_ps(gather(w.cx, p, &contact::b),
+                                             gather(w.cx, p, &contact::a));
+                const __m128   dy = _mm_sub_ps(gather(w.cy, p, &contact::b),
+                                             gather(w.cy, p, &contact::a));
+                const __m128   ex[4] = { gather(w.ux, p, &contact::a),
+                                       gather(w.vx, p, &contact::a),
+                                       gather(w.ux, p, &contact::b),
+                                       gather(w.vx, p, &contact::b) };
+                const __m128   ey[4] = { gather(w.uy, p, &contact::a),
+                                       gather(w.vy, p, &contact::a),
+                                       gather(w.uy, p, &contact::b),
+                                       gather(w.vy, p, &contact::b) };
+                __m128 separated = _mm_setzero_ps();
+                for (int n = 0; n < 4; ++n)
+                {
+                    const __m128 dist = abs_ps(dot(dx, dy, ex[n], ey[n]));
+                    __m128       r    = _mm_setzero_ps();
+                    for (int e = 0; e < 4; ++e)
+                    {
+                        r = _mm_add_ps(r, abs_ps(dot(ex[e], ey[e], ex[n], ey[n])));
+                    }
+                    separated = _mm_or_ps(separated, _mm_cmpgt_ps(dist, r));
+                }
+                emit(~_mm_movemask_ps(separated) & 0xf, p, out);
+            }
+            return i;
+        }
+
+        std::size_t circle_circle_sse2(const body_view&            w,
+                                       const std::vector<contact>& pairs,
+                                       std::vector<contact>&       out)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= pairs.size(); i += 4)
+            {
+                const contact* p  = &pairs[i];
+                const __m128   dx = _mm_sub_ps(gather(w.cx, p, &contact::b),
+                                             gather(w.cx, p, &contact::a));
+                const __m128   dy = _mm_sub_ps(gather(w.cy, p, &contact::b),
+                                             gather(w.cy, p, &contact::a));
+                const __m128   r  = _mm_add_ps(gather(w.ux, p, &contact::a),
+                                            gather(w.ux, p, &contact::b));
+                const __m128 hit = _mm_cmple_ps(dot(dx, dy, dx, dy), _mm_mul_ps(r, r));
+                emit(_mm_movemask_ps(hit), p, out);
+            }
+            return i;
+        }
+
+        std::size_t circle_box_sse2(const body_view&            w,
+                                    const std::vector<contact>& pairs,
+                                    std::vector<contact>&       out)
+        {
+            std::size_t i = 0;
+            for (; i + 4 <= pairs.size(); i += 4)
+            {
+                const contact* p  = &pairs[i];
+                const __m128   dx = _mm_sub_ps(gather(w.cx, p, &contact::a),
+                                             gather(w.cx, p, &contact::b));
+                const __m128   dy = _mm_sub_ps(gather(w.cy, p, &contact::a),
+                                             gather(w.cy, p, &contact::b));
+                const __m128   ux = gather(w.ux, p, &contact::b);
+                const __m128   uy = gather(w.uy, p, &contact::b);
+                const __m128   vx = gather(w.vx, p, &contact::b);
+                const __m128   vy = gather(w.vy, p, &contact::b);
+                const __m128   s  = clamp_unit(_mm_mul_ps(
+                        dot(dx, dy, ux, uy), gather(w.inv_u2, p, &contact::b)));
+                const __m128 t = clamp_unit(_mm_mul_ps(
+                        dot(dx, dy, vx, vy), gather(w.inv_v2, p, &contact::b)));
+                const __m128 ex = _mm_sub_ps(
+                        dx, _mm_add_ps(_mm_mul_ps(s, ux), _mm_mul_ps(t, vx)));
+                const __m128 ey = _mm_sub_ps(
+                        dy, _mm_add_ps(_mm_mul_ps(s, uy), _mm_mul_ps(t, vy)));
+                const __m128 r   = gather(w.ux, p, &contact::a);
+                const __m128 hit = _mm_cmple_ps(dot(ex, ey, ex, ey), _mm_mul_ps(r, r));
+                emit(_mm_movemask_ps(hit), p, out);
+            }
+            return i;
+        }
+#endif
+
+        template <typename Simd, typename Scalar>
+        void narrow_phase(const body_view& w, const std::vector<contact>& pairs,
+                          std::vector<contact>& out, Simd simd, Scalar scalar)
+        {
+            std::size_t i = 0;
+#ifdef eng_HAS_SSE2
+            if (get_simd_level() != simd_level::scalar)
+            {
+                i = simd(w, pairs, out);
+            }
+#else
+            (void)simd;
+#endif
+            for (; i < pairs.size(); ++i)
+            {
+                if (scalar(w, pairs[i].a, pairs[i].b))
+                {
+                    add_contact(pairs[i].a, pairs[i].b, out);
+                }
+            }
+        }
+    } // namespace
+
+    collision_world::collision_world(float cell_size)
+        : inv_cell(1.f / cell_size)
+    {
+        assert(cell_size > 0.f);
+        rehash(min_buckets);
+    }
+
+    std::uint32_t collision_world::allocate()
+    {
+        ++live;
+        if (!free_ids.empty())
+        {
+            const std::uint32_t id = free_ids.back();
+            free_ids.pop_back();
+            return id;
+        }
+        const auto id = static_cast<std::uint32_t>(kind.size());
+        kind.push_back(shape::none);
+        for (auto* field : { &center_x, &center_y, &u_x, &u_y, &v_x, &v_y, &inv_u2,
+                             &inv_v2 })
+        {
+            field->push_back(0.f);
+        }
+        box.push_back(bounds{ 0.f, 0.f, 0.f, 0.f, cell_range{ 0, 0, -1, -1 } });
+        // keep about one body per bucket
+        if (live > buckets.size())
+        {
+            rehash(buckets.size() * 2);
+        }
+        return id;
+    }
+
+    std::uint32_t collision_world::add_box(const mat2x3& m, const vec2& half_size)
+    {
+        const std::uint32_t id = allocate();
+        set_box(id, m, half_size);
+        return id;
+    }
+
+    std::uint32_t collision_world::add_circle(const mat2x3& m, float radius)
+    {
+        const std::uint32_t id = allocate();
+        set_circle(id, m, radius);
+        return id;
+    }
+
+    void collision_world::set_box(std::uint32_t id, const mat2x3& m,
+                                  const vec2& half_size)
+    {
+        assert(id < kind.size());
+        kind[id]     = shape::box;
+        center_x[id] = m.delta.x;
+        center_y[id] = m.delta.y;
+        // local (hx, 0) and (0, hy) through m
+        u_x[id]        = half_size.x * m.row1.x;
+        u_y[id]        = half_size.x * m.row1.y;
+        v_x[id]        = half_size.y * m.row2.x;
+        v_y[id]        = half_size.y * m.row2.y;
+        const float u2 = u_x[id] * u_x[id] + u_y[id] * u_y[id];
+        const float v2 = v_x[id] * v_x[id] + v_y[id] * v_y[id];
+        inv_u2[id]     = u2 > 0.f ? 1.f / u2 : 0.f;
+        inv_v2[id]     = v2 > 0.f ? 1.f / v2 : 0.f;
+        const float ex = std::abs(u_x[id]) + std::abs(v_x[id]);
+        const float ey = std::abs(u_y[id]) + std::abs(v_y[id]);
+        box[id].min_x  = center_x[id] - ex;
+        box[id].max_x  = center_x[id] + ex;
+        box[id].min_y  = center_y[id] - ey;
+        box[id].max_y  = center_y[id] + ey;
+        place(id);
+    }
+
+    void collision_world::set_circle(std::uint32_t id, const mat2x3& m, float radius)
+    {
+        assert(id < kind.size());
+        const float r =
+                radius * std::sqrt(m.row1.x * m.row1.x + m.row1.y * m.row1.y);
+        kind[id]     = shape::circle;
+        center_x[id] = m.delta.x;
+        center_y[id] = m.delta.y;
+        u_x[id]      = r;
+        u_y[id]      = 0.f;
+        v_x[id]      = 0.f;
+        v_y[id]      = 0.f;
+        inv_u2[id]   = 0.f;
+        inv_v2[id]   = 0.f;
+        box[id].min_x = center_x[id] - r;
+        box[id].max_x = center_x[id] + r;
+        box[id].min_y = center_y[id] - r;
+        box[id].max_y = center_y[id] + r;
+        place(id);
+    }
+
+    void collision_world::remove(std::uint32_t id)
+    {
+        assert(id < kind.size() && kind[id] != shape::none);
+        erase(id, box[id].cells);
+        box[id].cells = cell_range{ 0, 0, -1, -1 };
+        kind[id]  = shape::none;
+        free_ids.push_back(id);
+        --live;
+    }
+
+    collision_world::cell_range collision_world::get_cells(std::uint32_t id) const
+    {
+        const bounds& b = box[id];
+        return cell_range{ static_cast<std::int32_t>(std::floor(b.min_x * inv_cell)),
+                           static_cast<std::int32_t>(std::floor(b.min_y * inv_cell)),
+                           static_cast<std::int32_t>(std::floor(b.max_x * inv_cell)),
+                           static_cast<std::int32_t>(std::floor(b.max_y * inv_cell)) };
+    }
+
+    std::uint32_t collision_world::bucket_of(std::int32_t x, std::int32_t y) const
+    {
+        // primes from Teschner et al. spatial hashing
+        const std::uint32_t h = (static_cast<std::uint32_t>(x) * 73856093u) ^
+                                (static_cast<std::uint32_t>(y) * 19349663u);
+        return h & bucket_mask;
+    }
+
+    void collision_world::place(std::uint32_t id)
+    {
+        const cell_range now = get_cells(id);
+        if (now == box[id].cells)
+        {
+            return; // moved inside same cells: grid stays as is
+        }
+        erase(id, box[id].cells);
+        insert(id, now);
+        box[id].cells = now;
+    }
+
+    void collision_world::insert(std::uint32_t id, const cell_range& r)
+    {
+        for (std::int32_t y = r.y0; y <= r.y1; ++y)
+        {
+            for (std::int32_t x = r.x0; x <= r.x1; ++x)
+            {
+                // two cells of one body may share bucket: keep id once
+                std::vector<std::uint32_t>& bucket = buckets[bucket_of(x, y)];
+                if (std::find(bucket.begin(), bucket.end(), id) == bucket.end())
+                {
+                    bucket.push_back(id);
+                }
+            }
+        }
+    }
+
+    void collision_world::erase(std::uint32_t id, const cell_range& r)
+    {
+        for (std::int32_t y = r.y0; y <= r.y1; ++y)
+        {
+            for (std::int32_t x = r.x0; x <= r.x1; ++x)
+            {
+                std::vector<std::uint32_t>& bucket = buckets[bucket_of(x, y)];
+                const auto it = std::find(bucket.begin(), bucket.end(), id);
+                if (it != bucket.end())
+                {
+                    *it = bucket.back();
+                    bucket.pop_back();
+                }
+            }
+        }
+    }
+
+    void collision_world::rehash(std::size_t bucket_count)
+    {
+        buckets.assign(bucket_count, {});
+        bucket_mask = static_cast<std::uint32_t>(bucket_count - 1);
+        for (std::uint32_t id = 0; id < kind.size(); ++id)
+        {
+            if (kind[id] != shape::none)
+            {
+                insert(id, box[id].cells);
+            }
+        }
+    }
+
+    void collision_world::add_candidate(std::uint32_t a, std::uint32_t b)
+    {
+        if (kind[a] == shape::box && kind[b] == shape::box)
+        {
+            box_box.push_back({ a, b });
+        }
+        else if (kind[a] == shape::circle && kind[b] == shape::circle)
+        {
+            circle_circle.push_back({ a, b });
+        }
+        else if (kind[a] == shape::circle)
+        {
+            circle_box.push_back({ a, b });
+        }
+        else
+        {
+            circle_box.push_back({ b, a });
+        }
+    }
+
+    const std::vector<contact>& collision_world::find_contacts()
+    {
+        box_box.clear();
+        circle_circle.clear();
+        circle_box.clear();
+        contacts.clear();
+
+        // bucket by bucket: buckets are read in memory order, every pair
+        // inside one is tested once
+        for (std::uint32_t index = 0; index < buckets.size(); ++index)
+        {
+            const std::vector<std::uint32_t>& bucket = buckets[index];
+            for (std::size_t i = 0; i + 1 < bucket.size(); ++i)
+            {
+                const std::uint32_t a  = bucket[i];
+                const bounds&       ba = box[a];
+                for (std::size_t j = i + 1; j < bucket.size(); ++j)
+                {
+                    const std::uint32_t b  = bucket[j];
+                    const bounds&       bb = box[b];
+                    if (bb.min_x > ba.max_x || bb.max_x < ba.min_x ||
+                        bb.min_y > ba.max_y || bb.max_y < ba.min_y)
+                    {
+                        continue;
+                    }
+                    // pair sharing several buckets is taken only in bucket
+                    // of cell with min corner of bounds overlap
+                    if (bucket_of(std::max(ba.cells.x0, bb.cells.x0),
+                                  std::max(ba.cells.y0, bb.cells.y0)) != index)
+                    {
+                        continue;
+                    }
+                    add_candidate(a, b);
+                }
+            }
+        }
+
+        const body_view w{ center_x.data(), center_y.data(), u_x.data(),
+                           u_y.data(),      v_x.data(),      v_y.data(),
+                           inv_u2.data(),   inv_v2.data() };
+#ifdef eng_HAS_SSE2
+        narrow_phase(w, box_box, contacts, box_box_sse2, box_box_scalar);
+        narrow_phase(w, circle_circle, contacts, circle_circle_sse2,
+                     circle_circle_scalar);
+        narrow_phase(w, circle_box, contacts, circle_box_sse2, circle_box_scalar);
+#else
+        narrow_phase(w, box_box, contacts, nullptr, box_box_scalar);
+        narrow_phase(w, circle_circle, contacts, nullptr, circle_circle_scalar);
+        narrow_phase(w, circle_box, contacts, nullptr, circle_box_scalar);
+#endif
+        return contacts;
+    }
+
+} // end namespace eng
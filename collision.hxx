@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// two overlapping bodies, a < b
+    struct contact
+    {
+        std::uint32_t a;
+        std::uint32_t b;
+    };
+
+/// overlap tests for boxes and circles placed by sprite matrixes.
+/// Broad phase: uniform grid hashed into buckets; body changes buckets
+/// only when it crosses cell border, so moving bodies cost little.
+/// Narrow phase: exact tests four pairs at once (SSE2, see
+/// get_simd_level()). Ids are stable until remove, then reused
+    class eng_DECLSPEC collision_world
+    {
+    public:
+        /// cell_size about size of typical body: small cells put big
+        /// bodies into many buckets, big cells put many bodies into one
+        explicit collision_world(float cell_size);
+
+        /// sprite quad [-half_size, half_size] under m (p * m + m.delta),
+        /// default half size covers sprite meshes of this repo. m may
+        /// rotate and scale, but not shear
+        std::uint32_t add_box(const mat2x3& m,
+                              const vec2&   half_size = vec2(0.5f, 0.5f));
+        /// circle around m.delta, radius scaled by m (uniform scale)
+        std::uint32_t add_circle(const mat2x3& m, float radius = 0.5f);
+        void          set_box(std::uint32_t id, const mat2x3& m,
+                              const vec2& half_size = vec2(0.5f, 0.5f));
+        void          set_circle(std::uint32_t id, const mat2x3& m,
+                                 float radius = 0.5f);
+        void          remove(std::uint32_t id);
+        std::size_t   size() const { return live; }
+
+        /// every overlapping pair once, valid until next call
+        const std::vector<contact>& find_contacts();
+
+    private:
+        enum class shape : std::uint8_t
+        {
+            none,
+            box,
+            circle
+        };
+
+        struct cell_range
+        {
+            std::int32_t x0, y0, x1, y1;
+            bool         operator==(const cell_range& r) const
+            {
+                return x0 == r.x0 && y0 == r.y0 && x1 == r.x1 && y1 == r.y1;
+            }
+        };
+
+        /// all broad phase reads of one body in one cache line
+        struct alignas(32) bounds
+        {
+            float      min_x, min_y, max_x, max_y;
+            cell_range cells;
+        };
+
+        std::uint32_t allocate();
+        /// recompute bounds of id, move it between buckets if needed
+        void       place(std::uint32_t id);
+        cell_range get_cells(std::uint32_t id) const;
+        std::uint32_t bucket_of(std::int32_t x, std::int32_t y) const;
+        void          insert(std::uint32_t id, const cell_range& cells);
+        void          erase(std::uint32_t id, const cell_range& cells);
+        void          rehash(std::size_t bucket_count);
+        /// sort pair into candidate list of its shapes
+        void add_candidate(std::uint32_t a, std::uint32_t b);
+
+        float inv_cell;
+
+        // body fields by id: center, half axes u and v (radius in u.x for
+        // circle), 1/|u|^2 and 1/|v|^2 for box, bounds and covered cells
+        std::vector<shape>  kind;
+        std::vector<float>  center_x, center_y;
+        std::vector<float>  u_x, u_y, v_x, v_y;
+        std::vector<float>  inv_u2, inv_v2;
+        std::vector<bounds> box;
+
+        std::vector<std::uint32_t> free_ids;
+        std::size_t                live = 0;
+
+        std::vector<std::vector<std::uint32_t>> buckets;
+        std::uint32_t                           bucket_mask = 0;
+
+        // candidates of last find_contacts by shape pair, circle first
+        std::vector<contact> box_box;
+        std::vector<contact> circle_circle;
+        std::vector<contact> circle_box;
+        std::vector<contact> contacts;
+    };
+
+} // end namespace eng
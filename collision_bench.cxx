@@ -0,0 +1,98 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bench.hxx"
+#include "collision.hxx"
+#include "transform.hxx"
+
+/// cost of one collision tick (move every body, find contacts) per body,
+/// for growing body counts and every simd level. Area grows with count,
+/// so bodies per cell stay the same and cost per body should stay flat
+/// usage: collision_bench [max_count]
+
+struct body
+{
+    eng::mat2x3 m;
+    eng::vec2   velocity;
+    bool        circle;
+};
+
+int main(int argc, char* argv[])
+{
+    const std::size_t max_count =
+            argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937                          random(42);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+    // tank sized boxes and shell sized circles, 0.05 units apart on average;
+    // cell fits biggest body (rotated box bounds are up to 1.41 * size)
+    constexpr float spacing   = 0.05f;
+    constexpr float size      = 0.03f;
+    constexpr float cell_size = 2.f * size;
+
+    std::cout << "ns per body per tick\n" << std::setw(10) << "count";
+    const eng::simd_level best = eng::get_best_simd_level();
+    for (int level = 0; level <= static_cast<int>(best); ++level)
+    {
+        std::cout << std::setw(10)
+                  << eng::to_string(static_cast<eng::simd_level>(level));
+    }
+    std::cout << std::setw(12) << "contacts" << '\n';
+
+    for (std::size_t count = 1000; count <= max_count; count *= 10)
+    {
+        const float half_side = 0.5f * spacing * std::sqrt(float(count));
+
+        std::vector<body> bodies(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const bool circle = i % 2 == 0;
+            bodies[i]         = body{
+                eng::mat2x3::rotate(unit(random) * 180.f) *
+                        eng::mat2x3::scale(circle ? size * 0.5f : size) *
+                        eng::mat2x3::move(eng::vec2(unit(random), unit(random)) *
+                                          half_side),
+                eng::vec2(unit(random), unit(random)) * 0.002f, circle
+            };
+        }
+
+        std::cout << std::setw(10) << count;
+        std::size_t contacts = 0;
+        for (int level = 0; level <= static_cast<int>(best); ++level)
+        {
+            eng::set_simd_level(static_cast<eng::simd_level>(level));
+            eng::collision_world world(cell_size);
+            for (const body& b : bodies)
+            {
+                b.circle ? world.add_circle(b.m) : world.add_box(b.m);
+            }
+            std::vector<body> moving = bodies;
+            const double      ns     = eng::ns_per_item(count, [&] {
+                for (std::uint32_t id = 0; id < moving.size(); ++id)
+                {
+                    body& b = moving[id];
+                    b.m.delta = b.m.delta + b.velocity;
+                    // bounce off area border
+                    if (std::abs(b.m.delta.x) > half_side)
+                    {
+                        b.velocity.x = -b.velocity.x;
+                    }
+                    if (std::abs(b.m.delta.y) > half_side)
+                    {
+                        b.velocity.y = -b.velocity.y;
+                    }
+                    b.circle ? world.set_circle(id, b.m) : world.set_box(id, b.m);
+                }
+                contacts = world.find_contacts().size();
+            });
+            std::cout << std::fixed << std::setprecision(1) << std::setw(10) << ns;
+        }
+        std::cout << std::setw(12) << contacts << '\n';
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+#include "command_list.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+#include "transform.hxx"
+
+namespace eng
+{
+
+    void command_list::clear()
+    {
+        commands.clear();
+        tri0s.clear();
+        tri1s.clear();
+        vertexes.clear();
+    }
+
+    void command_list::draw(const tri0* tris, std::size_t count, const color& c,
+                            std::uint8_t layer)
+    {
+        const auto first = static_cast<std::uint32_t>(tri0s.size());
+        tri0s.insert(tri0s.end(), tris, tris + count);
+        commands.push_back({ make_sort_key(layer, draw_kind::color, nullptr), nullptr,
+                             c, first, static_cast<std::uint32_t>(count),
+                             draw_kind::color });
+    }
+
+    void command_list::draw(const tri1* tris, std::size_t count, std::uint8_t layer)
+    {
+        const auto first = static_cast<std::uint32_t>(tri1s.size());
+        tri1s.insert(tri1s.end(), tris, tris + count);
+        commands.push_back({ make_sort_key(layer, draw_kind::vertex_color, nullptr),
+                             nullptr, color(), first,
+                             static_cast<std::uint32_t>(count),
+                             draw_kind::vertex_color });
+    }
+
+    void command_list::draw(const tri2* tris, std::size_t count, texture* tex,
+                            const mat2x3& m, std::uint8_t layer)
+    {
+        assert(tex != nullptr);
+        const std::size_t first = vertexes.size();
+        vertexes.resize(first + count * 3);
+        v2* out = &vertexes[first];
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            transform_vertexes(tris[i].v, out + i * 3, 3, m);
+        }
+        commands.push_back({ make_sort_key(layer, draw_kind::textured, tex), tex,
+                             color(), static_cast<std::uint32_t>(first),
+                             static_cast<std::uint32_t>(count), draw_kind::textured });
+    }
+
+    void command_list::draw(const quad* quads, std::size_t count, texture* tex,
+                            const mat2x3& m, std::uint8_t layer)
+    {
+        assert(tex != nullptr);
+        const std::size_t first = vertexes.size();
+        vertexes.resize(first + count * 4);
+        v2* out = &vertexes[first];
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            transform_vertexes(quads[i].v, out + i * 4, 4, m);
+        }
+        commands.push_back({ make_sort_key(layer, draw_kind::textured_quad, tex), tex,
+                             color(), static_cast<std::uint32_t>(first),
+                             static_cast<std::uint32_t>(count),
+                             draw_kind::textured_quad });
+    }
+
+    std::uint64_t make_sort_key(std::uint8_t layer, draw_kind kind, const texture* tex)
+    {
+        // textures are at least 16 byte aligned, low bits carry nothing
+        const auto address = reinterpret_cast<std::uintptr_t>(tex) >> 4;
+        return std::uint64_t(layer) << 56 |
+               std::uint64_t(static_cast<std::uint8_t>(kind)) << 54 |
+               (std::uint64_t(address) & ((std::uint64_t(1) << 54) - 1));
+    }
+
+    void sort_commands(const command_list* lists, std::size_t count,
+                       std::vector<command_ref>& out, std::vector<command_ref>& scratch)
+    {
+        std::size_t total = 0;
+        for (std::size_t l = 0; l < count; ++l)
+        {
+            total += lists[l].size();
+        }
+        out.clear();
+        out.reserve(total);
+        for (std::size_t l = 0; l < count; ++l)
+        {
+            for (std::size_t i = 0; i < lists[l].size(); ++i)
+            {
+                out.push_back({ lists[l].get_command(i).key,
+                                static_cast<std::uint32_t>(l),
+                                static_cast<std::uint32_t>(i) });
+            }
+        }
+        scratch.resize(out.size());
+
+        // lsd radix sort, 8 bit digits; histograms of all digits in one
+        // pass, digit same for every key (most of pointer bits) is skipped
+        constexpr std::size_t digits = 8;
+        std::array<std::array<std::uint32_t, 256>, digits> histogram{};
+        for (const command_ref& r : out)
+        {
+            for (std::size_t d = 0; d < digits; ++d)
+            {
+                ++histogram[d][(r.key >> (d * 8)) & 0xff];
+            }
+        }
+        for (std::size_t d = 0; d < digits; ++d)
+        {
+            std::array<std::uint32_t, 256>& h = histogram[d];
+            if (!out.empty() && h[(out[0].key >> (d * 8)) & 0xff] == out.size())
+            {
+                continue;
+            }
+            std::uint32_t offset = 0;
+            for (std::uint32_t& bucket : h)
+            {
+                const std::uint32_t n = bucket;
+                bucket                = offset;
+                offset += n;
+            }
+            for (const command_ref& r : out)
+            {
+                scratch[h[(r.key >> (d * 8)) & 0xff]++] = r;
+            }
+            out.swap(scratch);
+        }
+    }
+
+    void replay_commands(engine& e, const command_list* lists,
+                         const std::vector<command_ref>& sorted)
+    {
+        const mat2x3 identity = mat2x3::identity();
+        bool         batching = false;
+        for (const command_ref& r : sorted)
+        {
+            const command_list& list = lists[r.list];
+            const draw_command& c    = list.get_command(r.index);
+            if (c.kind == draw_kind::textured || c.kind == draw_kind::textured_quad)
+            {
+                if (!batching)
+                {
+                    e.begin_batch();
+                    batching = true;
+                }
+                const v2* v = list.get_vertexes(c);
+                for (std::uint32_t i = 0; i < c.count; ++i)
+                {
+                    if (c.kind == draw_kind::textured_quad)
+                    {
+                        quad q;
+                        std::copy(v + i * 4, v + i * 4 + 4, q.v);
+                        e.submit(q, c.tex, identity);
+                        continue;
+                    }
+                    tri2 t;
+                    t.v[0] = v[i * 3];
+                    t.v[1] = v[i * 3 + 1];
+                    t.v[2] = v[i * 3 + 2];
+                    e.submit(t, c.tex, identity);
+                }
+                continue;
+            }
+            if (batching)
+            {
+                e.flush_batch();
+                batching = false;
+            }
+            for (std::uint32_t i = 0; i < c.count; ++i)
+            {
+                if (c.kind == draw_kind::color)
+                {
+                    e.render(list.get_tri0(c)[i], c.c);
+                }
+                else
+                {
+                    e.render(list.get_tri1(c)[i]);
+                }
+            }
+        }
+        if (batching)
+        {
+            e.flush_batch();
+        }
+    }
+
+} // end namespace eng
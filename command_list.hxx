@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// shader a command draws with, part of its sort key
+    enum class draw_kind : std::uint8_t
+    {
+        /// tri0 with one color
+        color,
+        /// tri1, color per vertex
+        vertex_color,
+        /// tri2 with texture, batched by texture on replay
+        textured,
+        /// quad with texture, drawn with shared quad indexes on replay
+        textured_quad
+    };
+
+/// one recorded draw: count triangles or quads of its kind's storage in
+/// the list from first (a vertex for textured kinds, else a triangle)
+    struct draw_command
+    {
+        std::uint64_t key;
+        texture*      tex;
+        color         c;
+        std::uint32_t first;
+        std::uint32_t count;
+        draw_kind     kind;
+    };
+
+/// draw calls recorded on any thread, one list per thread, replayed by
+/// engine::execute on gl thread. Textured triangles are transformed
+/// while recording, so replay only copies vertexes.
+/// Within one layer commands are reordered to group shader and texture:
+/// use layers for anything that must be drawn over something else
+    class eng_DECLSPEC command_list
+    {
+    public:
+        /// keep capacity, lists are meant to be reused every frame
+        void clear();
+        std::size_t size() const { return commands.size(); }
+
+        void draw(const tri0* tris, std::size_t count, const color& c,
+                  std::uint8_t layer = 0);
+        void draw(const tri1* tris, std::size_t count, std::uint8_t layer = 0);
+        /// tris go through m (as submit) on calling thread
+        void draw(const tri2* tris, std::size_t count, texture* tex,
+                  const mat2x3& m, std::uint8_t layer = 0);
+        /// quads go through m on calling thread too
+        void draw(const quad* quads, std::size_t count, texture* tex,
+                  const mat2x3& m, std::uint8_t layer = 0);
+
+        const draw_command& get_command(std::size_t index) const
+        {
+            return commands[index];
+        }
+        const tri0* get_tri0(const draw_command& c) const { return &tri0s[c.first]; }
+        const tri1* get_tri1(const draw_command& c) const { return &tri1s[c.first]; }
+        /// transformed vertexes, 3 * count for textured, 4 * count for
+        /// textured_quad
+        const v2* get_vertexes(const draw_command& c) const
+        {
+            return &vertexes[c.first];
+        }
+
+    private:
+        std::vector<draw_command> commands;
+        std::vector<tri0>         tri0s;
+        std::vector<tri1>         tri1s;
+        std::vector<v2>           vertexes;
+    };
+
+/// 64 bit state key: layer (8 bits) | kind (2 bits) | texture (54 bits,
+/// address based: equal textures are adjacent, their order is arbitrary)
+    std::uint64_t eng_DECLSPEC make_sort_key(std::uint8_t layer, draw_kind kind,
+                                             const texture* tex);
+
+/// command of lists[list], position in replay order
+    struct command_ref
+    {
+        std::uint64_t key;
+        std::uint32_t list;
+        std::uint32_t index;
+    };
+
+/// merge commands of all lists and radix sort them by key (stable: equal
+/// keys keep list order, then recording order). scratch is reused
+/// between frames to avoid allocation
+    void eng_DECLSPEC sort_commands(const command_list* lists, std::size_t count,
+                                    std::vector<command_ref>& out,
+                                    std::vector<command_ref>& scratch);
+
+/// draw sorted commands through engine::render and batch calls, for
+/// backends without faster path
+    void eng_DECLSPEC replay_commands(engine& e, const command_list* lists,
+                                      const std::vector<command_ref>& sorted);
+
+} // end namespace eng
@@ -3,14 +3,20 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <fstream>
+#include <initializer_list>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 #include <cmath>
 
@@ -18,7 +24,20 @@
 #include <SDL2/SDL_opengl.h>
 #include <SDL2/SDL_opengl_glext.h>
 
-#include "picopng.hxx"
+#include "atlas.hxx"
+#include "command_list.hxx"
+#include "engine_config.hxx"
+#include "engine_soft.hxx"
+#include "frame_pacing.hxx"
+#include "gl_debug.hxx"
+#include "image.hxx"
+#include "input.hxx"
+#include "log.hxx"
+#include "profiler.hxx"
+#include "program_cache.hxx"
+#include "texture_loader.hxx"
+#include "transform.hxx"
+#include "vertex_layout.hxx"
 
 // we have to load all extension GL function pointers
 // dynamically freng OpenGL library
@@ -44,7 +63,56 @@ static PFNGLGETUNIFORMLOCATIONPROC       glGetUniformLocation       = nullptr;
 static PFNGLUNIFORM1IPROC                glUniform1i                = nullptr;
 static PFNGLACTIVETEXTUREPROC            glActiveTextureMY          = nullptr;
 static PFNGLUNIFORM4FVPROC               glUniform4fv               = nullptr;
+static PFNGLUNIFORM1FPROC                glUniform1f                = nullptr;
 static PFNGLUNIFORMMATRIX3FVPROC         glUniformMatrix3fv         = nullptr;
+static PFNGLGETACTIVEUNIFORMPROC         glGetActiveUniform         = nullptr;
+static PFNGLGETACTIVEATTRIBPROC          glGetActiveAttrib          = nullptr;
+static PFNGLGETATTRIBLOCATIONPROC        glGetAttribLocation        = nullptr;
+static PFNGLVERTEXATTRIB4FVPROC          glVertexAttrib4fv          = nullptr;
+static PFNGLGENBUFFERSPROC               glGenBuffers               = nullptr;
+static PFNGLDELETEBUFFERSPROC            glDeleteBuffers            = nullptr;
+static PFNGLBINDBUFFERPROC               glBindBuffer               = nullptr;
+static PFNGLBUFFERDATAPROC               glBufferData               = nullptr;
+static PFNGLBUFFERSUBDATAPROC            glBufferSubData            = nullptr;
+static PFNGLMAPBUFFERPROC                glMapBuffer                = nullptr;
+static PFNGLUNMAPBUFFERPROC              glUnmapBuffer              = nullptr;
+// unsynchronized buffer writes: core 3.2, or ARB_map_buffer_range with
+// ARB_sync (core names), loaded only when supported
+static PFNGLMAPBUFFERRANGEPROC           glMapBufferRange           = nullptr;
+static PFNGLFENCESYNCPROC                glFenceSync                = nullptr;
+static PFNGLCLIENTWAITSYNCPROC           glClientWaitSync           = nullptr;
+static PFNGLDELETESYNCPROC               glDeleteSync               = nullptr;
+// instancing: core 3.3, or ARB/EXT/ANGLE_instanced_arrays (same
+// signatures with suffix), loaded only when supported
+static PFNGLDRAWARRAYSINSTANCEDPROC      glDrawArraysInstanced      = nullptr;
+static PFNGLVERTEXATTRIBDIVISORPROC      glVertexAttribDivisor      = nullptr;
+static PFNGLDRAWELEMENTSINSTANCEDPROC    glDrawElementsInstanced    = nullptr;
+// program binaries: core 4.1 or ARB_get_program_binary, loaded only when
+// program cache is configured and supported
+static PFNGLGETPROGRAMBINARYPROC         glGetProgramBinary         = nullptr;
+static PFNGLPROGRAMBINARYPROC            glProgramBinary            = nullptr;
+static PFNGLPROGRAMPARAMETERIPROC        glProgramParameteri        = nullptr;
+// render to texture: core 3.0 or ARB_framebuffer_object, else
+// EXT_framebuffer_object (same signatures with suffix), loaded only when
+// supported
+static PFNGLGENFRAMEBUFFERSPROC          glGenFramebuffers          = nullptr;
+static PFNGLDELETEFRAMEBUFFERSPROC       glDeleteFramebuffers       = nullptr;
+static PFNGLBINDFRAMEBUFFERPROC          glBindFramebuffer          = nullptr;
+static PFNGLFRAMEBUFFERTEXTURE2DPROC     glFramebufferTexture2D     = nullptr;
+static PFNGLCHECKFRAMEBUFFERSTATUSPROC   glCheckFramebufferStatus   = nullptr;
+#if eng_PROFILE
+// timer queries: core 3.3 / ARB_timer_query, or EXT_disjoint_timer_query
+// on GLES (same signatures with EXT suffix), loaded only when supported
+static PFNGLGENQUERIESPROC          glGenQueries          = nullptr;
+static PFNGLDELETEQUERIESPROC       glDeleteQueries       = nullptr;
+static PFNGLBEGINQUERYPROC          glBeginQuery          = nullptr;
+static PFNGLENDQUERYPROC            glEndQuery            = nullptr;
+static PFNGLGETQUERYOBJECTIVPROC    glGetQueryObjectiv    = nullptr;
+static PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = nullptr;
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+#endif
 
 template <typename T>
 static void load_gl_func(const char* func_name, T& result)
@@ -58,35 +126,93 @@ static void load_gl_func(const char* func_name, T& result)
     result = reinterpret_cast<T>(gl_pointer);
 }
 
-#define eng_GL_CHECK()                                                          \
-    {                                                                          \
-        const unsigned int err = glGetError();                                 \
-        if (err != GL_NO_ERROR)                                                \
-        {                                                                      \
-            switch (err)                                                       \
-            {                                                                  \
-                case GL_INVALID_ENUM:                                          \
-                    std::cerr << "GL_INVALID_ENUM" << std::endl;               \
-                    break;                                                     \
-                case GL_INVALID_VALUE:                                         \
-                    std::cerr << "GL_INVALID_VALUE" << std::endl;              \
-                    break;                                                     \
-                case GL_INVALID_OPERATION:                                     \
-                    std::cerr << "GL_INVALID_OPERATION" << std::endl;          \
-                    break;                                                     \
-                case GL_INVALID_FRAMEBUFFER_OPERATION:                         \
-                    std::cerr << "GL_INVALID_FRAMEBUFFER_OPERATION"            \
-                              << std::endl;                                    \
-                    break;                                                     \
-                case GL_OUT_OF_MEMORY:                                         \
-                    std::cerr << "GL_OUT_OF_MEMORY" << std::endl;              \
-                    break;                                                     \
-            }                                                                  \
-            assert(false);                                                     \
-        }                                                                      \
+/// return false when context can't draw instanced
+static bool load_instancing(int gl_major, int gl_minor)
+{
+    std::string suffix;
+    if (gl_major * 10 + gl_minor < 33)
+    {
+        for (const char* vendor : { "ARB", "EXT", "ANGLE" })
+        {
+            if (SDL_GL_ExtensionSupported(
+                        (std::string("GL_") + vendor + "_instanced_arrays").c_str()))
+            {
+                suffix = vendor;
+                break;
+            }
+        }
+        if (suffix.empty())
+        {
+            return false;
+        }
+    }
+    try
+    {
+        load_gl_func(("glDrawArraysInstanced" + suffix).c_str(), glDrawArraysInstanced);
+        load_gl_func(("glVertexAttribDivisor" + suffix).c_str(), glVertexAttribDivisor);
+        load_gl_func(("glDrawElementsInstanced" + suffix).c_str(),
+                     glDrawElementsInstanced);
+    }
+    catch (std::exception&)
+    {
+        return false;
     }
+    return true;
+}
 
+/// return false when context can't render to textures
+static bool load_framebuffers(int gl_major, int gl_minor)
+{
+    std::string suffix;
+    if (gl_major * 10 + gl_minor < 30 &&
+        !SDL_GL_ExtensionSupported("GL_ARB_framebuffer_object"))
+    {
+        if (!SDL_GL_ExtensionSupported("GL_EXT_framebuffer_object"))
+        {
+            return false;
+        }
+        suffix = "EXT";
+    }
+    try
+    {
+        load_gl_func(("glGenFramebuffers" + suffix).c_str(), glGenFramebuffers);
+        load_gl_func(("glDeleteFramebuffers" + suffix).c_str(), glDeleteFramebuffers);
+        load_gl_func(("glBindFramebuffer" + suffix).c_str(), glBindFramebuffer);
+        load_gl_func(("glFramebufferTexture2D" + suffix).c_str(),
+                     glFramebufferTexture2D);
+        load_gl_func(("glCheckFramebufferStatus" + suffix).c_str(),
+                     glCheckFramebufferStatus);
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+    return true;
+}
 
+/// return false when context can't save and load program binaries
+static bool load_program_binary(int gl_major, int gl_minor)
+{
+    if (gl_major * 10 + gl_minor < 41 &&
+        !SDL_GL_ExtensionSupported("GL_ARB_get_program_binary"))
+    {
+        return false;
+    }
+    try
+    {
+        load_gl_func("glGetProgramBinary", glGetProgramBinary);
+        load_gl_func("glProgramBinary", glProgramBinary);
+        load_gl_func("glProgramParameteri", glProgramParameteri);
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+    // extension may be exposed with no formats (driver cache disabled)
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
 
 namespace eng
 {
@@ -94,508 +220,2628 @@ namespace eng
     texture::~texture()
     = default;
 
-    class texture_gl_es20 final : public texture {
+    /// remember what is bound in gl context and drop redundant calls
+    class gl_state
+    {
     public:
-        explicit texture_gl_es20(std::string_view path);
-        ~texture_gl_es20() override;
-
-        void bind() const
+        void use_program(GLuint program_id)
         {
-            glBindTexture(GL_TEXTURE_2D, tex_handl);
+            if (program == program_id)
+            {
+                ++current.program_skipped;
+                return;
+            }
+            glUseProgram(program_id);
             eng_GL_CHECK();
+            program = program_id;
+            ++current.program_changes;
         }
 
-        std::uint32_t get_width() const final { return width; }
-        std::uint32_t get_height() const final { return height; }
-
-    private:
-        std::string   file_path;
-        GLuint        tex_handl = 0;
-        std::uint32_t width     = 0;
-        std::uint32_t height    = 0;
-    };
-
-    class shader_gl_es20 {
-    public:
-        shader_gl_es20(
-                std::string_view vertex_src, std::string_view         fragment_src,
-                const std::vector<std::tuple<GLuint, const GLchar*>>& attributes)
+        void bind_texture(GLuint unit, GLuint texture_id)
         {
-            vert_shader = compile_shader(GL_VERTEX_SHADER, vertex_src);
-            frag_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_src);
-            if (vert_shader == 0 || frag_shader == 0)
+            assert(unit < textures.size());
+            if (textures[unit] == texture_id)
             {
-                throw std::runtime_error("can't compile shader");
+                ++current.texture_skipped;
+                return;
             }
-            program_id = link_shader_program(attributes);
-            if (program_id == 0)
+            if (active_unit != unit)
             {
-                throw std::runtime_error("can't link shader");
+                glActiveTextureMY(GL_TEXTURE0 + unit);
+                eng_GL_CHECK();
+                active_unit = unit;
             }
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            eng_GL_CHECK();
+            textures[unit] = texture_id;
+            ++current.texture_changes;
         }
 
-        void use() const
+        /// texture was bound to active unit without tracker (on creation)
+        void note_texture(GLuint texture_id) { textures[active_unit] = texture_id; }
+
+        /// texture is deleted, gl name may come back from glGenTextures
+        void forget_texture(GLuint texture_id)
         {
-            glUseProgram(program_id);
-            eng_GL_CHECK();
+            std::replace(textures.begin(), textures.end(), texture_id, GLuint(0));
         }
 
-        void set_uniform(std::string_view uniform_name, texture_gl_es20* texture)
+        void bind_array_buffer(GLuint buffer_id)
         {
-            assert(texture != nullptr);
-            const int location =
-                    glGetUniformLocation(program_id, uniform_name.data());
-            eng_GL_CHECK();
-            if (location == -1)
+            if (array_buffer == buffer_id)
             {
-                std::cerr << "can't get uniform location from shader\n";
-                throw std::runtime_error("can't get uniform location");
+                ++current.buffer_skipped;
+                return;
             }
-            unsigned int texture_unit = 0;
-            glActiveTextureMY(GL_TEXTURE0 + texture_unit);
+            glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
             eng_GL_CHECK();
+            array_buffer = buffer_id;
+            ++current.buffer_changes;
+        }
 
-            texture->bind();
-
-            glUniform1i(location, static_cast<int>(0 + texture_unit));
+        /// without vertex array objects binding is global, like array buffer
+        void bind_element_buffer(GLuint buffer_id)
+        {
+            if (element_buffer == buffer_id)
+            {
+                ++current.buffer_skipped;
+                return;
+            }
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_id);
             eng_GL_CHECK();
+            element_buffer = buffer_id;
+            ++current.buffer_changes;
         }
 
-        void set_uniform(std::string_view uniform_name, const color& c)
+        /// buffer is deleted, gl name may come back from glGenBuffers
+        void forget_buffer(GLuint buffer_id)
         {
-            const int location =
-                    glGetUniformLocation(program_id, uniform_name.data());
-            eng_GL_CHECK();
-            if (location == -1)
+            if (array_buffer == buffer_id)
             {
-                std::cerr << "can't get uniform location from shader\n";
-                throw std::runtime_error("can't get uniform location");
+                array_buffer = 0;
+            }
+            if (element_buffer == buffer_id)
+            {
+                element_buffer = 0;
             }
-            float values[4] = { c.get_r(), c.get_g(), c.get_b(), c.get_a() };
-            glUniform4fv(location, 1, &values[0]);
-            eng_GL_CHECK();
         }
-        void set_uniform(std::string_view uniform_name, const mat2x3& m)
+
+        void count_vertex_bytes(std::size_t bytes) { current.vertex_bytes += bytes; }
+
+        /// enable exactly arrays from mask, touch only changed ones
+        void enable_attribs(std::uint32_t mask)
         {
-            const int location =
-                    glGetUniformLocation(program_id, uniform_name.data());
-            eng_GL_CHECK();
-            if (location == -1)
+            std::uint32_t changed = mask ^ attribs;
+            if (changed == 0)
             {
-                std::cerr << "can't get uniform location from shader\n";
-                throw std::runtime_error("can't get uniform location");
+                ++current.attrib_skipped;
+                return;
             }
-            // OpenGL wants matrix in column major order
-            // clang-format off
-            float values[9] = { m.row1.x,  m.row2.x, m.delta.x,
-                                m.row1.y, m.row2.y, m.delta.y,
-                                0.f,      0.f,       1.f };
-            // clang-format on
-            glUniformMatrix3fv(location, 1, GL_FALSE, &values[0]);
-            eng_GL_CHECK();
+            for (GLuint index = 0; changed != 0; ++index, changed >>= 1)
+            {
+                if ((changed & 1) == 0)
+                {
+                    continue;
+                }
+                if (mask & (1u << index))
+                {
+                    glEnableVertexAttribArray(index);
+                }
+                else
+                {
+                    glDisableVertexAttribArray(index);
+                }
+                eng_GL_CHECK();
+                ++current.attrib_changes;
+            }
+            attribs = mask;
         }
 
-    private:
-        GLuint compile_shader(GLenum shader_type, std::string_view src)
+        void count_uniform(bool skipped)
         {
-            GLuint shader_id = glCreateShader(shader_type);
-            eng_GL_CHECK();
-            std::string_view vertex_shader_src = src;
-            const char*      source            = vertex_shader_src.data();
-            glShaderSource(shader_id, 1, &source, nullptr);
-            eng_GL_CHECK();
+            ++(skipped ? current.uniform_skipped : current.uniform_changes);
+        }
 
-            glCompileShader(shader_id);
-            eng_GL_CHECK();
+        void end_frame()
+        {
+            last_frame = current;
+            current    = state_stats();
+        }
 
-            GLint compiled_status = 0;
-            glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled_status);
+        const state_stats& get_last_frame() const { return last_frame; }
+
+    private:
+        // gl defaults after context creation
+        GLuint                program     = 0;
+        GLuint                active_unit = 0;
+        std::array<GLuint, 8> textures{};
+        std::uint32_t         attribs        = 0;
+        GLuint                array_buffer   = 0;
+        GLuint                element_buffer = 0;
+
+        state_stats current;
+        state_stats last_frame;
+    };
+
+#if eng_PROFILE
+    /// GL_TIME_ELAPSED queries around gl work of a frame. Results are
+    /// read frames later, only when ready, so the cpu never waits on gpu.
+    /// Elapsed queries can't nest: begin/end spans follow each other
+    class gpu_timer
+    {
+    public:
+        /// return false and stay inactive when context has no timer queries
+        bool initialize(int gl_major, int gl_minor)
+        {
+            const char* suffix = "";
+            if (gl_major * 10 + gl_minor < 33 &&
+                !SDL_GL_ExtensionSupported("GL_ARB_timer_query"))
+            {
+                if (!SDL_GL_ExtensionSupported("GL_EXT_disjoint_timer_query"))
+                {
+                    return false;
+                }
+                suffix         = "EXT";
+                check_disjoint = true;
+            }
+            try
+            {
+                load_gl_func((std::string("glGenQueries") + suffix).c_str(),
+                             glGenQueries);
+                load_gl_func((std::string("glDeleteQueries") + suffix).c_str(),
+                             glDeleteQueries);
+                load_gl_func((std::string("glBeginQuery") + suffix).c_str(),
+                             glBeginQuery);
+                load_gl_func((std::string("glEndQuery") + suffix).c_str(),
+                             glEndQuery);
+                load_gl_func((std::string("glGetQueryObjectiv") + suffix).c_str(),
+                             glGetQueryObjectiv);
+                load_gl_func((std::string("glGetQueryObjectui64v") + suffix).c_str(),
+                             glGetQueryObjectui64v);
+            }
+            catch (const std::exception& ex)
+            {
+                eng_LOG(warn, gl, "profile: no gpu timers, {}", ex.what());
+                return false;
+            }
+            GLuint names[slot_count];
+            glGenQueries(slot_count, names);
             eng_GL_CHECK();
-            if (compiled_status == 0)
+            for (std::size_t i = 0; i < slot_count; ++i)
             {
-                GLint info_len = 0;
-                glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_len);
-                eng_GL_CHECK();
-                std::vector<char> info_chars(static_cast<size_t>(info_len));
-                glGetShaderInfoLog(shader_id, info_len, nullptr, info_chars.data());
-                eng_GL_CHECK();
-                glDeleteShader(shader_id);
-                eng_GL_CHECK();
-
-                std::string shader_type_name =
-                        shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment";
-                std::cerr << "Error compiling shader(vertex)\n"
-                          << vertex_shader_src << "\n"
-                          << info_chars.data();
-                return 0;
+                slots[i].query = names[i];
             }
-            return shader_id;
+            active = true;
+            return true;
         }
-        GLuint link_shader_program(
-                const std::vector<std::tuple<GLuint, const GLchar*>>& attributes)
+        void uninitialize()
         {
-            GLuint program_id_ = glCreateProgram();
-            eng_GL_CHECK();
-            if (0 == program_id_)
+            if (!active)
             {
-                std::cerr << "failed to create gl program";
-                throw std::runtime_error("can't link shader");
+                return;
+            }
+            end();
+            for (slot& s : slots)
+            {
+                glDeleteQueries(1, &s.query);
             }
-
-            glAttachShader(program_id_, vert_shader);
-            eng_GL_CHECK();
-            glAttachShader(program_id_, frag_shader);
             eng_GL_CHECK();
+            active = false;
+        }
 
-            // bind attribute location
-            for (const auto& attr : attributes)
+        /// name must be string literal, span is skipped if all slots wait
+        void begin(const char* name)
+        {
+            if (!active || running != nullptr)
             {
-                GLuint        loc  = std::get<0>(attr);
-                const GLchar* name = std::get<1>(attr);
-                glBindAttribLocation(program_id_, loc, name);
-                eng_GL_CHECK();
+                return;
             }
-
-            // link program after binding attribute locations
-            glLinkProgram(program_id_);
-            eng_GL_CHECK();
-            // Check the link status
-            GLint linked_status = 0;
-            glGetProgramiv(program_id_, GL_LINK_STATUS, &linked_status);
-            eng_GL_CHECK();
-            if (linked_status == 0)
+            slot& s = slots[next];
+            if (s.pending)
             {
-                GLint infoLen = 0;
-                glGetProgramiv(program_id_, GL_INFO_LOG_LENGTH, &infoLen);
-                eng_GL_CHECK();
-                std::vector<char> infoLog(static_cast<size_t>(infoLen));
-                glGetProgramInfoLog(program_id_, infoLen, nullptr, infoLog.data());
-                eng_GL_CHECK();
-                std::cerr << "Error linking program:\n" << infoLog.data();
-                glDeleteProgram(program_id_);
-                eng_GL_CHECK();
-                return 0;
+                return;
             }
-            return program_id_;
+            next = (next + 1) % slot_count;
+            glBeginQuery(GL_TIME_ELAPSED, s.query);
+            eng_GL_CHECK();
+            s.name      = name;
+            s.cpu_begin = profile_now_ns();
+            s.pending   = true;
+            running     = &s;
         }
-
-        GLuint vert_shader = 0;
-        GLuint frag_shader = 0;
-        GLuint program_id  = 0;
-    };
-
-    static std::array<std::string_view, 17> event_names = {
-            /// input events
-            { "left_pressed", "left_released", "right_pressed", "right_released",
-                    "up_pressed", "up_released", "down_pressed", "down_released",
-                    "select_pressed", "select_released", "start_pressed", "start_released",
-                    "button1_pressed", "button1_released", "button2_pressed",
-                    "button2_released",
-                    /// virtual console events
-                    "turn_off" }
-    };
-
-    std::ostream& operator<<(std::ostream& stream, const event e) {
-        auto value   = static_cast<std::uint32_t>(e);
-        auto minimal = static_cast<std::uint32_t>(event::left_pressed);
-        auto maximal = static_cast<std::uint32_t>(event::turn_off);
-        if (value >= minimal && value <= maximal)
+        void end()
         {
-            stream << event_names[value];
-            return stream;
+            if (running == nullptr)
+            {
+                return;
+            }
+            glEndQuery(GL_TIME_ELAPSED);
+            eng_GL_CHECK();
+            running = nullptr;
         }
-        else
+        /// pass finished spans to profiler
+        void collect()
         {
-            throw std::runtime_error("too big event value");
+            if (!active)
+            {
+                return;
+            }
+            GLint disjoint = 0;
+            if (check_disjoint)
+            {
+                // clock changed (power state, overflow): results are garbage
+                glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+            }
+            for (slot& s : slots)
+            {
+                if (!s.pending || &s == running)
+                {
+                    continue;
+                }
+                GLint available = 0;
+                glGetQueryObjectiv(s.query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available == 0)
+                {
+                    continue;
+                }
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(s.query, GL_QUERY_RESULT, &elapsed);
+                if (disjoint == 0)
+                {
+                    profile_record_gpu(s.name, s.cpu_begin, elapsed);
+                }
+                s.pending = false;
+            }
+            eng_GL_CHECK();
         }
-    }
-
-    tri0::tri0()
-            : v{ v0(), v0(), v0() }
-    {
-    }
 
-    tri1::tri1()
-            : v{ v1(), v1(), v1() }
+    private:
+        static constexpr std::size_t slot_count = 8;
+        struct slot
+        {
+            GLuint        query     = 0;
+            const char*   name      = nullptr;
+            std::uint64_t cpu_begin = 0;
+            bool          pending   = false;
+        };
+
+        std::array<slot, slot_count> slots;
+        std::size_t                  next           = 0;
+        slot*                        running        = nullptr;
+        bool                         active         = false;
+        bool                         check_disjoint = false;
+    };
+#else
+    /// profiling compiled out: calls vanish
+    class gpu_timer
     {
-    }
+    public:
+        bool initialize(int, int) { return false; }
+        void uninitialize() {}
+        void begin(const char*) {}
+        void end() {}
+        void collect() {}
+    };
+#endif
 
-    tri2::tri2()
-            : v{ v2(), v2(), v2() }
+    /// offset into bound GL_ARRAY_BUFFER where glVertexAttribPointer
+    /// expects pointer
+    static const void* buffer_offset(std::size_t offset)
     {
+        return reinterpret_cast<const void*>(offset);
     }
 
-    std::ostream& operator<<(std::ostream& out, const SDL_version& v)
+    constexpr GLenum gl_type(attrib_type type)
     {
-        out << static_cast<int>(v.major) << '.';
-        out << static_cast<int>(v.minor) << '.';
-        out << static_cast<int>(v.patch);
-        return out;
+        switch (type)
+        {
+            case attrib_type::float32:
+                return GL_FLOAT;
+            case attrib_type::unorm8:
+                return GL_UNSIGNED_BYTE;
+            case attrib_type::snorm16:
+                return GL_SHORT;
+            case attrib_type::unorm16:
+                return GL_UNSIGNED_SHORT;
+        }
+        return GL_FLOAT;
     }
 
-    std::istream& operator>>(std::istream& is, color& c)
+    /// attribute pointers for array of V at offset of bound GL_ARRAY_BUFFER
+    template <typename V>
+    static void set_attribs(std::size_t offset)
     {
-        float r = 0.f;
-        float g = 0.f;
-        float b = 0.f;
-        float a = 0.f;
-        is >> r;
-        is >> g;
-        is >> b;
-        is >> a;
-        c = color(r, g, b, a);
-        return is;
+        for (const vertex_attrib& a : vertex_layout<V>::attribs)
+        {
+            glVertexAttribPointer(a.location, a.components, gl_type(a.type),
+                                  a.type == attrib_type::float32 ? GL_FALSE : GL_TRUE,
+                                  sizeof(V), buffer_offset(offset + a.offset));
+            eng_GL_CHECK();
+        }
     }
 
-    std::istream& operator>>(std::istream& is, v0& v)
+    /// vertexes of draws from client memory: one GL_ARRAY_BUFFER used as
+    /// ring, every write goes right after previous one, so vertexes of a
+    /// frame are one contiguous range of one buffer.
+    /// With map_buffer_range and sync objects writes are unsynchronized
+    /// maps, a fence per frame tells which part of ring gpu is done with.
+    /// Without them, or when one frame outgrows ring, buffer is orphaned:
+    /// driver gives fresh storage, old one lives until its draws finish
+    class stream_buffer
     {
-        is >> v.p.x;
-        is >> v.p.y;
+    public:
+        void initialize(gl_state& state_, std::size_t capacity_, int gl_major,
+                        int gl_minor)
+        {
+            state    = &state_;
+            capacity = (capacity_ + alignment - 1) & ~(alignment - 1);
+            synced   = gl_major * 10 + gl_minor >= 32 ||
+                     (SDL_GL_ExtensionSupported("GL_ARB_map_buffer_range") &&
+                      SDL_GL_ExtensionSupported("GL_ARB_sync"));
+            if (synced)
+            {
+                try
+                {
+                    load_gl_func("glMapBufferRange", glMapBufferRange);
+                    load_gl_func("glFenceSync", glFenceSync);
+                    load_gl_func("glClientWaitSync", glClientWaitSync);
+                    load_gl_func("glDeleteSync", glDeleteSync);
+                }
+                catch (std::exception&)
+                {
+                    synced = false;
+                }
+            }
+            glGenBuffers(1, &buffer);
+            eng_GL_CHECK();
+            orphan();
+        }
 
-        return is;
-    }
+        void uninitialize()
+        {
+            drop_fences();
+            state->forget_buffer(buffer);
+            glDeleteBuffers(1, &buffer);
+            eng_GL_CHECK();
+            buffer = 0;
+        }
 
-    std::istream& operator>>(std::istream& is, v1& v)
-    {
-        is >> v.p.x;
-        is >> v.p.y;
-        is >> v.c;
-        return is;
-    }
+        bool is_synced() const { return synced; }
 
-    std::istream& operator>>(std::istream& is, v2& v)
-    {
-        is >> v.p.x;
-        is >> v.p.y;
-        is >> v.t_p.x;
-        is >> v.t_p.y;
-        is >> v.c;
-        return is;
-    }
+        /// make room for next writes of size bytes in total: a wrap or
+        /// orphan between writes of one draw would lose earlier ones
+        void reserve(std::size_t size)
+        {
+            state->bind_array_buffer(buffer);
+            head = (head + alignment - 1) & ~std::uint64_t(alignment - 1);
+            const std::size_t offset = head % capacity;
+            if (size > capacity - offset)
+            {
+                if (size > capacity)
+                {
+                    capacity = (std::max(size, capacity * 2) + alignment - 1) &
+                               ~(alignment - 1);
+                    orphan();
+                }
+                else if (synced)
+                {
+                    // next lap, tail of ring stays unused
+                    head += capacity - offset;
+                }
+                else
+                {
+                    orphan();
+                }
+            }
+            if (synced && !wait_free(head + size))
+            {
+                orphan();
+            }
+        }
 
-    std::istream& operator>>(std::istream& is, tri0& t)
-    {
-        is >> t.v[0];
-        is >> t.v[1];
-        is >> t.v[2];
-        return is;
-    }
+        /// copy bytes into ring, return their offset in buffer, which is
+        /// left bound to GL_ARRAY_BUFFER. Indexes go into same ring, see
+        /// bind_indexes
+        std::size_t write(const void* data, std::size_t size)
+        {
+            reserve(size);
+            const std::size_t offset = head % capacity;
+            upload(offset, data, size);
+            head += size;
+            state->count_vertex_bytes(size);
+            return offset;
+        }
 
-    std::istream& operator>>(std::istream& is, tri1& t)
-    {
-        is >> t.v[0];
-        is >> t.v[1];
-        is >> t.v[2];
-        return is;
-    }
+        /// next indexed draw reads its indexes from ring
+        void bind_indexes() { state->bind_element_buffer(buffer); }
 
-    std::istream& operator>>(std::istream& is, tri2& t)
-    {
-        is >> t.v[0];
-        is >> t.v[1];
-        is >> t.v[2];
-        return is;
-    }
+        /// reserve for parts of one draw written one after another
+        static std::size_t reserve_size(std::initializer_list<std::size_t> parts)
+        {
+            std::size_t size = 0;
+            for (std::size_t part : parts)
+            {
+                size += part + alignment;
+            }
+            return size;
+        }
 
-    struct bind
-    {
-        bind(std::string_view s, SDL_Keycode k, event pressed, event released)
-                : name(s)
-                , key(k)
-                , event_pressed(pressed)
-                , event_released(released)
+        /// fence draws of this frame, forget fences gpu already passed
+        void end_frame()
         {
+            if (!synced)
+            {
+                return;
+            }
+            if (head != fenced)
+            {
+                fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), head });
+                eng_GL_CHECK();
+                fenced = head;
+            }
+            while (!fences.empty())
+            {
+                const GLenum status = glClientWaitSync(fences.front().sync, 0, 0);
+                eng_GL_CHECK();
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                {
+                    break;
+                }
+                consumed = fences.front().position;
+                glDeleteSync(fences.front().sync);
+                eng_GL_CHECK();
+                fences.pop_front();
+            }
         }
 
-        std::string_view name;
-        SDL_Keycode      key;
+    private:
+        /// every write starts aligned for any attribute type
+        static constexpr std::size_t alignment = 16;
 
-        event event_pressed;
-        event event_released;
-    };
+        struct frame_fence
+        {
+            GLsync        sync;
+            /// gpu is done with everything written before this position
+            std::uint64_t position;
+        };
+
+        /// wait until gpu is done with what ring held one lap before in
+        /// [head, end); false when that data is not fenced yet (current
+        /// frame came around whole ring)
+        bool wait_free(std::uint64_t end)
+        {
+            if (end <= capacity)
+            {
+                return true;
+            }
+            const std::uint64_t needed = end - capacity;
+            while (consumed < needed)
+            {
+                if (fences.empty())
+                {
+                    return false;
+                }
+                const frame_fence f = fences.front();
+                fences.pop_front();
+                if (f.position >= needed)
+                {
+                    // fences signal in order, earlier ones are passed too
+                    GLenum status = GL_TIMEOUT_EXPIRED;
+                    while (status == GL_TIMEOUT_EXPIRED)
+                    {
+                        status = glClientWaitSync(f.sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                  1000000);
+                        eng_GL_CHECK();
+                    }
+                }
+                consumed = f.position;
+                glDeleteSync(f.sync);
+                eng_GL_CHECK();
+            }
+            return true;
+        }
+
+        void upload(std::size_t offset, const void* data, std::size_t size)
+        {
+            if (synced)
+            {
+                void* mapped = glMapBufferRange(
+                        GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                        static_cast<GLsizeiptr>(size),
+                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                GL_MAP_UNSYNCHRONIZED_BIT);
+                eng_GL_CHECK();
+                if (mapped != nullptr)
+                {
+                    std::memcpy(mapped, data, size);
+                    const GLboolean intact = glUnmapBuffer(GL_ARRAY_BUFFER);
+                    eng_GL_CHECK();
+                    if (intact == GL_TRUE)
+                    {
+                        return;
+                    }
+                }
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset),
+                            static_cast<GLsizeiptr>(size), data);
+            eng_GL_CHECK();
+        }
+
+        /// fresh storage, draws still reading old one are not waited for
+        void orphan()
+        {
+            state->bind_array_buffer(buffer);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr,
+                         GL_STREAM_DRAW);
+            eng_GL_CHECK();
+            drop_fences();
+            head     = 0;
+            fenced   = 0;
+            consumed = 0;
+        }
+
+        void drop_fences()
+        {
+            for (const frame_fence& f : fences)
+            {
+                glDeleteSync(f.sync);
+                eng_GL_CHECK();
+            }
+            fences.clear();
+        }
 
-    const std::array<bind, 8> keys{
-            { bind{ "up", SDLK_w, event::up_pressed, event::up_released },
-                    bind{ "left", SDLK_a, event::left_pressed, event::left_released },
-                    bind{ "down", SDLK_s, event::down_pressed, event::down_released },
-                    bind{ "right", SDLK_d, event::right_pressed, event::right_released },
-                    bind{ "button1", SDLK_LCTRL, event::button1_pressed,
-                          event::button1_released },
-                    bind{ "button2", SDLK_SPACE, event::button2_pressed,
-                          event::button2_released },
-                    bind{ "select", SDLK_ESCAPE, event::select_pressed,
-                          event::select_released },
-                    bind{ "start", SDLK_RETURN, event::start_pressed,
-                          event::start_released } }
+        gl_state*   state    = nullptr;
+        GLuint      buffer   = 0;
+        std::size_t capacity = 0;
+        bool        synced   = false;
+        // positions count bytes written since last orphan, ring offset is
+        // position % capacity
+        std::uint64_t           head     = 0;
+        std::uint64_t           fenced   = 0;
+        std::uint64_t           consumed = 0;
+        std::deque<frame_fence> fences;
     };
 
-    static bool check_input(const SDL_Event& e, const bind*& result) {
-        using namespace std;
+    /// glReadPixels into pixel pack buffers, copied out frames later when
+    /// gpu is done with them, so neither side waits. Fences tell when copy
+    /// is done; without sync objects it is taken as done slot_count - 1
+    /// swaps later, when mapping it seldom stalls. Slots are used as ring,
+    /// readbacks finish in request order
+    class readback_ring
+    {
+    public:
+        static constexpr std::size_t slot_count = 3;
+
+        void initialize(bool synced_)
+        {
+            synced = synced_;
+            for (slot& s : slots)
+            {
+                glGenBuffers(1, &s.buffer);
+                eng_GL_CHECK();
+            }
+        }
 
-        const auto it = find_if(begin(keys), end(keys), [&](const bind& b) {
-            return b.key == e.key.keysym.sym;
-        });
+        void uninitialize()
+        {
+            for (slot& s : slots)
+            {
+                if (s.fence != nullptr)
+                {
+                    glDeleteSync(s.fence);
+                    eng_GL_CHECK();
+                    s.fence = nullptr;
+                }
+                glDeleteBuffers(1, &s.buffer);
+                eng_GL_CHECK();
+            }
+            used = 0;
+        }
 
-        if (it != end(keys))
+        /// start copy of bound framebuffer, false when all slots wait
+        bool request(std::uint32_t width, std::uint32_t height, std::uint64_t frame)
         {
-            result = &(*it);
+            if (used == slot_count)
+            {
+                return false;
+            }
+            slot&             s    = slots[(first + used) % slot_count];
+            const std::size_t size = std::size_t(width) * height * 4;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.buffer);
+            eng_GL_CHECK();
+            if (s.capacity < size)
+            {
+                glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size),
+                             nullptr, GL_STREAM_READ);
+                eng_GL_CHECK();
+                s.capacity = size;
+            }
+            // rgba rows are 4 byte aligned, default pack alignment fits
+            glReadPixels(0, 0, static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            eng_GL_CHECK();
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            eng_GL_CHECK();
+            if (synced)
+            {
+                s.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                eng_GL_CHECK();
+            }
+            s.width  = width;
+            s.height = height;
+            s.frame  = frame;
+            ++used;
             return true;
         }
-        return false;
-    }
 
-    class engine_impl final : public engine {
+        /// copy out oldest readback if gpu is done with it; slot that can't
+        /// be mapped is given back with empty pixels
+        bool poll(pixel_readback& out, std::uint64_t frame)
+        {
+            if (used == 0)
+            {
+                return false;
+            }
+            slot& s = slots[first];
+            if (synced)
+            {
+                const GLenum status =
+                        glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                eng_GL_CHECK();
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                {
+                    return false;
+                }
+                glDeleteSync(s.fence);
+                eng_GL_CHECK();
+                s.fence = nullptr;
+            }
+            else if (frame < s.frame + slot_count - 1)
+            {
+                return false;
+            }
+            first = (first + 1) % slot_count;
+            --used;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s.buffer);
+            eng_GL_CHECK();
+            const auto* data = static_cast<const std::uint8_t*>(
+                    glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+            eng_GL_CHECK();
+            out.width  = s.width;
+            out.height = s.height;
+            out.frame  = s.frame;
+            if (data != nullptr)
+            {
+                // gl rows start at bottom
+                const std::size_t row = std::size_t(s.width) * 4;
+                out.pixels.resize(row * s.height);
+                for (std::uint32_t y = 0; y < s.height; ++y)
+                {
+                    std::memcpy(&out.pixels[row * y], data + row * (s.height - 1 - y),
+                                row);
+                }
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                eng_GL_CHECK();
+            }
+            else
+            {
+                // slot is free again anyway, caller must not wait for it
+                eng_LOG(error, gl, "can't map readback buffer of frame {}", s.frame);
+                out.pixels.clear();
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            eng_GL_CHECK();
+            return true;
+        }
+
+    private:
+        struct slot
+        {
+            GLuint        buffer   = 0;
+            std::size_t   capacity = 0;
+            GLsync        fence    = nullptr;
+            std::uint32_t width    = 0;
+            std::uint32_t height   = 0;
+            std::uint64_t frame    = 0;
+        };
+
+        std::array<slot, slot_count> slots;
+        std::size_t                  first  = 0;
+        std::size_t                  used   = 0;
+        bool                         synced = false;
+    };
+
+    vertex_buffer::~vertex_buffer()
+    = default;
+
+    render_target::~render_target()
+    = default;
+
+    /// static GL_ARRAY_BUFFER, packed when vertexes fit v2_packed, and
+    /// GL_ELEMENT_ARRAY_BUFFER for meshes; cpu copy expands instances
+    /// when context can't draw instanced
+    class vertex_buffer_gl final : public vertex_buffer
+    {
     public:
-        /// create main window
-        /// on success return empty string
-        std::string initialize(std::string_view /*config*/) final;
-        /// return seconds from initialization
-        float get_time_from_init() final
+        vertex_buffer_gl(gl_state& state, const tri2* tris_, std::size_t count,
+                         bool allow_packed)
+            : tris(tris_, tris_ + count)
         {
-            std::uint32_t ms_from_library_initialization = SDL_GetTicks();
-            float         seconds = ms_from_library_initialization * 0.001f;
-            return seconds;
+            // empty buffer is allowed, it draws nothing
+            upload_vertexes(state, tris.empty() ? nullptr : tris[0].v, count * 3,
+                            allow_packed);
         }
-        /// pool event from input queue
-        /// return true if more events in queue
-        bool read_input(event& e) final
+        vertex_buffer_gl(gl_state& state, const mesh& m, bool allow_packed)
+            : tris(m.indexes.size() / 3)
+            , index_count(m.indexes.size())
+        {
+            for (std::size_t i = 0; i < tris.size() * 3; ++i)
+            {
+                tris[i / 3].v[i % 3] = m.vertexes[m.indexes[i]];
+            }
+            upload_vertexes(state, m.vertexes.data(), m.vertexes.size(), allow_packed);
+            glGenBuffers(1, &index_id);
+            eng_GL_CHECK();
+            state.bind_element_buffer(index_id);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         static_cast<GLsizeiptr>(index_count * sizeof(std::uint16_t)),
+                         m.indexes.data(), GL_STATIC_DRAW);
+            eng_GL_CHECK();
+        }
+
+        /// attribute pointers from this buffer, return position scale
+        float set_attribs() const
         {
-            using namespace std;
-            // collect all events from SDL
-            SDL_Event sdl_event{};
-            if (SDL_PollEvent(&sdl_event))
+            if (packed)
             {
-                const bind* binding = nullptr;
+                eng::set_attribs<v2_packed>(0);
+                return packed_position_range;
+            }
+            eng::set_attribs<v2>(0);
+            return 1.f;
+        }
 
-                if (sdl_event.type == SDL_QUIT)
-                {
-                    e = event::turn_off;
-                    return true;
-                }
-                else if (sdl_event.type == SDL_KEYDOWN)
+        /// draw with attributes set, instance_count 0 draws without
+        /// instancing
+        void draw(gl_state& state, std::size_t instance_count) const
+        {
+            const auto count = static_cast<GLsizei>(size());
+            const auto n     = static_cast<GLsizei>(instance_count);
+            if (index_id == 0)
+            {
+                if (instance_count == 0)
                 {
-                    if (check_input(sdl_event, binding))
-                    {
-                        e = binding->event_pressed;
-                        return true;
-                    }
+                    glDrawArrays(GL_TRIANGLES, 0, count);
                 }
-                else if (sdl_event.type == SDL_KEYUP)
+                else
                 {
-                    if (check_input(sdl_event, binding))
-                    {
-                        e = binding->event_released;
-                        return true;
-                    }
+                    glDrawArraysInstanced(GL_TRIANGLES, 0, count, n);
                 }
+                eng_GL_CHECK();
+                return;
             }
-            return false;
+            state.bind_element_buffer(index_id);
+            if (instance_count == 0)
+            {
+                glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr);
+            }
+            else
+            {
+                glDrawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, nullptr,
+                                        n);
+            }
+            eng_GL_CHECK();
+        }
+
+        ~vertex_buffer_gl() override
+        {
+            glDeleteBuffers(1, &id);
+            eng_GL_CHECK();
+            if (index_id != 0)
+            {
+                glDeleteBuffers(1, &index_id);
+                eng_GL_CHECK();
+            }
+        }
+
+        std::size_t size() const final
+        {
+            return index_id != 0 ? index_count : tris.size() * 3;
+        }
+
+        GLuint            id       = 0;
+        GLuint            index_id = 0;
+        std::vector<tri2> tris;
+        std::size_t       index_count = 0;
+        bool              packed      = false;
+
+    private:
+        void upload_vertexes(gl_state& state, const v2* vertexes, std::size_t count,
+                             bool allow_packed)
+        {
+            glGenBuffers(1, &id);
+            eng_GL_CHECK();
+            state.bind_array_buffer(id);
+            std::vector<v2_packed> packed_vertexes(count);
+            packed = allow_packed &&
+                     pack_vertexes(vertexes, packed_vertexes.data(), count);
+            if (packed)
+            {
+                glBufferData(GL_ARRAY_BUFFER,
+                             static_cast<GLsizeiptr>(count * sizeof(v2_packed)),
+                             packed_vertexes.data(), GL_STATIC_DRAW);
+            }
+            else
+            {
+                glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(count * sizeof(v2)),
+                             vertexes, GL_STATIC_DRAW);
+            }
+            eng_GL_CHECK();
+        }
+    };
+
+    class texture_gl_es20 final : public texture {
+    public:
+        explicit texture_gl_es20(std::string_view path);
+        /// async load, pixels come later through upload_step
+        texture_gl_es20(std::shared_ptr<texture_request> request,
+                        GLuint                           placeholder);
+        /// transparent atlas page, images are pasted in later
+        texture_gl_es20(std::uint32_t width, std::uint32_t height);
+        ~texture_gl_es20() override;
+
+        /// placeholder until async load is fully uploaded
+        GLuint get_handle() const
+        {
+            return status == texture_state::ready ? tex_handl : placeholder;
+        }
+
+        /// own gl name, 0 until async load creates storage
+        GLuint get_storage() const { return tex_handl; }
+
+        std::uint32_t get_width() const final { return width; }
+        std::uint32_t get_height() const final { return height; }
+        texture_state get_state() const final { return status; }
+
+        /// upload next rows of decoded image, budget bytes or one row
+        /// at least, and take them from budget
+        /// return true when done (ready or failed)
+        bool upload_step(gl_state& state, std::size_t& budget);
+
+        /// copy img into texture with top left corner at x, y
+        void paste(gl_state& state, const image& img, std::uint32_t x,
+                   std::uint32_t y);
+
+    private:
+        std::string   file_path;
+        GLuint        tex_handl = 0;
+        GLuint        placeholder = 0;
+        std::uint32_t width     = 0;
+        std::uint32_t height    = 0;
+        texture_state status    = texture_state::ready;
+
+        std::shared_ptr<texture_request> request;
+        std::uint32_t                    uploaded_rows = 0;
+    };
+
+    /// image placed into atlas page, draws through page texture
+    class atlas_texture_gl final : public texture
+    {
+    public:
+        atlas_texture_gl(texture_gl_es20* page_, const uv_remap& remap_,
+                         std::uint32_t width_, std::uint32_t height_)
+            : page(page_)
+            , remap(remap_)
+            , width(width_)
+            , height(height_)
+        {
+        }
+        /// async load, draws through transparent placeholder page until
+        /// engine places decoded image (see place)
+        atlas_texture_gl(std::shared_ptr<texture_request> request_,
+                         texture_gl_es20*                 placeholder)
+            : page(placeholder)
+            , request(std::move(request_))
+            , status(texture_state::loading)
+        {
+        }
+        ~atlas_texture_gl() override
+        {
+            if (request)
+            {
+                request->cancelled = true;
+            }
+        }
+
+        std::uint32_t get_width() const final { return width; }
+        std::uint32_t get_height() const final { return height; }
+        texture_state get_state() const final { return status; }
+
+        /// decoded image went into page at remap
+        void place(texture_gl_es20* page_, const uv_remap& remap_)
+        {
+            page   = page_;
+            remap  = remap_;
+            width  = request->img.width;
+            height = request->img.height;
+            status = texture_state::ready;
+            request.reset(); // frees decoded pixels
+        }
+        void fail()
+        {
+            eng_LOG(error, texture, "{}: {}", request->path, request->error);
+            status = texture_state::failed;
+            request.reset();
+        }
+
+        texture_gl_es20* page;
+        uv_remap         remap;
+        /// set while async load is in flight
+        std::shared_ptr<texture_request> request;
+
+    private:
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+        texture_state status = texture_state::ready;
+    };
+
+    /// framebuffer object with texture as its color attachment
+    class render_target_gl final : public render_target
+    {
+    public:
+        /// bound: framebuffer to bind back after setup
+        render_target_gl(gl_state& state, std::uint32_t width, std::uint32_t height,
+                         GLuint bound)
+            : color(width, height)
+        {
+            // constructor binds texture to active unit directly
+            state.note_texture(color.get_storage());
+            glGenFramebuffers(1, &fbo);
+            eng_GL_CHECK();
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            eng_GL_CHECK();
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                                   color.get_storage(), 0);
+            eng_GL_CHECK();
+            const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            eng_GL_CHECK();
+            glBindFramebuffer(GL_FRAMEBUFFER, bound);
+            eng_GL_CHECK();
+            if (status != GL_FRAMEBUFFER_COMPLETE)
+            {
+                glDeleteFramebuffers(1, &fbo);
+                eng_GL_CHECK();
+                state.forget_texture(color.get_storage());
+                throw std::runtime_error("render target framebuffer incomplete: " +
+                                         std::to_string(status));
+            }
+        }
+        ~render_target_gl() override
+        {
+            glDeleteFramebuffers(1, &fbo);
+            eng_GL_CHECK();
+        }
+
+        texture* get_texture() final { return &color; }
+
+        texture_gl_es20 color;
+        GLuint          fbo = 0;
+    };
+
+    /// handle of reflected uniform, T is type of value it accepts
+    template <typename T>
+    struct uniform
+    {
+        std::size_t index = 0;
+    };
+
+    template <typename T>
+    constexpr GLenum uniform_gl_type();
+    template <>
+    constexpr GLenum uniform_gl_type<texture_gl_es20*>()
+    {
+        return GL_SAMPLER_2D;
+    }
+    template <>
+    constexpr GLenum uniform_gl_type<color>()
+    {
+        return GL_FLOAT_VEC4;
+    }
+    template <>
+    constexpr GLenum uniform_gl_type<mat2x3>()
+    {
+        return GL_FLOAT_MAT3;
+    }
+    template <>
+    constexpr GLenum uniform_gl_type<float>()
+    {
+        return GL_FLOAT;
+    }
+
+    class shader_gl_es20 {
+    public:
+        /// cache not null: take program binary from it when driver
+        /// accepts one, else compile and store result
+        shader_gl_es20(
+                gl_state& state_, std::string_view vertex_src,
+                std::string_view                                      fragment_src,
+                const std::vector<std::tuple<GLuint, const GLchar*>>& attributes,
+                const program_cache*                                  cache)
+            : state(state_)
+        {
+            std::uint64_t key = 0;
+            if (cache != nullptr)
+            {
+                std::string bindings;
+                for (const auto& [location, name] : attributes)
+                {
+                    bindings += std::to_string(location) + name + ';';
+                }
+                key = program_cache::make_key(
+                        { vertex_src, fragment_src, bindings, gl_string(GL_VENDOR),
+                          gl_string(GL_RENDERER), gl_string(GL_VERSION) });
+                program_id = load_binary(*cache, key);
+                cached     = program_id != 0;
+            }
+            if (program_id == 0)
+            {
+                vert_shader = compile_shader(GL_VERTEX_SHADER, vertex_src);
+                frag_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_src);
+                if (vert_shader == 0 || frag_shader == 0)
+                {
+                    throw std::runtime_error("can't compile shader");
+                }
+                program_id = link_shader_program(attributes, cache != nullptr);
+                if (program_id == 0)
+                {
+                    throw std::runtime_error("can't link shader");
+                }
+                if (cache != nullptr)
+                {
+                    store_binary(*cache, key);
+                }
+            }
+            reflect();
+        }
+
+        void use() const { state.use_program(program_id); }
+
+        /// program came from program_cache, nothing was compiled
+        bool from_cache() const { return cached; }
+
+        /// arrays of all active attributes of linked program
+        std::uint32_t get_attrib_mask() const { return attrib_mask; }
+
+        /// resolve uniform once, check its type matches T
+        template <typename T>
+        uniform<T> get_uniform(std::string_view uniform_name) const
+        {
+            for (std::size_t i = 0; i < uniforms.size(); ++i)
+            {
+                if (uniforms[i].name != uniform_name)
+                {
+                    continue;
+                }
+                if (uniforms[i].type != uniform_gl_type<T>())
+                {
+                    throw std::runtime_error("uniform type mismatch: " +
+                                             uniforms[i].name);
+                }
+                return uniform<T>{ i };
+            }
+            eng_LOG(error, gl, "can't get uniform location from shader: {}", uniform_name);
+            throw std::runtime_error("can't get uniform location");
+        }
+
+        void set_uniform(uniform<texture_gl_es20*> u, texture_gl_es20* texture)
+        {
+            assert(texture != nullptr);
+            const GLuint texture_unit = 0;
+            state.bind_texture(texture_unit, texture->get_handle());
+            uniform_info& info = uniforms[u.index];
+            if (!changed(info, { static_cast<float>(texture_unit) }))
+            {
+                return;
+            }
+            glUniform1i(info.location, static_cast<int>(texture_unit));
+            eng_GL_CHECK();
+        }
+
+        void set_uniform(uniform<color> u, const color& c)
+        {
+            uniform_info& info = uniforms[u.index];
+            if (!changed(info, { c.get_r(), c.get_g(), c.get_b(), c.get_a() }))
+            {
+                return;
+            }
+            glUniform4fv(info.location, 1, info.value.data());
+            eng_GL_CHECK();
+        }
+
+        void set_uniform(uniform<mat2x3> u, const mat2x3& m)
+        {
+            uniform_info& info = uniforms[u.index];
+            // OpenGL wants matrix in column major order
+            // clang-format off
+            if (!changed(info, { m.row1.x,  m.row2.x, m.delta.x,
+                                 m.row1.y, m.row2.y, m.delta.y,
+                                 0.f,      0.f,       1.f }))
+            // clang-format on
+            {
+                return;
+            }
+            glUniformMatrix3fv(info.location, 1, GL_FALSE, info.value.data());
+            eng_GL_CHECK();
+        }
+
+        void set_uniform(uniform<float> u, float value)
+        {
+            uniform_info& info = uniforms[u.index];
+            if (!changed(info, { value }))
+            {
+                return;
+            }
+            glUniform1f(info.location, value);
+            eng_GL_CHECK();
+        }
+
+        template <typename T>
+        void set_uniform(std::string_view uniform_name, const T& value)
+        {
+            set_uniform(get_uniform<T>(uniform_name), value);
+        }
+
+    private:
+        struct uniform_info
+        {
+            std::string          name;
+            GLenum               type     = 0;
+            GLint                location = -1;
+            std::array<float, 9> value{};
+            bool                 cached = false;
+        };
+
+        /// store new value, return false if program already has it
+        bool changed(uniform_info& info, std::initializer_list<float> value)
+        {
+            const bool same =
+                    info.cached &&
+                    std::equal(value.begin(), value.end(), info.value.begin());
+            state.count_uniform(same);
+            if (same)
+            {
+                return false;
+            }
+            std::copy(value.begin(), value.end(), info.value.begin());
+            info.cached = true;
+            return true;
+        }
+
+        /// enumerate active uniforms and attributes after link
+        void reflect()
+        {
+            GLint count      = 0;
+            GLint max_length = 0;
+            glGetProgramiv(program_id, GL_ACTIVE_UNIFORMS, &count);
+            eng_GL_CHECK();
+            glGetProgramiv(program_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+            eng_GL_CHECK();
+            std::vector<GLchar> name(static_cast<size_t>(max_length) + 1);
+            for (GLint i = 0; i < count; ++i)
+            {
+                GLint        size = 0;
+                uniform_info info;
+                glGetActiveUniform(program_id, static_cast<GLuint>(i),
+                                   static_cast<GLsizei>(name.size()), nullptr,
+                                   &size, &info.type, name.data());
+                eng_GL_CHECK();
+                info.name     = name.data();
+                info.location = glGetUniformLocation(program_id, name.data());
+                eng_GL_CHECK();
+                uniforms.push_back(info);
+            }
+
+            glGetProgramiv(program_id, GL_ACTIVE_ATTRIBUTES, &count);
+            eng_GL_CHECK();
+            glGetProgramiv(program_id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+            eng_GL_CHECK();
+            name.resize(static_cast<size_t>(max_length) + 1);
+            for (GLint i = 0; i < count; ++i)
+            {
+                GLint  size = 0;
+                GLenum type = 0;
+                glGetActiveAttrib(program_id, static_cast<GLuint>(i),
+                                  static_cast<GLsizei>(name.size()), nullptr,
+                                  &size, &type, name.data());
+                eng_GL_CHECK();
+                const GLint location = glGetAttribLocation(program_id, name.data());
+                eng_GL_CHECK();
+                if (location >= 0)
+                {
+                    attrib_mask |= 1u << location;
+                }
+            }
+        }
+
+    private:
+        static std::string_view gl_string(GLenum name)
+        {
+            const auto* value = reinterpret_cast<const char*>(glGetString(name));
+            eng_GL_CHECK();
+            return value != nullptr ? value : "";
+        }
+
+        /// program from cached binary, 0 when there is none or driver
+        /// refuses it (driver update, other gpu): then entry is dropped
+        static GLuint load_binary(const program_cache& cache, std::uint64_t key)
+        {
+            std::uint32_t             format = 0;
+            std::vector<std::uint8_t> binary;
+            if (!cache.load(key, format, binary))
+            {
+                return 0;
+            }
+            const GLuint id = glCreateProgram();
+            eng_GL_CHECK();
+            glProgramBinary(id, format, binary.data(), static_cast<GLsizei>(binary.size()));
+            eng_GL_CHECK();
+            GLint linked = 0;
+            glGetProgramiv(id, GL_LINK_STATUS, &linked);
+            eng_GL_CHECK();
+            if (linked == 0)
+            {
+                eng_LOG(info, gl, "cached program refused by driver, compiling it");
+                glDeleteProgram(id);
+                eng_GL_CHECK();
+                cache.remove(key);
+                return 0;
+            }
+            return id;
+        }
+
+        void store_binary(const program_cache& cache, std::uint64_t key) const
+        {
+            GLint length = 0;
+            glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+            eng_GL_CHECK();
+            if (length <= 0)
+            {
+                return;
+            }
+            std::vector<std::uint8_t> binary(static_cast<std::size_t>(length));
+            GLsizei                   written = 0;
+            GLenum                    format  = 0;
+            glGetProgramBinary(program_id, length, &written, &format, binary.data());
+            eng_GL_CHECK();
+            binary.resize(static_cast<std::size_t>(written));
+            if (written == 0 || !cache.store(key, format, binary))
+            {
+                eng_LOG(warn, gl, "can't store program binary in cache");
+            }
+        }
+
+        GLuint compile_shader(GLenum shader_type, std::string_view src)
+        {
+            GLuint shader_id = glCreateShader(shader_type);
+            eng_GL_CHECK();
+            std::string_view vertex_shader_src = src;
+            const char*      source            = vertex_shader_src.data();
+            glShaderSource(shader_id, 1, &source, nullptr);
+            eng_GL_CHECK();
+
+            glCompileShader(shader_id);
+            eng_GL_CHECK();
+
+            GLint compiled_status = 0;
+            glGetShaderiv(shader_id, GL_COMPILE_STATUS, &compiled_status);
+            eng_GL_CHECK();
+            if (compiled_status == 0)
+            {
+                GLint info_len = 0;
+                glGetShaderiv(shader_id, GL_INFO_LOG_LENGTH, &info_len);
+                eng_GL_CHECK();
+                std::vector<char> info_chars(static_cast<size_t>(info_len));
+                glGetShaderInfoLog(shader_id, info_len, nullptr, info_chars.data());
+                eng_GL_CHECK();
+                glDeleteShader(shader_id);
+                eng_GL_CHECK();
+
+                std::string shader_type_name =
+                        shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment";
+                eng_LOG(error, gl, "error compiling shader({})\n{}\n{}",
+                        shader_type_name, src, info_chars.data());
+                return 0;
+            }
+            return shader_id;
+        }
+        GLuint link_shader_program(
+                const std::vector<std::tuple<GLuint, const GLchar*>>& attributes,
+                bool                                                  retrievable)
+        {
+            GLuint program_id_ = glCreateProgram();
+            eng_GL_CHECK();
+            if (0 == program_id_)
+            {
+                eng_LOG(error, gl, "failed to create gl program");
+                throw std::runtime_error("can't link shader");
+            }
+
+            glAttachShader(program_id_, vert_shader);
+            eng_GL_CHECK();
+            glAttachShader(program_id_, frag_shader);
+            eng_GL_CHECK();
+
+            // bind attribute location
+            for (const auto& attr : attributes)
+            {
+                GLuint        loc  = std::get<0>(attr);
+                const GLchar* name = std::get<1>(attr);
+                glBindAttribLocation(program_id_, loc, name);
+                eng_GL_CHECK();
+            }
+
+            if (retrievable)
+            {
+                // some drivers keep binary only when asked before link
+                glProgramParameteri(program_id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE);
+                eng_GL_CHECK();
+            }
+            // link program after binding attribute locations
+            glLinkProgram(program_id_);
+            eng_GL_CHECK();
+            // Check the link status
+            GLint linked_status = 0;
+            glGetProgramiv(program_id_, GL_LINK_STATUS, &linked_status);
+            eng_GL_CHECK();
+            if (linked_status == 0)
+            {
+                GLint infoLen = 0;
+                glGetProgramiv(program_id_, GL_INFO_LOG_LENGTH, &infoLen);
+                eng_GL_CHECK();
+                std::vector<char> infoLog(static_cast<size_t>(infoLen));
+                glGetProgramInfoLog(program_id_, infoLen, nullptr, infoLog.data());
+                eng_GL_CHECK();
+                eng_LOG(error, gl, "error linking program:\n{}", infoLog.data());
+                glDeleteProgram(program_id_);
+                eng_GL_CHECK();
+                return 0;
+            }
+            return program_id_;
+        }
+
+        gl_state& state;
+
+        GLuint vert_shader = 0;
+        GLuint frag_shader = 0;
+        GLuint program_id  = 0;
+
+        std::vector<uniform_info> uniforms;
+        std::uint32_t             attrib_mask = 0;
+        bool                      cached      = false;
+    };
+
+    static std::array<std::string_view, 17> event_names = {
+            /// input events
+            { "left_pressed", "left_released", "right_pressed", "right_released",
+                    "up_pressed", "up_released", "down_pressed", "down_released",
+                    "select_pressed", "select_released", "start_pressed", "start_released",
+                    "button1_pressed", "button1_released", "button2_pressed",
+                    "button2_released",
+                    /// virtual console events
+                    "turn_off" }
+    };
+
+    std::string_view to_string(const event e)
+    {
+        auto value   = static_cast<std::uint32_t>(e);
+        auto minimal = static_cast<std::uint32_t>(event::left_pressed);
+        auto maximal = static_cast<std::uint32_t>(event::turn_off);
+        if (value >= minimal && value <= maximal)
+        {
+            return event_names[value];
+        }
+        else
+        {
+            throw std::runtime_error("too big event value");
+        }
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const event e) {
+        stream << to_string(e);
+        return stream;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const state_stats& s)
+    {
+        stream << "program: " << s.program_changes << " skipped "
+               << s.program_skipped << '\n'
+               << "texture: " << s.texture_changes << " skipped "
+               << s.texture_skipped << '\n'
+               << "attrib:  " << s.attrib_changes << " skipped "
+               << s.attrib_skipped << '\n'
+               << "uniform: " << s.uniform_changes << " skipped "
+               << s.uniform_skipped << '\n'
+               << "buffer:  " << s.buffer_changes << " skipped "
+               << s.buffer_skipped << '\n'
+               << "vertex bytes: " << s.vertex_bytes;
+        return stream;
+    }
+
+    tri0::tri0()
+            : v{ v0(), v0(), v0() }
+    {
+    }
+
+    tri1::tri1()
+            : v{ v1(), v1(), v1() }
+    {
+    }
+
+    tri2::tri2()
+            : v{ v2(), v2(), v2() }
+    {
+    }
+
+    quad::quad()
+            : v{ v2(), v2(), v2(), v2() }
+    {
+    }
+
+    bool make_mesh(const tri2* tris, std::size_t count, mesh& out)
+    {
+        // vertex bytes as key: equal floats with different bits (0, -0)
+        // stay separate, that only costs a vertex
+        using vertex_bits = std::array<std::uint32_t, sizeof(v2) / 4>;
+        static_assert(sizeof(vertex_bits) == sizeof(v2));
+        struct hash_bits
+        {
+            std::size_t operator()(const vertex_bits& bits) const
+            {
+                std::size_t h = 0;
+                for (std::uint32_t word : bits)
+                {
+                    h = (h ^ word) * 0x100000001b3ull;
+                }
+                return h;
+            }
+        };
+        // big inputs mostly fail at 16 bit limit, reserve no more than it
+        const std::size_t reserved = std::min<std::size_t>(count * 3, 0x10000);
+        std::unordered_map<vertex_bits, std::uint16_t, hash_bits> seen;
+        seen.reserve(reserved);
+        out.vertexes.clear();
+        out.indexes.clear();
+        out.indexes.reserve(reserved);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            for (const v2& v : tris[i].v)
+            {
+                vertex_bits bits;
+                std::memcpy(bits.data(), &v, sizeof(v));
+                const auto found = seen.find(bits);
+                if (found != seen.end())
+                {
+                    out.indexes.push_back(found->second);
+                    continue;
+                }
+                if (out.vertexes.size() > 0xFFFF)
+                {
+                    return false;
+                }
+                const auto index = static_cast<std::uint16_t>(out.vertexes.size());
+                seen.emplace(bits, index);
+                out.vertexes.push_back(v);
+                out.indexes.push_back(index);
+            }
+        }
+        return true;
+    }
+
+    std::ostream& operator<<(std::ostream& out, const SDL_version& v)
+    {
+        out << static_cast<int>(v.major) << '.';
+        out << static_cast<int>(v.minor) << '.';
+        out << static_cast<int>(v.patch);
+        return out;
+    }
+
+    std::istream& operator>>(std::istream& is, color& c)
+    {
+        float r = 0.f;
+        float g = 0.f;
+        float b = 0.f;
+        float a = 0.f;
+        is >> r;
+        is >> g;
+        is >> b;
+        is >> a;
+        c = color(r, g, b, a);
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, v0& v)
+    {
+        is >> v.p.x;
+        is >> v.p.y;
+
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, v1& v)
+    {
+        is >> v.p.x;
+        is >> v.p.y;
+        is >> v.c;
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, v2& v)
+    {
+        is >> v.p.x;
+        is >> v.p.y;
+        is >> v.t_p.x;
+        is >> v.t_p.y;
+        is >> v.c;
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, tri0& t)
+    {
+        is >> t.v[0];
+        is >> t.v[1];
+        is >> t.v[2];
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, tri1& t)
+    {
+        is >> t.v[0];
+        is >> t.v[1];
+        is >> t.v[2];
+        return is;
+    }
+
+    std::istream& operator>>(std::istream& is, tri2& t)
+    {
+        is >> t.v[0];
+        is >> t.v[1];
+        is >> t.v[2];
+        return is;
+    }
+
+    class engine_impl final : public engine {
+    public:
+        /// create main window
+        /// on success return empty string
+        std::string initialize(std::string_view config) final;
+        /// return seconds from initialization
+        double get_time_from_init() final
+        {
+            const Uint64 ticks = SDL_GetPerformanceCounter() - start_counter;
+            return static_cast<double>(ticks) / counter_frequency;
+        }
+        /// pop event collected by last input pump (swap_buffers)
+        /// return true if more events in queue
+        bool read_input(event& e) final { return input.pop(e); }
+        button_set get_held_buttons() const final { return input.get_held(); }
+        bool bind_key(button b, std::string_view key_name) final
+        {
+            return input.bind(b, key_name);
+        }
+
+        texture* create_texture(std::string_view path) final
+        {
+            auto* result = new texture_gl_es20(path);
+            // constructor binds texture to active unit directly
+            state.note_texture(result->get_handle());
+            return result;
+        }
+        texture* create_texture_async(std::string_view path) final
+        {
+            auto* result =
+                    new texture_gl_es20(loader->load(path), placeholder_texture);
+            uploads.push_back(result);
+            return result;
+        }
+        texture* create_atlas_texture(std::string_view path) final
+        {
+            const image img = load_png_image(path);
+            texture_gl_es20* page  = nullptr;
+            const uv_remap   remap = paste_into_atlas(img, page);
+            return new atlas_texture_gl(page, remap, img.width, img.height);
+        }
+        texture* create_atlas_texture_async(std::string_view path) final
+        {
+            if (!atlas_placeholder)
+            {
+                // 1x1 transparent, loading images sample it
+                atlas_placeholder = std::make_unique<texture_gl_es20>(1, 1);
+                state.note_texture(atlas_placeholder->get_handle());
+            }
+            auto* result =
+                    new atlas_texture_gl(loader->load(path), atlas_placeholder.get());
+            atlas_uploads.push_back(result);
+            return result;
+        }
+        void destroy_texture(texture* t) final
+        {
+            if (auto* sub = dynamic_cast<atlas_texture_gl*>(t))
+            {
+                atlas_uploads.erase(
+                        std::remove(atlas_uploads.begin(), atlas_uploads.end(), sub),
+                        atlas_uploads.end());
+                // page stays, its space is not reused
+                delete sub;
+                return;
+            }
+            auto* texture = static_cast<texture_gl_es20*>(t);
+            uploads.erase(std::remove(uploads.begin(), uploads.end(), texture),
+                          uploads.end());
+            if (texture->get_storage() != 0)
+            {
+                state.forget_texture(texture->get_storage());
+            }
+            delete texture;
+        }
+
+        vertex_buffer* create_vertex_buffer(const tri2* tris, std::size_t count) final
+        {
+            return new vertex_buffer_gl(state, tris, count, allow_packed);
+        }
+        vertex_buffer* create_vertex_buffer(const mesh& m) final
+        {
+            return new vertex_buffer_gl(state, m, allow_packed);
+        }
+        void destroy_vertex_buffer(vertex_buffer* buffer) final
+        {
+            if (buffer == nullptr)
+            {
+                return;
+            }
+            auto* mesh = static_cast<vertex_buffer_gl*>(buffer);
+            state.forget_buffer(mesh->id);
+            state.forget_buffer(mesh->index_id);
+            delete mesh;
+        }
+        render_target* create_render_target(std::uint32_t width,
+                                            std::uint32_t height) final
+        {
+            if (!framebuffers)
+            {
+                throw std::runtime_error("context can't render to textures");
+            }
+            return new render_target_gl(state, width, height,
+                                        target != nullptr ? target->fbo : 0);
+        }
+        void destroy_render_target(render_target* t) final
+        {
+            if (t == nullptr)
+            {
+                return;
+            }
+            if (t == target)
+            {
+                set_render_target(nullptr);
+            }
+            auto* rt = static_cast<render_target_gl*>(t);
+            if (batch_texture == &rt->color)
+            {
+                batch_texture = nullptr;
+            }
+            state.forget_texture(rt->color.get_storage());
+            delete rt;
+        }
+        void set_render_target(render_target* t) final
+        {
+            auto* next = static_cast<render_target_gl*>(t);
+            if (next == target)
+            {
+                return;
+            }
+            draw_batch();
+            target = next;
+            bind_framebuffer(target);
+        }
+        void clear(const color& c) final
+        {
+            draw_batch();
+            glClearColor(c.get_r(), c.get_g(), c.get_b(), c.get_a());
+            eng_GL_CHECK();
+            glClear(GL_COLOR_BUFFER_BIT);
+            eng_GL_CHECK();
+        }
+        bool request_readback() final
+        {
+            draw_batch();
+            if (target != nullptr)
+            {
+                return readbacks.request(target->color.get_width(),
+                                         target->color.get_height(), frame_index);
+            }
+            return readbacks.request(static_cast<std::uint32_t>(window_width),
+                                     static_cast<std::uint32_t>(window_height),
+                                     frame_index);
+        }
+        bool poll_readback(pixel_readback& out) final
+        {
+            return readbacks.poll(out, frame_index);
+        }
+        void render(const tri0& t, const color& c) final
+        {
+            eng_PROFILE_SCOPE("render tri0");
+            shader00->use();
+            shader00->set_uniform(u_color00, c);
+            set_attribs<v0>(stream.write(t.v, sizeof(t.v)));
+            state.enable_attribs(shader00->get_attrib_mask());
+
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            eng_GL_CHECK();
+        }
+        void render(const tri1& t) final
+        {
+            eng_PROFILE_SCOPE("render tri1");
+            shader01->use();
+            set_attribs<v1>(stream.write(t.v, sizeof(t.v)));
+            state.enable_attribs(shader01->get_attrib_mask());
+
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            eng_GL_CHECK();
+        }
+        void render(const tri2& tri, texture* tex, const mat2x3& mat) final {
+            eng_PROFILE_SCOPE("render tri2");
+            shader02->use();
+            const uv_remap* remap   = nullptr;
+            auto*           texture = resolve(tex, remap);
+            tri2            t       = tri;
+            if (remap != nullptr)
+            {
+                for (v2& v : t.v)
+                {
+                    v.t_p = remap->apply(v.t_p);
+                }
+            }
+            shader02->set_uniform(s_texture02, texture);
+            shader02->set_uniform(u_matrix02, mat);
+            set_attribs<v2>(stream.write(t.v, sizeof(t.v)));
+            state.enable_attribs(shader02->get_attrib_mask());
+
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            eng_GL_CHECK();
+        }
+        void render(const vertex_buffer& buffer, texture* tex, const mat2x3& mat) final
+        {
+            eng_PROFILE_SCOPE("render vertex_buffer");
+            const auto&     mesh    = static_cast<const vertex_buffer_gl&>(buffer);
+            const uv_remap* remap   = nullptr;
+            auto*           texture = resolve(tex, remap);
+            assert(texture != nullptr);
+            shader04->use();
+            shader04->set_uniform(s_texture04, texture);
+            state.bind_array_buffer(mesh.id);
+            shader04->set_uniform(u_position_scale04, mesh.set_attribs());
+            // instance attributes stay disabled arrays, shader reads their
+            // constant values instead
+            state.enable_attribs(0b111);
+            const uv_remap uv    = remap != nullptr ? *remap : uv_remap();
+            const float rows[4]  = { mat.row1.x, mat.row1.y, mat.row2.x, mat.row2.y };
+            const float delta[4] = { mat.delta.x, mat.delta.y, 0.f, 1.f };
+            const float white[4] = { 1.f, 1.f, 1.f, 1.f };
+            const float uv_rect[4] = { uv.offset.x, uv.offset.y, uv.scale.x,
+                                       uv.scale.y };
+            glVertexAttrib4fv(3, rows);
+            eng_GL_CHECK();
+            glVertexAttrib4fv(4, delta);
+            eng_GL_CHECK();
+            glVertexAttrib4fv(5, white);
+            eng_GL_CHECK();
+            glVertexAttrib4fv(6, uv_rect);
+            eng_GL_CHECK();
+
+            mesh.draw(state, 0);
+        }
+        void begin_batch() final
+        {
+            batch_vertexes.clear();
+            batch_indexes.clear();
+            batch_texture = nullptr;
+            batching      = true;
+        }
+        void submit(const tri2& t, texture* tex, const mat2x3& mat) final
+        {
+            append_to_batch(batch_mode::triangles, t.v, 3, tex, mat);
+        }
+        void submit(const quad& q, texture* tex, const mat2x3& mat) final
+        {
+            append_to_batch(batch_mode::quads, q.v, 4, tex, mat);
+        }
+        void submit(const mesh& m, texture* tex, const mat2x3& mat) final
+        {
+            assert(m.vertexes.size() <= index_limit);
+            const std::size_t first = append_to_batch(
+                    batch_mode::indexed, m.vertexes.data(), m.vertexes.size(), tex, mat);
+            for (std::uint16_t index : m.indexes)
+            {
+                batch_indexes.push_back(static_cast<std::uint16_t>(first + index));
+            }
+        }
+        void flush_batch() final
+        {
+            draw_batch();
+            batching = false;
+        }
+        void render_instanced(const tri2* tris, std::size_t count, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            draw_instanced(nullptr, tris, count, tex, instances, instance_count);
+        }
+        void render_instanced(const vertex_buffer& buffer, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            const auto& mesh = static_cast<const vertex_buffer_gl&>(buffer);
+            draw_instanced(&mesh, mesh.tris.data(), mesh.tris.size(), tex, instances,
+                           instance_count);
+        }
+        void execute(const command_list* lists, std::size_t count) final
+        {
+            eng_PROFILE_SCOPE("execute");
+            sort_commands(lists, count, sorted_commands, sort_scratch);
+            draw_batch();
+            batching      = false;
+            batch_texture = nullptr;
+            for (const command_ref& r : sorted_commands)
+            {
+                const command_list& list = lists[r.list];
+                const draw_command& c    = list.get_command(r.index);
+                if (c.kind != draw_kind::textured && c.kind != draw_kind::textured_quad)
+                {
+                    draw_batch();
+                    for (std::uint32_t i = 0; i < c.count; ++i)
+                    {
+                        if (c.kind == draw_kind::color)
+                        {
+                            render(list.get_tri0(c)[i], c.c);
+                        }
+                        else
+                        {
+                            render(list.get_tri1(c)[i]);
+                        }
+                    }
+                    continue;
+                }
+                const uv_remap* remap   = nullptr;
+                auto*           texture = resolve(c.tex, remap);
+                assert(texture != nullptr);
+                if (texture != batch_texture)
+                {
+                    draw_batch();
+                    batch_texture = texture;
+                }
+                // positions were transformed by recording thread
+                const bool        quads = c.kind == draw_kind::textured_quad;
+                const std::size_t vertex_count = std::size_t(c.count) * (quads ? 4 : 3);
+                const std::size_t first        = append_vertexes(
+                        quads ? batch_mode::quads : batch_mode::triangles, vertex_count);
+                const v2* in = list.get_vertexes(c);
+                std::copy(in, in + vertex_count,
+                          batch_vertexes.begin() + static_cast<std::ptrdiff_t>(first));
+                if (remap != nullptr)
+                {
+                    for (std::size_t i = first; i < batch_vertexes.size(); ++i)
+                    {
+                        batch_vertexes[i].t_p = remap->apply(batch_vertexes[i].t_p);
+                    }
+                }
+            }
+            draw_batch();
+        }
+        void swap_buffers() final
+        {
+            {
+                eng_PROFILE_SCOPE("swap_buffers");
+                if (batching)
+                {
+                    draw_batch();
+                }
+                stream.end_frame();
+                gpu.end();
+                SDL_GL_SwapWindow(window);
+                pacing.frame_presented();
+                ++frame_index;
+
+                gpu.begin("clear and upload");
+                // window is cleared even when frame draws into target,
+                // clear() may have left other color
+                if (target != nullptr)
+                {
+                    bind_framebuffer(nullptr);
+                }
+                glClearColor(0.f, 0.f, 0.f, 0.f);
+                eng_GL_CHECK();
+                glClear(GL_COLOR_BUFFER_BIT);
+                eng_GL_CHECK();
+                if (target != nullptr)
+                {
+                    bind_framebuffer(target);
+                }
+
+                upload_textures();
+                gpu.end();
+                gpu.collect();
+                gl_debug_end_frame();
+
+                state.end_frame();
+            }
+            {
+                eng_PROFILE_SCOPE("frame limiter");
+                pacing.wait_for_next_frame();
+            }
+            {
+                eng_PROFILE_SCOPE("input pump");
+                input.pump();
+                note_input_time();
+            }
+            eng_PROFILE_FRAME();
+            // everything drawn until next swap
+            gpu.begin("frame");
+        }
+        state_stats get_state_stats() const final
+        {
+            return state.get_last_frame();
+        }
+        frame_stats get_frame_stats() const final { return pacing.get_stats(); }
+        void uninitialize() final
+        {
+            {
+                std::ostringstream stats;
+                stats << pacing.get_stats();
+                eng_LOG(info, engine, "{}", stats.str());
+            }
+            if (!trace.empty())
+            {
+                const std::string error = write_chrome_trace(trace, trace_frames);
+                if (!error.empty())
+                {
+                    eng_LOG(error, engine, "{}", error);
+                }
+            }
+            gpu.uninitialize();
+            readbacks.uninitialize();
+            stream.uninitialize();
+            state.forget_buffer(quad_indexes);
+            glDeleteBuffers(1, &quad_indexes);
+            eng_GL_CHECK();
+            loader.reset();
+            atlas_pages.clear();
+            atlas_placeholder.reset();
+            const std::string gl_errors = gl_debug_report();
+            if (!gl_errors.empty())
+            {
+                // report ends with newline
+                eng_LOG(warn, gl, "gl errors by call site:\n{}",
+                        std::string_view(gl_errors).substr(0, gl_errors.size() - 1));
+            }
+            gl_debug_uninitialize();
+            SDL_GL_DeleteContext(gl_context);
+            SDL_DestroyWindow(window);
+            SDL_Quit();
+        }
+
+    private:
+        /// how draw_batch reads batch_vertexes
+        enum class batch_mode
+        {
+            /// 3 vertexes per triangle, glDrawArrays
+            triangles,
+            /// 4 vertexes per quad, indexes from quad_indexes
+            quads,
+            /// batch_indexes pick vertexes, streamed with them
+            indexed
+        };
+        /// 16 bit indexes reach this many vertexes
+        static constexpr std::size_t index_limit = 0x10000;
+
+        /// atlas textures draw with their page and remapped coordinates,
+        /// remap stays nullptr for plain textures
+        texture_gl_es20* resolve(texture* tex, const uv_remap*& remap)
+        {
+            if (auto* sub = dynamic_cast<atlas_texture_gl*>(tex))
+            {
+                remap = &sub->remap;
+                return sub->page;
+            }
+            return dynamic_cast<texture_gl_es20*>(tex);
+        }
+
+        /// spend this frame's upload budget on decoded async textures,
+        /// oldest request first, still decoding ones are skipped
+        void upload_textures()
+        {
+            eng_PROFILE_SCOPE("upload_textures");
+            std::size_t budget = upload_budget;
+            for (std::size_t i = 0; i < uploads.size() && budget != 0;)
+            {
+                if (uploads[i]->upload_step(state, budget))
+                {
+                    uploads.erase(uploads.begin() + static_cast<std::ptrdiff_t>(i));
+                }
+                else
+                {
+                    ++i;
+                }
+            }
+            // whole image goes into page at once, it is usually small
+            for (std::size_t i = 0; i < atlas_uploads.size() && budget != 0;)
+            {
+                atlas_texture_gl* sub = atlas_uploads[i];
+                if (!sub->request->done.load(std::memory_order_acquire))
+                {
+                    ++i;
+                    continue;
+                }
+                if (sub->request->error.empty())
+                {
+                    const image&     img  = sub->request->img;
+                    texture_gl_es20* page = nullptr;
+                    const uv_remap   remap = paste_into_atlas(img, page);
+                    budget -= std::min(budget, img.pixels.size());
+                    sub->place(page, remap);
+                }
+                else
+                {
+                    sub->fail();
+                }
+                atlas_uploads.erase(atlas_uploads.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+        }
+
+        /// place img into atlas, opening page if needed; return remap of
+        /// its texture coordinates into page
+        uv_remap paste_into_atlas(const image& img, texture_gl_es20*& page)
+        {
+            const atlas_allocator::placement place =
+                    atlas->place(img.width, img.height);
+            if (place.new_page)
+            {
+                atlas_pages.push_back(std::make_unique<texture_gl_es20>(
+                        place.page_width, place.page_height));
+                // constructor binds texture to active unit directly
+                state.note_texture(atlas_pages.back()->get_handle());
+            }
+            page                        = atlas_pages[place.page].get();
+            const std::uint32_t padding = atlas->get_padding();
+            page->paste(state, pad_image(img, padding), place.rect.x - padding,
+                        place.rect.y - padding);
+            return atlas_allocator::get_remap(place);
+        }
+
+        /// tris come from mesh when it is not null, else they are streamed
+        void draw_instanced(const vertex_buffer_gl* mesh, const tri2* tris,
+                            std::size_t count, texture* tex,
+                            const sprite_instance* instances,
+                            std::size_t instance_count)
+        {
+            eng_PROFILE_SCOPE("render_instanced");
+            const uv_remap* remap   = nullptr;
+            auto*           texture = resolve(tex, remap);
+            assert(texture != nullptr);
+            // keep order with triangles submitted before
+            draw_batch();
+            if (count == 0 || instance_count == 0)
+            {
+                return;
+            }
+            if (!instancing)
+            {
+                expand_instances(tris, count, instances, instance_count, remap);
+                batch_primitive = batch_mode::triangles;
+                batch_texture   = texture;
+                draw_batch();
+                return;
+            }
+            if (remap != nullptr)
+            {
+                // atlas remap folds into uv rect of every instance
+                instance_scratch.assign(instances, instances + instance_count);
+                for (sprite_instance& i : instance_scratch)
+                {
+                    i.uv_origin = remap->apply(i.uv_origin);
+                    i.uv_size = vec2(i.uv_size.x * remap->scale.x,
+                                     i.uv_size.y * remap->scale.y);
+                }
+                instances = instance_scratch.data();
+            }
+            shader04->use();
+            shader04->set_uniform(s_texture04, texture);
+
+            // tri2 array is one array of v2
+            static_assert(sizeof(tri2) == 3 * sizeof(v2));
+            const std::size_t vertex_size   = mesh != nullptr ? 0 : count * sizeof(tri2);
+            const std::size_t instance_size = instance_count * sizeof(sprite_instance);
+            stream.reserve(stream_buffer::reserve_size({ vertex_size, instance_size }));
+            float position_scale = 1.f;
+            if (mesh != nullptr)
+            {
+                state.bind_array_buffer(mesh->id);
+                position_scale = mesh->set_attribs();
+            }
+            else
+            {
+                position_scale = stream_vertexes(tris[0].v, count * 3);
+            }
+            shader04->set_uniform(u_position_scale04, position_scale);
+            // per instance: row1 and row2 as one vec4, delta, tint,
+            // uv_origin and uv_size as one vec4
+            const std::size_t offset = stream.write(instances, instance_size);
+            constexpr GLsizei     stride = sizeof(sprite_instance);
+            constexpr std::size_t m      = offsetof(sprite_instance, m);
+            glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, stride,
+                                  buffer_offset(offset + m + offsetof(mat2x3, row1)));
+            eng_GL_CHECK();
+            glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, stride,
+                                  buffer_offset(offset + m + offsetof(mat2x3, delta)));
+            eng_GL_CHECK();
+            glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+                                  buffer_offset(offset + offsetof(sprite_instance, tint)));
+            eng_GL_CHECK();
+            glVertexAttribPointer(
+                    6, 4, GL_FLOAT, GL_FALSE, stride,
+                    buffer_offset(offset + offsetof(sprite_instance, uv_origin)));
+            eng_GL_CHECK();
+            state.enable_attribs(shader04->get_attrib_mask());
+
+            if (mesh != nullptr)
+            {
+                mesh->draw(state, instance_count);
+                return;
+            }
+            glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(count * 3),
+                                  static_cast<GLsizei>(instance_count));
+            eng_GL_CHECK();
+        }
+
+        /// instances appended to batch stream as shader04 would draw them
+        void expand_instances(const tri2* tris, std::size_t count,
+                              const sprite_instance* instances,
+                              std::size_t instance_count, const uv_remap* remap)
+        {
+            const std::size_t vertex_count = count * 3;
+            batch_vertexes.resize(instance_count * vertex_count);
+            v2* out = batch_vertexes.data();
+            for (std::size_t i = 0; i < instance_count; ++i)
+            {
+                const sprite_instance& inst = instances[i];
+                for (std::size_t t = 0; t < count; ++t)
+                {
+                    transform_vertexes(tris[t].v, out + t * 3, 3, inst.m);
+                }
+                for (std::size_t v = 0; v < vertex_count; ++v)
+                {
+                    v2& vertex = out[v];
+                    vertex.c   = vertex.c * inst.tint;
+                    vertex.t_p = vec2(inst.uv_origin.x + vertex.t_p.x * inst.uv_size.x,
+                                      inst.uv_origin.y + vertex.t_p.y * inst.uv_size.y);
+                    if (remap != nullptr)
+                    {
+                        vertex.t_p = remap->apply(vertex.t_p);
+                    }
+                }
+                out += vertex_count;
+            }
+        }
+
+        /// stream vertexes, packed when they fit, and point attributes
+        /// 0..2 at them; return scale shader applies to positions
+        float stream_vertexes(const v2* vertexes, std::size_t count)
+        {
+            if (allow_packed)
+            {
+                packed_vertexes.resize(count);
+                if (pack_vertexes(vertexes, packed_vertexes.data(), count))
+                {
+                    set_attribs<v2_packed>(
+                            stream.write(packed_vertexes.data(), count * sizeof(v2_packed)));
+                    return packed_position_range;
+                }
+            }
+            set_attribs<v2>(stream.write(vertexes, count * sizeof(v2)));
+            return 1.f;
+        }
+
+        /// one draw call for all vertexes with same texture
+        void draw_batch()
+        {
+            if (batch_vertexes.empty())
+            {
+                return;
+            }
+            eng_PROFILE_SCOPE("draw_batch");
+            shader03->use();
+            shader03->set_uniform(s_texture03, batch_texture);
+
+            const std::size_t vertex_count = batch_vertexes.size();
+            const std::size_t index_size = batch_indexes.size() * sizeof(std::uint16_t);
+            if (batch_primitive == batch_mode::indexed)
+            {
+                stream.reserve(stream_buffer::reserve_size(
+                        { vertex_count * sizeof(v2), index_size }));
+            }
+            shader03->set_uniform(u_position_scale03,
+                                  stream_vertexes(batch_vertexes.data(), vertex_count));
+            state.enable_attribs(shader03->get_attrib_mask());
+
+            switch (batch_primitive)
+            {
+                case batch_mode::triangles:
+                    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertex_count));
+                    break;
+                case batch_mode::quads:
+                    state.bind_element_buffer(quad_indexes);
+                    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(vertex_count / 4 * 6),
+                                   GL_UNSIGNED_SHORT, nullptr);
+                    break;
+                case batch_mode::indexed:
+                {
+                    const std::size_t offset =
+                            stream.write(batch_indexes.data(), index_size);
+                    stream.bind_indexes();
+                    glDrawElements(GL_TRIANGLES,
+                                   static_cast<GLsizei>(batch_indexes.size()),
+                                   GL_UNSIGNED_SHORT, buffer_offset(offset));
+                    break;
+                }
+            }
+            eng_GL_CHECK();
+
+            // keep capacity, stream grows only to the biggest frame
+            batch_vertexes.clear();
+            batch_indexes.clear();
+        }
+
+        /// texture switch, room in batch and transformed copy of vertexes
+        /// (same transform as u_matrix in shader02) with atlas remap;
+        /// return batch index of first one
+        std::size_t append_to_batch(batch_mode mode, const v2* in, std::size_t count,
+                                    texture* tex, const mat2x3& mat)
+        {
+            assert(batching);
+            const uv_remap* remap   = nullptr;
+            auto*           texture = resolve(tex, remap);
+            assert(texture != nullptr);
+            if (texture != batch_texture)
+            {
+                draw_batch();
+                batch_texture = texture;
+            }
+            const std::size_t first = append_vertexes(mode, count);
+            v2*               out   = &batch_vertexes[first];
+            transform_vertexes(in, out, count, mat);
+            if (remap != nullptr)
+            {
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    out[i].t_p = remap->apply(out[i].t_p);
+                }
+            }
+            return first;
+        }
+
+        /// room for count vertexes laid out as mode at end of batch. Batch
+        /// that can't index them is drawn first, mixed primitives turn
+        /// batch indexed; indexes of indexed mode are left to caller.
+        /// Return index of first new vertex
+        std::size_t append_vertexes(batch_mode mode, std::size_t count)
+        {
+            const std::size_t size = batch_vertexes.size();
+            const bool        fits = size + count <= index_limit;
+            if (size == 0)
+            {
+                batch_primitive = mode;
+            }
+            else if (mode == batch_primitive)
+            {
+                if (mode != batch_mode::triangles && !fits)
+                {
+                    draw_batch();
+                }
+            }
+            else if (!fits)
+            {
+                draw_batch();
+                batch_primitive = mode;
+            }
+            else if (batch_primitive != batch_mode::indexed)
+            {
+                append_indexes(batch_indexes, batch_primitive, 0, size);
+                batch_primitive = batch_mode::indexed;
+            }
+            const std::size_t first = batch_vertexes.size();
+            batch_vertexes.resize(first + count);
+            if (batch_primitive == batch_mode::indexed && mode != batch_mode::indexed)
+            {
+                append_indexes(batch_indexes, mode, first, count);
+            }
+            return first;
+        }
+
+        /// indexes drawing count vertexes from first as triangles or quads
+        static void append_indexes(std::vector<std::uint16_t>& out, batch_mode mode,
+                                   std::size_t first, std::size_t count)
+        {
+            assert(mode != batch_mode::indexed && first + count <= index_limit);
+            if (mode == batch_mode::triangles)
+            {
+                for (std::size_t i = first; i < first + count; ++i)
+                {
+                    out.push_back(static_cast<std::uint16_t>(i));
+                }
+                return;
+            }
+            for (std::size_t i = first; i < first + count; i += 4)
+            {
+                for (std::size_t corner : { 0, 1, 2, 0, 2, 3 })
+                {
+                    out.push_back(static_cast<std::uint16_t>(i + corner));
+                }
+            }
+        }
+
+        SDL_Window*   window     = nullptr;
+        SDL_GLContext gl_context = nullptr;
+
+        Uint64 start_counter     = 0;
+        double counter_frequency = 1.0;
+
+        /// hand age of oldest event of last pump to pacing
+        void note_input_time()
+        {
+            std::uint32_t ticks = 0;
+            if (input.get_oldest_ticks(ticks))
+            {
+                const std::uint32_t age = SDL_GetTicks() - ticks;
+                pacing.input_seen(frame_pacer::clock::now() -
+                                  std::chrono::milliseconds(age));
+            }
+        }
+
+        input_pump    input;
+        frame_pacer   pacing;
+        gpu_timer     gpu;
+        std::string   trace;
+        std::uint32_t trace_frames = 0;
+
+        gl_state      state;
+        stream_buffer stream;
+
+        shader_gl_es20* shader00 = nullptr;
+        shader_gl_es20* shader01 = nullptr;
+        shader_gl_es20* shader02 = nullptr;
+        shader_gl_es20* shader03 = nullptr;
+        shader_gl_es20* shader04 = nullptr;
+
+        // resolved once after link
+        uniform<color>            u_color00;
+        uniform<texture_gl_es20*> s_texture02;
+        uniform<mat2x3>           u_matrix02;
+        uniform<texture_gl_es20*> s_texture03;
+        uniform<float>            u_position_scale03;
+        uniform<texture_gl_es20*> s_texture04;
+        uniform<float>            u_position_scale04;
+
+        std::vector<v2>  batch_vertexes;
+        std::vector<std::uint16_t> batch_indexes;
+        batch_mode                 batch_primitive = batch_mode::triangles;
+        /// static indexes of index_limit / 4 quads, shared by quad batches
+        GLuint quad_indexes = 0;
+        /// batch_vertexes as streamed, kept for capacity
+        std::vector<v2_packed> packed_vertexes;
+        /// stream v2_packed when vertexes fit it
+        bool allow_packed = true;
+        texture_gl_es20* batch_texture = nullptr;
+        bool             batching      = false;
+
+        /// context draws instanced, else render_instanced expands on cpu
+        bool                         instancing = false;
+        /// instances with atlas remap applied, kept for capacity
+        std::vector<sprite_instance> instance_scratch;
+
+        // order of last execute, kept for capacity
+        std::vector<command_ref> sorted_commands;
+        std::vector<command_ref> sort_scratch;
+
+        /// context has framebuffer objects for create_render_target
+        bool              framebuffers = false;
+        /// bound framebuffer, nullptr - window
+        render_target_gl* target = nullptr;
+        /// window viewport, restored when drawing goes back to window
+        GLsizei       window_width  = 0;
+        GLsizei       window_height = 0;
+        readback_ring readbacks;
+
+        /// bind t (nullptr - window) with its viewport, target is not changed
+        void bind_framebuffer(const render_target_gl* t)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, t != nullptr ? t->fbo : 0);
+            eng_GL_CHECK();
+            if (t != nullptr)
+            {
+                glViewport(0, 0, static_cast<GLsizei>(t->color.get_width()),
+                           static_cast<GLsizei>(t->color.get_height()));
+            }
+            else
+            {
+                glViewport(0, 0, window_width, window_height);
+            }
+            eng_GL_CHECK();
+        }
+        /// swap_buffers calls, stamps readbacks
+        std::uint64_t frame_index = 0;
+
+        /// null when no program_cache is configured or context can't
+        /// give program binaries
+        std::unique_ptr<program_cache> programs;
+
+        std::unique_ptr<texture_loader> loader;
+        /// 1x1 transparent, drawn for async textures still loading
+        GLuint                          placeholder_texture = 0;
+        /// async textures not yet uploaded, in request order
+        std::vector<texture_gl_es20*>   uploads;
+        std::size_t                     upload_budget = 0;
+
+        std::unique_ptr<atlas_allocator>              atlas;
+        std::vector<std::unique_ptr<texture_gl_es20>> atlas_pages;
+        /// page of async atlas textures still loading, made on first one
+        std::unique_ptr<texture_gl_es20> atlas_placeholder;
+        /// async atlas textures not yet placed, in request order
+        std::vector<atlas_texture_gl*> atlas_uploads;
+    };
+
+    /// choose backend on initialize, then forward every call to it
+    class engine_proxy final : public engine
+    {
+    public:
+        std::string initialize(std::string_view config) final
+        {
+            engine_config parsed;
+            std::string   error = parse_config(config, parsed);
+            if (!error.empty())
+            {
+                return error;
+            }
+            for (std::size_t i = 0; i < log_category_count; ++i)
+            {
+                set_log_level(static_cast<log_category>(i), parsed.log_levels[i]);
+            }
+            error = set_log_file(parsed.log_file);
+            if (!error.empty())
+            {
+                return error;
+            }
+            if (parsed.backend == "software")
+            {
+                backend.reset(create_soft_engine());
+            }
+            else
+            {
+                backend = std::make_unique<engine_impl>();
+            }
+            return backend->initialize(config);
+        }
+        double get_time_from_init() final { return backend->get_time_from_init(); }
+        bool  read_input(event& e) final { return backend->read_input(e); }
+        button_set get_held_buttons() const final
+        {
+            return backend->get_held_buttons();
+        }
+        bool bind_key(button b, std::string_view key_name) final
+        {
+            return backend->bind_key(b, key_name);
+        }
+        texture* create_texture(std::string_view path) final
+        {
+            return backend->create_texture(path);
+        }
+        texture* create_texture_async(std::string_view path) final
+        {
+            return backend->create_texture_async(path);
+        }
+        texture* create_atlas_texture(std::string_view path) final
+        {
+            return backend->create_atlas_texture(path);
+        }
+        texture* create_atlas_texture_async(std::string_view path) final
+        {
+            return backend->create_atlas_texture_async(path);
+        }
+        void destroy_texture(texture* t) final { backend->destroy_texture(t); }
+        vertex_buffer* create_vertex_buffer(const tri2* tris, std::size_t count) final
+        {
+            return backend->create_vertex_buffer(tris, count);
+        }
+        vertex_buffer* create_vertex_buffer(const mesh& m) final
+        {
+            return backend->create_vertex_buffer(m);
+        }
+        void destroy_vertex_buffer(vertex_buffer* buffer) final
+        {
+            backend->destroy_vertex_buffer(buffer);
+        }
+        render_target* create_render_target(std::uint32_t width,
+                                            std::uint32_t height) final
+        {
+            return backend->create_render_target(width, height);
+        }
+        void destroy_render_target(render_target* t) final
+        {
+            backend->destroy_render_target(t);
         }
-
-        texture* create_texture(std::string_view path) final
+        void set_render_target(render_target* t) final { backend->set_render_target(t); }
+        void clear(const color& c) final { backend->clear(c); }
+        bool request_readback() final { return backend->request_readback(); }
+        bool poll_readback(pixel_readback& out) final
         {
-            return new texture_gl_es20(path);
+            return backend->poll_readback(out);
         }
-        void destroy_texture(texture* t) final { delete t; }
-
-        void render(const tri0& t, const color& c) final
+        void render(const tri0& t, const color& c) final { backend->render(t, c); }
+        void render(const tri1& t) final { backend->render(t); }
+        void render(const tri2& t, texture* tex, const mat2x3& m) final
         {
-            shader00->use();
-            shader00->set_uniform("u_color", c);
-            // vertex coordinates
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(v0),
-                                  &t.v[0].p.x);
-            eng_GL_CHECK();
-            glEnableVertexAttribArray(0);
-            eng_GL_CHECK();
-
-            // texture coordinates
-            // glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(v0),
-            // &t.v[0].tx);
-            // eng_GL_CHECK();
-            // glEnableVertexAttribArray(1);
-            // eng_GL_CHECK();
-
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            eng_GL_CHECK();
+            backend->render(t, tex, m);
         }
-        void render(const tri1& t) final
+        void render(const vertex_buffer& b, texture* tex, const mat2x3& m) final
         {
-            shader01->use();
-            // positions
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(t.v[0]),
-                                  &t.v[0].p);
-            eng_GL_CHECK();
-            glEnableVertexAttribArray(0);
-            eng_GL_CHECK();
-            // colors
-            glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(t.v[0]),
-                                  &t.v[0].c);
-            eng_GL_CHECK();
-            glEnableVertexAttribArray(1);
-            eng_GL_CHECK();
-
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            eng_GL_CHECK();
-
-            glDisableVertexAttribArray(1);
-            eng_GL_CHECK();
+            backend->render(b, tex, m);
         }
-        void render(const tri2& t, texture* tex, const mat2x3& mat) final {
-            shader02->use();
-            auto * texture = dynamic_cast<texture_gl_es20*>(tex);
-            texture->bind();
-            shader02->set_uniform("s_texture", texture);
-            shader02->set_uniform("u_matrix", mat);
-            // positions
-            glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(t.v[0]), &t.v[0].p);
-            eng_GL_CHECK();
-            glEnableVertexAttribArray(0);
-            eng_GL_CHECK();
-            // colors
-            glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(t.v[0]), &t.v[0].c);
-            eng_GL_CHECK();
-            glEnableVertexAttribArray(1);
-            eng_GL_CHECK();
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(t.v[0]), &t.v[0].t_p);
-            eng_GL_CHECK();
-
-            glEnableVertexAttribArray(1);
-            eng_GL_CHECK();
-//            glVertexAttribPointer(5, 6, GL_FLOAT, GL_FALSE, sizeof(move), &move);
-//            eng_GL_CHECK();
-            glEnableVertexAttribArray(2);
-            eng_GL_CHECK();
-
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            eng_GL_CHECK();
-
-            glDisableVertexAttribArray(1);
-            eng_GL_CHECK();
-            glDisableVertexAttribArray(2);
-            eng_GL_CHECK();
+        void begin_batch() final { backend->begin_batch(); }
+        void submit(const tri2& t, texture* tex, const mat2x3& m) final
+        {
+            backend->submit(t, tex, m);
         }
-        void swap_buffers() final
+        void submit(const quad& q, texture* tex, const mat2x3& m) final
         {
-            SDL_GL_SwapWindow(window);
-
-            glClear(GL_COLOR_BUFFER_BIT);
-            eng_GL_CHECK();
+            backend->submit(q, tex, m);
+        }
+        void submit(const mesh& msh, texture* tex, const mat2x3& m) final
+        {
+            backend->submit(msh, tex, m);
+        }
+        void flush_batch() final { backend->flush_batch(); }
+        void render_instanced(const tri2* tris, std::size_t count, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            backend->render_instanced(tris, count, tex, instances, instance_count);
+        }
+        void render_instanced(const vertex_buffer& b, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            backend->render_instanced(b, tex, instances, instance_count);
+        }
+        void execute(const command_list* lists, std::size_t count) final
+        {
+            backend->execute(lists, count);
+        }
+        void swap_buffers() final { backend->swap_buffers(); }
+        state_stats get_state_stats() const final
+        {
+            return backend->get_state_stats();
+        }
+        frame_stats get_frame_stats() const final
+        {
+            return backend->get_frame_stats();
         }
         void uninitialize() final
         {
-            SDL_GL_DeleteContext(gl_context);
-            SDL_DestroyWindow(window);
-            SDL_Quit();
+            backend->uninitialize();
+            log_flush();
         }
 
     private:
-        SDL_Window*   window     = nullptr;
-        SDL_GLContext gl_context = nullptr;
-
-        shader_gl_es20* shader00 = nullptr;
-        shader_gl_es20* shader01 = nullptr;
-        shader_gl_es20* shader02 = nullptr;
+        std::unique_ptr<engine> backend;
     };
 
     static bool already_exist = false;
@@ -606,7 +2852,7 @@ namespace eng
         {
             throw std::runtime_error("engine already exist");
         }
-        engine* result = new engine_impl();
+        engine* result = new engine_proxy();
         already_exist  = true;
         return result;
     }
@@ -624,161 +2870,179 @@ namespace eng
         delete e;
     }
 
-    vec2 operator+(const vec2 &v1, const vec2 &v2) {
-        vec2 result;
-        result.x = v1.x + v2.x;
-        result.y = v1.y + v2.y;
-        return result;
-    }
-
-    vec2 operator*(const vec2 &v, const mat2x3 &m) {
-        vec2 result;
-        result.x = v.x * m.row1.x + v.y * m.row2.x;
-        result.y = v.x * m.row1.y + v.y * m.row2.y;
-        return result;
-    }
+    engine::~engine()
+    = default;
 
-    mat2x3 operator*(const mat2x3 &m1, const mat2x3 &m2) {
-        mat2x3 result;
-        result.row1.x = m1.row1.x * m2.row1.x + m1.row1.y * m2.row2.x;
-        result.row1.y = m1.row1.x * m2.row1.y + m1.row1.y * m2.row2.y;
-        result.row2.x = m1.row2.x * m2.row1.x + m1.row2.y * m2.row2.x;
-        result.row2.y = m1.row2.x * m2.row1.y + m1.row2.y * m2.row2.y;
-        result.delta.x = m1.delta.x * m2.row1.x + m1.delta.y * m2.row2.x + m2.delta.x;
-        result.delta.y = m1.delta.x * m2.row1.y + m1.delta.y * m2.row2.y + m2.delta.y;
-        return result;
-    }
+    texture_gl_es20::texture_gl_es20(std::string_view path): file_path(path) {
+        eng_LOG(debug, texture, "load {}", path);
+        const image img = load_png_image(path);
 
-    color::color(std::uint32_t rgba_)
-            : rgba(rgba_)
-    {
-    }
-    color::color(float r, float g, float b, float a)
-    {
-        assert(r <= 1 && r >= 0);
-        assert(g <= 1 && g >= 0);
-        assert(b <= 1 && b >= 0);
-        assert(a <= 1 && a >= 0);
+        glGenTextures(1, &tex_handl);
+        eng_GL_CHECK();
+        glBindTexture(GL_TEXTURE_2D, tex_handl);
+        eng_GL_CHECK();
 
-        auto r_ = static_cast<std::uint32_t>(r * 255);
-        auto g_ = static_cast<std::uint32_t>(g * 255);
-        auto b_ = static_cast<std::uint32_t>(b * 255);
-        auto a_ = static_cast<std::uint32_t>(a * 255);
+        GLint   mipmap_level = 0;
+        GLint   border       = 0;
+        width        = img.width;
+        height       = img.height;
+        glTexImage2D(GL_TEXTURE_2D, mipmap_level, GL_RGBA, width, height, border,
+                     GL_RGBA, GL_UNSIGNED_BYTE, &img.pixels[0]);
+        eng_GL_CHECK();
 
-        rgba = a_ << 24 | b_ << 16 | g_ << 8 | r_;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
     }
 
-    float color::get_r() const
-    {
-        std::uint32_t r_ = (rgba & 0x000000FF) >> 0;
-        return r_ / 255.f;
-    }
-    float color::get_g() const
-    {
-        std::uint32_t g_ = (rgba & 0x0000FF00) >> 8;
-        return g_ / 255.f;
-    }
-    float color::get_b() const
-    {
-        std::uint32_t b_ = (rgba & 0x00FF0000) >> 16;
-        return b_ / 255.f;
-    }
-    float color::get_a() const
+    texture_gl_es20::texture_gl_es20(std::shared_ptr<texture_request> request_,
+                                     GLuint placeholder_)
+        : file_path(request_->path)
+        , placeholder(placeholder_)
+        , status(texture_state::loading)
+        , request(std::move(request_))
     {
-        std::uint32_t a_ = (rgba & 0xFF000000) >> 24;
-        return a_ / 255.f;
     }
 
-    void color::set_r(const float r)
-    {
-        auto r_ = static_cast<std::uint32_t>(r * 255);
-        rgba &= 0xFFFFFF00;
-        rgba |= (r_ << 0);
-    }
-    void color::set_g(const float g)
+    texture_gl_es20::texture_gl_es20(std::uint32_t width_, std::uint32_t height_)
+        : file_path("atlas page")
+        , width(width_)
+        , height(height_)
     {
-        auto g_ = static_cast<std::uint32_t>(g * 255);
-        rgba &= 0xFFFF00FF;
-        rgba |= (g_ << 8);
+        // unused page space must sample transparent, not undefined memory
+        const std::vector<unsigned char> clear(std::size_t(width) * height * 4);
+
+        glGenTextures(1, &tex_handl);
+        eng_GL_CHECK();
+        glBindTexture(GL_TEXTURE_2D, tex_handl);
+        eng_GL_CHECK();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, clear.data());
+        eng_GL_CHECK();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
     }
-    void color::set_b(const float b)
+
+    void texture_gl_es20::paste(gl_state& state, const image& img,
+                                std::uint32_t x, std::uint32_t y)
     {
-        auto b_ = static_cast<std::uint32_t>(b * 255);
-        rgba &= 0xFF00FFFF;
-        rgba |= (b_ << 16);
+        assert(x + img.width <= width && y + img.height <= height);
+        state.bind_texture(0, tex_handl);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(x),
+                        static_cast<GLint>(y), img.width, img.height, GL_RGBA,
+                        GL_UNSIGNED_BYTE, img.pixels.data());
+        eng_GL_CHECK();
     }
-    void color::set_a(const float a)
+
+    texture_gl_es20::~texture_gl_es20()
     {
-        auto a_ = static_cast<std::uint32_t>(a * 255);
-        rgba &= 0x00FFFFFF;
-        rgba |= a_ << 24;
+        if (request)
+        {
+            request->cancelled = true;
+        }
+        if (tex_handl != 0)
+        {
+            glDeleteTextures(1, &tex_handl);
+            eng_GL_CHECK();
+        }
     }
 
-    engine::~engine()
-    = default;
-
-    texture_gl_es20::texture_gl_es20(std::string_view path): file_path(path) {
-        std::cout << path.data() << std::endl;
-        std::vector<unsigned char> png_file_in_memory;
-        std::ifstream              ifs(path.data(), std::ios_base::binary);
-        if (!ifs)
+    bool texture_gl_es20::upload_step(gl_state& state, std::size_t& budget)
+    {
+        if (!request->done.load(std::memory_order_acquire))
         {
-            throw std::runtime_error("can't load texture");
+            return false;
         }
-        ifs.seekg(0, std::ios_base::end);
-        std::streamoff pos_in_file = ifs.tellg();
-        png_file_in_memory.resize(static_cast<size_t>(pos_in_file));
-        ifs.seekg(0, std::ios_base::beg);
-        if (!ifs)
+        if (!request->error.empty())
         {
-            throw std::runtime_error("can't load texture1");
+            eng_LOG(error, texture, "{}: {}", file_path, request->error);
+            status = texture_state::failed;
+            request.reset();
+            return true;
         }
-
-        ifs.read(reinterpret_cast<char*>(png_file_in_memory.data()), pos_in_file);
-        if (!ifs.good())
+        const image& img = request->img;
+        if (tex_handl == 0)
         {
-            throw std::runtime_error("can't load texture3");
+            // storage first, rows are filled over next frames
+            glGenTextures(1, &tex_handl);
+            eng_GL_CHECK();
+            state.bind_texture(0, tex_handl);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img.width, img.height, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            eng_GL_CHECK();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            eng_GL_CHECK();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            eng_GL_CHECK();
         }
-
-        std::vector<unsigned char> image;
-        unsigned long              w = 0;
-        unsigned long              h = 0;
-        int error = decodePNG(image, w, h, &png_file_in_memory[0],
-                              png_file_in_memory.size(), false);
-
-        // if there's an error, display it
-        if (error != 0)
+        else
         {
-            std::cerr << "error: " << error << std::endl;
-            throw std::runtime_error("can't load texture2");
+            state.bind_texture(0, tex_handl);
         }
 
-        glGenTextures(1, &tex_handl);
-        eng_GL_CHECK();
-        glBindTexture(GL_TEXTURE_2D, tex_handl);
-        eng_GL_CHECK();
-
-        GLint   mipmap_level = 0;
-        GLint   border       = 0;
-        width        = static_cast<GLsizei>(w);
-        height       = static_cast<GLsizei>(h);
-        glTexImage2D(GL_TEXTURE_2D, mipmap_level, GL_RGBA, width, height, border,
-                     GL_RGBA, GL_UNSIGNED_BYTE, &image[0]);
-        eng_GL_CHECK();
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        eng_GL_CHECK();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        eng_GL_CHECK();
+        const std::size_t row_bytes = std::size_t(img.width) * 4;
+        const std::size_t rows      = std::min<std::size_t>(
+                std::max<std::size_t>(1, budget / std::max<std::size_t>(1, row_bytes)),
+                img.height - uploaded_rows);
+        if (rows != 0)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, static_cast<GLint>(uploaded_rows),
+                            img.width, static_cast<GLsizei>(rows), GL_RGBA,
+                            GL_UNSIGNED_BYTE,
+                            img.pixels.data() + uploaded_rows * row_bytes);
+            eng_GL_CHECK();
+        }
+        uploaded_rows += static_cast<std::uint32_t>(rows);
+        budget -= std::min(budget, rows * row_bytes);
+        if (uploaded_rows < img.height)
+        {
+            return false;
+        }
+        width  = img.width;
+        height = img.height;
+        status = texture_state::ready;
+        request.reset(); // frees decoded pixels
+        return true;
     }
 
-    texture_gl_es20::~texture_gl_es20() = default;
+    /// for current context; drivers may refuse, then their default stays
+    static void set_swap_interval(vsync_mode mode)
+    {
+        if (mode == vsync_mode::adaptive)
+        {
+            if (SDL_GL_SetSwapInterval(-1) == 0)
+            {
+                eng_LOG(info, gl, "vsync: adaptive");
+                return;
+            }
+            eng_LOG(info, gl, "no adaptive vsync ({}), using on", SDL_GetError());
+            mode = vsync_mode::on;
+        }
+        const bool on = mode == vsync_mode::on;
+        if (SDL_GL_SetSwapInterval(on ? 1 : 0) != 0)
+        {
+            eng_LOG(warn, gl, "can't turn vsync {}: {}", on ? "on" : "off",
+                    SDL_GetError());
+            return;
+        }
+        eng_LOG(info, gl, "vsync: {}", on ? "on" : "off");
+    }
 
-    std::string engine_impl::initialize(std::string_view) {
+    std::string engine_impl::initialize(std::string_view config_text) {
         using namespace std;
 
         stringstream serr;
 
+        engine_config config;
+        const string  config_error = parse_config(config_text, config);
+        if (!config_error.empty())
+        {
+            return config_error;
+        }
+
         SDL_version compiled = { 0, 0, 0 };
         SDL_version linked   = { 0, 0, 0 };
 
@@ -798,10 +3062,22 @@ namespace eng
             serr << "error: failed call SDL_Init: " << err_message << endl;
             return serr.str();
         }
+        // get_time_from_init counts from here
+        start_counter     = SDL_GetPerformanceCounter();
+        counter_frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+#if eng_GL_DEBUG
+        if (config.gl_debug == gl_debug_mode::callback)
+        {
+            // most drivers send debug messages only in debug contexts
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+        }
+#endif
 
         window =
                 SDL_CreateWindow("title", SDL_WINDOWPOS_CENTERED,
-                                 SDL_WINDOWPOS_CENTERED, 640, 480, ::SDL_WINDOW_OPENGL);
+                                 SDL_WINDOWPOS_CENTERED, static_cast<int>(config.width),
+                                 static_cast<int>(config.height), ::SDL_WINDOW_OPENGL);
 
         if (window == nullptr)
         {
@@ -820,13 +3096,16 @@ namespace eng
             return serr.str();
         }
 
+        set_swap_interval(config.vsync);
+
         int gl_major_ver = 0;
-        int result =
-                SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &gl_major_ver);
-        assert(result == 0);
         int gl_minor_ver = 0;
-        result = SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &gl_minor_ver);
-        assert(result == 0);
+        if (SDL_GL_GetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, &gl_major_ver) != 0 ||
+            SDL_GL_GetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, &gl_minor_ver) != 0)
+        {
+            serr << "error: can't get opengl version: " << SDL_GetError() << endl;
+            return serr.str();
+        }
 
         if (gl_major_ver <= 2 && gl_minor_ver < 1)
         {
@@ -859,14 +3138,72 @@ namespace eng
             load_gl_func("glUniform1i", glUniform1i);
             load_gl_func("glActiveTexture", glActiveTextureMY);
             load_gl_func("glUniform4fv", glUniform4fv);
+            load_gl_func("glUniform1f", glUniform1f);
             load_gl_func("glUniformMatrix3fv", glUniformMatrix3fv);
+            load_gl_func("glGetActiveUniform", glGetActiveUniform);
+            load_gl_func("glGetActiveAttrib", glGetActiveAttrib);
+            load_gl_func("glGetAttribLocation", glGetAttribLocation);
+            load_gl_func("glVertexAttrib4fv", glVertexAttrib4fv);
+            load_gl_func("glGenBuffers", glGenBuffers);
+            load_gl_func("glDeleteBuffers", glDeleteBuffers);
+            load_gl_func("glBindBuffer", glBindBuffer);
+            load_gl_func("glBufferData", glBufferData);
+            load_gl_func("glBufferSubData", glBufferSubData);
+            load_gl_func("glMapBuffer", glMapBuffer);
+            load_gl_func("glUnmapBuffer", glUnmapBuffer);
         }
         catch (std::exception& ex)
         {
             return ex.what();
         }
+        gl_debug_initialize(config.gl_debug, config.gl_debug_interval);
+        gpu.initialize(gl_major_ver, gl_minor_ver);
+        stream.initialize(state, std::size_t(config.stream_kb) * 1024, gl_major_ver,
+                          gl_minor_ver);
+        eng_LOG(info, gl, "vertex stream: {}",
+                stream.is_synced() ? "unsynchronized map" : "orphaning");
+        {
+            std::vector<std::uint16_t> indexes;
+            append_indexes(indexes, batch_mode::quads, 0, index_limit);
+            glGenBuffers(1, &quad_indexes);
+            eng_GL_CHECK();
+            state.bind_element_buffer(quad_indexes);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         static_cast<GLsizeiptr>(indexes.size() * sizeof(std::uint16_t)),
+                         indexes.data(), GL_STATIC_DRAW);
+            eng_GL_CHECK();
+        }
+        allow_packed = config.packed_vertexes != 0;
+        instancing   = config.instancing != 0 &&
+                     load_instancing(gl_major_ver, gl_minor_ver);
+        eng_LOG(info, gl, "instanced drawing: {}",
+                instancing ? "hardware" : "cpu expansion");
+        framebuffers = load_framebuffers(gl_major_ver, gl_minor_ver);
+        readbacks.initialize(stream.is_synced());
+        eng_LOG(info, gl, "render targets: {}, readback: {}",
+                framebuffers ? "yes" : "no",
+                stream.is_synced() ? "fenced" : "delayed two frames");
+        {
+            GLint viewport[4] = {};
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            eng_GL_CHECK();
+            window_width  = viewport[2];
+            window_height = viewport[3];
+        }
+        if (!config.program_cache.empty())
+        {
+            if (load_program_binary(gl_major_ver, gl_minor_ver))
+            {
+                programs = std::make_unique<program_cache>(config.program_cache);
+            }
+            else
+            {
+                eng_LOG(warn, gl, "program cache: context can't give program binaries");
+            }
+        }
+        const double programs_start = get_time_from_init();
 
-        shader00 = new shader_gl_es20(R"(
+        shader00 = new shader_gl_es20(state, R"(
                                   attribute vec2 a_position;
                                   void main()
                                   {
@@ -880,12 +3217,14 @@ namespace eng
                                   gl_FragColor = u_color;
                                   }
                                   )",
-                                      { { 0, "a_position" } });
+                                      { { 0, "a_position" } }, programs.get());
 
+        u_color00 = shader00->get_uniform<color>("u_color");
         shader00->use();
-        shader00->set_uniform("u_color", color(1.f, 0.f, 0.f, 1.f));
+        shader00->set_uniform(u_color00, color(1.f, 0.f, 0.f, 1.f));
 
         shader01 = new shader_gl_es20(
+                state,
                 R"(
                 attribute vec2 a_position;
                 attribute vec4 a_color;
@@ -903,11 +3242,12 @@ namespace eng
                 gl_FragColor = v_color;
                 }
                 )",
-                { { 0, "a_position" }, { 1, "a_color" } });
+                { { 0, "a_position" }, { 1, "a_color" } }, programs.get());
 
         shader01->use();
 
         shader02 = new shader_gl_es20(
+                state,
                 R"(
                 uniform mat3 u_matrix;
                 attribute vec2 a_position;
@@ -933,7 +3273,96 @@ namespace eng
                 }
                 )",
                 { { 0, "a_position" }, { 1, "a_color" }, { 2, "a_tex_coord" },
-                  { 3, "rotate" }, { 4, "scale" } });
+                  { 3, "rotate" }, { 4, "scale" } }, programs.get());
+        s_texture02 = shader02->get_uniform<texture_gl_es20*>("s_texture");
+        u_matrix02  = shader02->get_uniform<mat2x3>("u_matrix");
+
+        // same as shader02 but vertexes already transformed on cpu
+        shader03 = new shader_gl_es20(
+                state,
+                R"(
+                uniform float u_position_scale;
+                attribute vec2 a_position;
+                attribute vec2 a_tex_coord;
+                attribute vec4 a_color;
+                varying vec4 v_color;
+                varying vec2 v_tex_coord;
+                void main()
+                {
+                v_tex_coord = a_tex_coord;
+                v_color = a_color;
+                gl_Position = vec4(a_position * u_position_scale, 0.0, 1.0);
+                }
+                )",
+                R"(
+                varying vec2 v_tex_coord;
+                varying vec4 v_color;
+                uniform sampler2D s_texture;
+                void main()
+                {
+                gl_FragColor = texture2D(s_texture, v_tex_coord) * v_color;
+                }
+                )",
+                { { 0, "a_position" }, { 1, "a_color" }, { 2, "a_tex_coord" } }, programs.get());
+        s_texture03        = shader03->get_uniform<texture_gl_es20*>("s_texture");
+        u_position_scale03 = shader03->get_uniform<float>("u_position_scale");
+
+        // per instance attributes 3..6 advance once per instance (divisor
+        // set below), no other shader may bind them
+        shader04 = new shader_gl_es20(
+                state,
+                R"(
+                uniform float u_position_scale;
+                attribute vec2 a_position;
+                attribute vec2 a_tex_coord;
+                attribute vec4 a_color;
+                attribute vec4 a_matrix;
+                attribute vec2 a_delta;
+                attribute vec4 a_tint;
+                attribute vec4 a_uv_rect;
+                varying vec4 v_color;
+                varying vec2 v_tex_coord;
+                void main()
+                {
+                v_tex_coord = a_uv_rect.xy + a_tex_coord * a_uv_rect.zw;
+                v_color = a_color * a_tint;
+                vec2 position = mat2(a_matrix.xy, a_matrix.zw) *
+                                (a_position * u_position_scale) + a_delta;
+                gl_Position = vec4(position, 0.0, 1.0);
+                }
+                )",
+                R"(
+                varying vec2 v_tex_coord;
+                varying vec4 v_color;
+                uniform sampler2D s_texture;
+                void main()
+                {
+                gl_FragColor = texture2D(s_texture, v_tex_coord) * v_color;
+                }
+                )",
+                { { 0, "a_position" }, { 1, "a_color" }, { 2, "a_tex_coord" },
+                  { 3, "a_matrix" }, { 4, "a_delta" }, { 5, "a_tint" },
+                  { 6, "a_uv_rect" } }, programs.get());
+        s_texture04        = shader04->get_uniform<texture_gl_es20*>("s_texture");
+        u_position_scale04 = shader04->get_uniform<float>("u_position_scale");
+        {
+            int from_cache = 0;
+            for (const shader_gl_es20* shader :
+                 { shader00, shader01, shader02, shader03, shader04 })
+            {
+                from_cache += shader->from_cache() ? 1 : 0;
+            }
+            eng_LOG(info, gl, "shader programs ready in {} ms, {} of 5 from cache",
+                    (get_time_from_init() - programs_start) * 1000.0, from_cache);
+        }
+        if (instancing)
+        {
+            for (GLuint index = 3; index <= 6; ++index)
+            {
+                glVertexAttribDivisor(index, 1);
+                eng_GL_CHECK();
+            }
+        }
 
         // turn on rendering with just created shader program
         shader02->use();
@@ -946,49 +3375,38 @@ namespace eng
         glClearColor(0.f, 0.0, 0.f, 0.0f);
         eng_GL_CHECK();
 
-        return "";
-    }
-
-    vec2::vec2():
-            x(0.f),
-            y(0.f){}
-
-    vec2::vec2(float x_, float y_):
-            x(x_),
-            y(y_){}
-
-    mat2x3 mat2x3::identity() {
-        return mat2x3::scale(1.0f);
-    }
-
-    mat2x3 mat2x3::scale(float scal) {
-        mat2x3 result;
-        result.row1.x = scal;
-        result.row2.y = scal;
-        return result;
-    }
+        // async textures sample this until their pixels are uploaded
+        const std::uint32_t transparent = 0;
+        glGenTextures(1, &placeholder_texture);
+        eng_GL_CHECK();
+        state.bind_texture(0, placeholder_texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, &transparent);
+        eng_GL_CHECK();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        eng_GL_CHECK();
 
-    mat2x3 mat2x3::rotate(float alpha) {
-        mat2x3 result;
-        alpha = static_cast<float>(alpha * M_PI / 180.f);
-        result.row1.x = std::cos(alpha);
-        result.row1.y = -std::sin(alpha);
+        loader        = std::make_unique<texture_loader>(config.loader_threads);
+        upload_budget = std::size_t(config.upload_kb) * 1024;
+        trace         = config.trace;
+        trace_frames  = config.trace_frames;
+        atlas = std::make_unique<atlas_allocator>(config.atlas_size,
+                                                  config.atlas_padding);
 
-        result.row2.x = std::sin(alpha);
-        result.row2.y = std::cos(alpha);
-        return result;
-    }
+        for (const auto& [b, key_name] : config.keys)
+        {
+            if (!input.bind(b, key_name))
+            {
+                return "error: unknown SDL key name: " + key_name;
+            }
+        }
+        pacing.initialize(config.max_fps, config.spin_us);
+        // events raised while window was created, nothing drew them
+        input.pump();
 
-    mat2x3 mat2x3::move(vec2 delta) {
-        mat2x3 result;
-        result = identity();
-        result.delta = delta;
-        return result;
+        return "";
     }
 
-    mat2x3::mat2x3():
-        row1(0.f, 0.f),
-        row2(0.f, 0.f),
-        delta(0.f, 0.f){}
-
 } // end namespace eng
@@ -1,6 +1,13 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#include "math2d.hxx"
 
 #ifndef eng_DECLSPEC
 #define eng_DECLSPEC
@@ -33,64 +40,41 @@ namespace eng
                 turn_off
     };
 
+    std::string_view eng_DECLSPEC to_string(const event e);
     std::ostream& eng_DECLSPEC operator<<(std::ostream& stream, const event e);
 
-    class engine;
-
-/// return not null on success
-    engine* eng_DECLSPEC create_engine();
-    void eng_DECLSPEC destroy_engine(engine* e);
-
-    class eng_DECLSPEC color
+/// dendy gamepad buttons, same order as their events
+    enum class button
     {
-    public:
-        color() = default;
-        explicit color(std::uint32_t rgba_);
-        color(float r, float g, float b, float a);
-
-        float get_r() const;
-        float get_g() const;
-        float get_b() const;
-        float get_a() const;
-
-        void set_r(const float r);
-        void set_g(const float g);
-        void set_b(const float b);
-        void set_a(const float a);
-
-    private:
-        std::uint32_t rgba = 0;
+        left,
+        right,
+        up,
+        down,
+        select,
+        start,
+        button1,
+        button2
     };
 
-/// position in 2d space
-    struct eng_DECLSPEC vec2
-    {
-        vec2();
-        vec2(float x, float y);
-        float x = 0.f;
-        float y = 0.f;
-    };
+    constexpr std::size_t button_count = 8;
+/// held buttons, bit index is static_cast<std::size_t>(button)
+    using button_set = std::bitset<button_count>;
 
-
-    vec2 eng_DECLSPEC operator+(const vec2& v1, const vec2& v2);
-
-/// matrix for manipulate coordinates
-    struct eng_DECLSPEC mat2x3
+    constexpr event pressed_event(button b)
     {
-        mat2x3();
-        static mat2x3 identity();
-        static mat2x3 scale(float scal);
-        static mat2x3 rotate(float alpha);
-        static mat2x3 move(vec2 delta);
-        vec2 row1;
-        vec2 row2;
-        vec2 delta;
-    };
+        return static_cast<event>(static_cast<int>(b) * 2);
+    }
+    constexpr event released_event(button b)
+    {
+        return static_cast<event>(static_cast<int>(b) * 2 + 1);
+    }
 
-    vec2 eng_DECLSPEC operator*(const vec2& mat1, const mat2x3& m);
+    class engine;
+    class command_list;
 
-    vec2 eng_DECLSPEC operator*(const vec2& v, const mat2x3& m);
-    mat2x3 eng_DECLSPEC operator*(const mat2x3& m1, const mat2x3& m2);
+/// return not null on success
+    engine* eng_DECLSPEC create_engine();
+    void eng_DECLSPEC destroy_engine(engine* e);
 
 /// vertex with position only
     struct eng_DECLSPEC v0
@@ -134,6 +118,39 @@ namespace eng
         v2 v[3];
     };
 
+/// textured rectangle (or any convex 4-gon) as 4 vertexes instead of 6
+/// of two tri2: drawn as triangles 0 1 2 and 0 2 3
+    struct eng_DECLSPEC quad
+    {
+        quad();
+        v2 v[4];
+    };
+
+/// indexed triangles: every 3 indexes pick vertexes of one triangle,
+/// vertex shared by several triangles is stored and transformed once
+    struct eng_DECLSPEC mesh
+    {
+        std::vector<v2>            vertexes;
+        std::vector<std::uint16_t> indexes;
+    };
+
+/// merge bitwise equal vertexes of tris, triangle order is kept
+/// return false when more than 65536 vertexes stay (16 bit indexes)
+    bool eng_DECLSPEC make_mesh(const tri2* tris, std::size_t count, mesh& out);
+
+/// one copy of mesh drawn by engine::render_instanced
+    struct eng_DECLSPEC sprite_instance
+    {
+        /// same as matrix of render(tri2)
+        mat2x3 m;
+        /// multiplies vertex colors
+        color tint{ 0xFFFFFFFF };
+        /// mesh texture coordinates t go to uv_origin + t * uv_size,
+        /// e.g. one frame of sprite sheet
+        vec2 uv_origin{ 0.f, 0.f };
+        vec2 uv_size{ 1.f, 1.f };
+    };
+
     std::istream& eng_DECLSPEC operator>>(std::istream& is, color&);
     std::istream& eng_DECLSPEC operator>>(std::istream& is, v0&);
     std::istream& eng_DECLSPEC operator>>(std::istream& is, v1&);
@@ -142,12 +159,100 @@ namespace eng
     std::istream& eng_DECLSPEC operator>>(std::istream& is, tri1&);
     std::istream& eng_DECLSPEC operator>>(std::istream& is, tri2&);
 
+/// gl calls made and dropped as redundant during one frame
+    struct eng_DECLSPEC state_stats
+    {
+        std::uint32_t program_changes = 0;
+        std::uint32_t program_skipped = 0;
+        std::uint32_t texture_changes = 0;
+        std::uint32_t texture_skipped = 0;
+        std::uint32_t attrib_changes  = 0;
+        std::uint32_t attrib_skipped  = 0;
+        std::uint32_t uniform_changes = 0;
+        std::uint32_t uniform_skipped = 0;
+        std::uint32_t buffer_changes  = 0;
+        std::uint32_t buffer_skipped  = 0;
+        /// vertex, index and instance data streamed to gpu
+        std::uint64_t vertex_bytes = 0;
+    };
+
+    std::ostream& eng_DECLSPEC operator<<(std::ostream& stream,
+                                          const state_stats& s);
+
+/// frame pacing since initialize, times in ms
+    struct eng_DECLSPEC frame_stats
+    {
+        /// frame time is taken between returns from buffer swap
+        std::uint32_t frames  = 0;
+        double        mean_ms = 0.0;
+        double        p50_ms  = 0.0;
+        double        p90_ms  = 0.0;
+        double        p99_ms  = 0.0;
+        double        max_ms  = 0.0;
+        /// mean per frame slept or spun by max_fps limiter
+        double wait_ms = 0.0;
+        /// estimate from input event to return from swap of frame that
+        /// saw it; display may show frame up to one refresh later
+        std::uint32_t latency_samples = 0;
+        double        latency_mean_ms = 0.0;
+        double        latency_max_ms  = 0.0;
+    };
+
+    std::ostream& eng_DECLSPEC operator<<(std::ostream& stream,
+                                          const frame_stats& s);
+
+/// life of texture from engine::create_texture_async
+    enum class texture_state
+    {
+        /// file is read, decoded or uploaded, placeholder is drawn instead
+        loading,
+        ready,
+        /// file missing or bad, placeholder stays
+        failed
+    };
+
+/// triangles uploaded once (static gl buffer) and drawn many times,
+/// see engine::create_vertex_buffer
+    class eng_DECLSPEC vertex_buffer
+    {
+    public:
+        virtual ~vertex_buffer();
+        /// vertexes drawn: 3 per triangle, index count for meshes
+        virtual std::size_t size() const = 0;
+    };
+
     class eng_DECLSPEC texture
     {
     public:
         virtual ~texture();
+        /// 0 while loading
         virtual std::uint32_t get_width() const  = 0;
         virtual std::uint32_t get_height() const = 0;
+        /// create_texture gives ready textures only
+        virtual texture_state get_state() const = 0;
+    };
+
+/// offscreen rgba color buffer, see engine::set_render_target
+    class eng_DECLSPEC render_target
+    {
+    public:
+        virtual ~render_target();
+        /// what was drawn into target, row 0 is bottom of it (texture
+        /// coordinate y 0 is ndc y -1). Owned by target: never pass it to
+        /// destroy_texture, don't draw with it while target is bound
+        virtual texture* get_texture() = 0;
+    };
+
+/// pixels of render target copied back to cpu, see engine::request_readback
+    struct eng_DECLSPEC pixel_readback
+    {
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+        /// rgba, first row is top of picture (as image); empty when
+        /// readback failed (error is logged)
+        std::vector<std::uint8_t> pixels;
+        /// swap_buffers calls before request
+        std::uint64_t frame = 0;
     };
 
     class eng_DECLSPEC engine
@@ -155,19 +260,103 @@ namespace eng
     public:
         virtual ~engine();
         /// create main window
+        /// config: "key=value" list, see engine_config.hxx
+        /// "backend=software" selects headless cpu rasterizer
         /// on success return empty string
         virtual std::string initialize(std::string_view config) = 0;
-        /// return seconds from initialization
-        virtual float get_time_from_init() = 0;
-        /// pool event from input queue
-        /// return true if more events in queue
+        /// return seconds from initialization, high resolution counter
+        /// (sub-microsecond, double keeps it for days of uptime)
+        virtual double get_time_from_init() = 0;
+        /// pop event from input queue, filled once per frame (on
+        /// initialize and swap_buffers) without key repeat events
+        /// return false when queue is empty
         virtual bool read_input(event& e)                      = 0;
+        /// buttons held at last input pump; poll this for movement
+        virtual button_set get_held_buttons() const = 0;
+        /// map physical key to button, previous key of button is unbound
+        /// key_name: SDL scancode name ("W", "Up", "Space", "Left Ctrl")
+        /// return false for unknown key name
+        virtual bool bind_key(button b, std::string_view key_name) = 0;
         virtual texture* create_texture(std::string_view path) = 0;
+        /// return at once, file read and png decode run on loader threads,
+        /// upload is spread over swap_buffers calls ("upload_kb" per frame).
+        /// Until get_state() is ready texture draws as one transparent pixel
+        virtual texture* create_texture_async(std::string_view path) = 0;
+        /// put image into shared atlas page ("atlas_size", "atlas_padding"),
+        /// texture coordinates of tri2 drawn with result are mapped into the
+        /// page, so textures of one page batch into one draw call.
+        /// Coordinates must stay in [0, 1]: atlas textures do not repeat.
+        /// Pages live until uninitialize
+        virtual texture* create_atlas_texture(std::string_view path) = 0;
+        /// create_atlas_texture with decode on loader threads, image goes
+        /// into page in swap_buffers once decoded (counts against
+        /// "upload_kb"). Until get_state() is ready texture draws as one
+        /// transparent pixel and get_width() is 0
+        virtual texture* create_atlas_texture_async(std::string_view path) = 0;
         virtual void destroy_texture(texture* t)               = 0;
+        /// for meshes that don't change, render(tri2) streams its
+        /// vertexes again on every call; count 0 gives buffer drawing
+        /// nothing
+        virtual vertex_buffer* create_vertex_buffer(const tri2* tris,
+                                                    std::size_t count) = 0;
+        /// static vertex and index buffers, shared vertexes are drawn once
+        virtual vertex_buffer* create_vertex_buffer(const mesh& m) = 0;
+        virtual void destroy_vertex_buffer(vertex_buffer* buffer) = 0;
         virtual void render(const tri0&, const color&) = 0;
         virtual void render(const tri1&) = 0;
         virtual void render(const tri2&, texture*, const mat2x3&) = 0;
+        virtual void render(const vertex_buffer&, texture*, const mat2x3&) = 0;
+        /// start collecting textured triangles into one vertex stream
+        virtual void begin_batch() = 0;
+        /// transform triangle on cpu and append it to current batch
+        /// texture change draws collected vertexes first
+        virtual void submit(const tri2&, texture*, const mat2x3&) = 0;
+        /// 4 vertexes, batches of quads only share one static index buffer
+        virtual void submit(const quad&, texture*, const mat2x3&) = 0;
+        /// vertexes of mesh and its indexes are appended to batch
+        virtual void submit(const mesh&, texture*, const mat2x3&) = 0;
+        /// draw everything collected since begin_batch
+        virtual void flush_batch() = 0;
+        /// draw count tris once per instance in one call; gl backend uses
+        /// hardware instancing when context has it, else expands on cpu.
+        /// Draws batch collected so far first
+        virtual void render_instanced(const tri2* tris, std::size_t count,
+                                      texture* tex, const sprite_instance* instances,
+                                      std::size_t instance_count) = 0;
+        virtual void render_instanced(const vertex_buffer& buffer, texture* tex,
+                                      const sprite_instance* instances,
+                                      std::size_t instance_count) = 0;
+        /// width x height texture to draw into; throw std::runtime_error
+        /// when context can't render to textures
+        virtual render_target* create_render_target(std::uint32_t width,
+                                                    std::uint32_t height) = 0;
+        /// current target is switched back to window first
+        virtual void destroy_render_target(render_target* target) = 0;
+        /// following draws go to target, nullptr - window. Draws batch
+        /// collected so far first, batching goes on in new target; target
+        /// stays bound after swap_buffers
+        virtual void set_render_target(render_target* target) = 0;
+        /// fill current render target with c; swap_buffers clears window
+        /// (only) to transparent black whatever target is bound
+        virtual void clear(const color& c) = 0;
+        /// queue copy of current render target as it is after draws so far
+        /// (call before swap_buffers for window) and return at once.
+        /// False when 3 earlier readbacks still wait for poll_readback
+        virtual bool request_readback() = 0;
+        /// oldest finished readback, in request order; false when none is
+        /// done yet. Gl backend finishes them frames later, so neither cpu
+        /// nor gpu waits: poll once per frame. Failed one is returned too,
+        /// with empty pixels
+        virtual bool poll_readback(pixel_readback& out) = 0;
+        /// merge lists recorded on any threads, sort them by state and
+        /// draw on this (gl) thread; lists must not change meanwhile.
+        /// Ends batch started by begin_batch
+        virtual void execute(const command_list* lists, std::size_t count) = 0;
         virtual void swap_buffers() = 0;
+        /// counters of previous frame (updated in swap_buffers)
+        virtual state_stats get_state_stats() const = 0;
+        /// frame time histogram summary and input latency estimate
+        virtual frame_stats get_frame_stats() const = 0;
         virtual void uninitialize() = 0;
     };
 
@@ -0,0 +1,169 @@
+#include "engine_config.hxx"
+
+#include <algorithm>
+#include <charconv>
+
+namespace eng
+{
+
+    static bool parse_number(std::string_view value, std::uint32_t& out)
+    {
+        const char* last = value.data() + value.size();
+        auto [ptr, ec]   = std::from_chars(value.data(), last, out);
+        return ec == std::errc() && ptr == last;
+    }
+
+    std::string parse_config(std::string_view text, engine_config& out)
+    {
+        constexpr std::string_view separators = " \t\n;";
+        engine_config              result;
+        while (!text.empty())
+        {
+            const std::size_t begin = text.find_first_not_of(separators);
+            if (begin == std::string_view::npos)
+            {
+                break;
+            }
+            text                  = text.substr(begin);
+            const std::size_t end = text.find_first_of(separators);
+            const std::string_view item = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view() : text.substr(end);
+
+            const std::size_t eq = item.find('=');
+            if (eq == std::string_view::npos)
+            {
+                return "error: config item without '=': " + std::string(item);
+            }
+            const std::string_view key   = item.substr(0, eq);
+            const std::string_view value = item.substr(eq + 1);
+
+            bool valid = true;
+            if (key == "backend")
+            {
+                valid          = value == "gl" || value == "software";
+                result.backend = value;
+            }
+            else if (key == "width")
+            {
+                valid = parse_number(value, result.width) && result.width > 0;
+            }
+            else if (key == "height")
+            {
+                valid = parse_number(value, result.height) && result.height > 0;
+            }
+            else if (key == "threads")
+            {
+                valid = parse_number(value, result.threads);
+            }
+            else if (key == "frames")
+            {
+                valid = parse_number(value, result.frames);
+            }
+            else if (key == "output")
+            {
+                result.output = value;
+            }
+            else if (key == "loader_threads")
+            {
+                valid = parse_number(value, result.loader_threads);
+            }
+            else if (key == "upload_kb")
+            {
+                valid = parse_number(value, result.upload_kb) && result.upload_kb > 0;
+            }
+            else if (key == "stream_kb")
+            {
+                valid = parse_number(value, result.stream_kb) && result.stream_kb > 0;
+            }
+            else if (key == "atlas_size")
+            {
+                valid = parse_number(value, result.atlas_size) && result.atlas_size > 0;
+            }
+            else if (key == "atlas_padding")
+            {
+                valid = parse_number(value, result.atlas_padding);
+            }
+            else if (key == "trace")
+            {
+                result.trace = value;
+            }
+            else if (key == "program_cache")
+            {
+                result.program_cache = value;
+            }
+            else if (key == "gl_debug")
+            {
+                valid = parse_gl_debug_mode(value, result.gl_debug);
+            }
+            else if (key == "gl_debug_interval")
+            {
+                valid = parse_number(value, result.gl_debug_interval) &&
+                        result.gl_debug_interval > 0;
+            }
+            else if (key == "instancing")
+            {
+                valid = parse_number(value, result.instancing) && result.instancing <= 1;
+            }
+            else if (key == "packed_vertexes")
+            {
+                valid = parse_number(value, result.packed_vertexes) &&
+                        result.packed_vertexes <= 1;
+            }
+            else if (key == "trace_frames")
+            {
+                valid = parse_number(value, result.trace_frames) &&
+                        result.trace_frames > 0;
+            }
+            else if (key == "vsync")
+            {
+                valid = parse_vsync_mode(value, result.vsync);
+            }
+            else if (key == "max_fps")
+            {
+                valid = parse_number(value, result.max_fps);
+            }
+            else if (key == "spin_us")
+            {
+                valid = parse_number(value, result.spin_us);
+            }
+            else if (key == "log")
+            {
+                log_level level{};
+                valid = parse_log_level(value, level);
+                result.log_levels.fill(level);
+            }
+            else if (key == "log_file")
+            {
+                result.log_file = value;
+            }
+            else if (key.substr(0, 4) == "log_")
+            {
+                log_category category{};
+                log_level    level{};
+                valid = parse_log_category(key.substr(4), category) &&
+                        parse_log_level(value, level);
+                result.log_levels[static_cast<std::size_t>(category)] = level;
+            }
+            else if (key.substr(0, 4) == "key_")
+            {
+                button b{};
+                valid = parse_button(key.substr(4), b) && !value.empty();
+                std::string name(value);
+                std::replace(name.begin(), name.end(), '_', ' ');
+                result.keys.emplace_back(b, std::move(name));
+            }
+            else
+            {
+                return "error: unknown config key: " + std::string(key);
+            }
+            if (!valid)
+            {
+                return "error: bad value for " + std::string(key) + ": " +
+                       std::string(value);
+            }
+        }
+        out = result;
+        return "";
+    }
+
+} // end namespace eng
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "frame_pacing.hxx"
+#include "gl_debug.hxx"
+#include "input.hxx"
+#include "log.hxx"
+
+namespace eng
+{
+
+/// options of engine::initialize(config)
+/// config is list of key=value separated by spaces or ';'
+/// example: "backend=software width=320 height=240 frames=600"
+    struct engine_config
+    {
+        /// gl - SDL window with OpenGL, software - headless cpu rasterizer
+        std::string   backend = "gl";
+        std::uint32_t width   = 640;
+        std::uint32_t height  = 480;
+        /// software backend: raster threads, 0 - one per core
+        std::uint32_t threads = 0;
+        /// software backend: send turn_off after this many frames, 0 - never
+        std::uint32_t frames = 0;
+        /// software backend: write last frame as ppm on uninitialize
+        std::string output;
+        /// threads decoding textures for create_texture_async,
+        /// 0 - one per core except the render one
+        std::uint32_t loader_threads = 0;
+        /// gl backend: texture data uploaded per frame in KB, at least one
+        /// row of a texture goes each frame
+        std::uint32_t upload_kb = 1024;
+        /// gl backend: ring buffer for streamed vertexes in KB, grows when
+        /// one draw needs more
+        std::uint32_t stream_kb = 4096;
+        /// side of square atlas page for create_atlas_texture
+        std::uint32_t atlas_size = 2048;
+        /// pixels around every atlas image repeating its edge
+        std::uint32_t atlas_padding = 1;
+        /// write profile of last trace_frames frames as chrome trace json
+        /// on uninitialize (needs build with eng_PROFILE, see profiler.hxx)
+        std::string   trace;
+        std::uint32_t trace_frames = 120;
+        /// gl backend error checks in eng_GL_DEBUG builds: callback (falls
+        /// back to frame without debug extension), poll, frame or off
+        gl_debug_mode gl_debug = gl_debug_mode::callback;
+        /// poll mode: glGetError on every N-th checked gl call
+        std::uint32_t gl_debug_interval = 64;
+        /// gl backend: 0 - render_instanced expands on cpu even when
+        /// context supports instancing
+        std::uint32_t instancing = 1;
+        /// gl backend: 0 - stream vertexes as float even when they fit
+        /// 12 byte v2_packed (see vertex_layout.hxx)
+        std::uint32_t packed_vertexes = 1;
+        /// gl backend: directory keeping linked shader programs as driver
+        /// binaries (needs ARB_get_program_binary), empty - compile every
+        /// start
+        std::string program_cache;
+        /// gl backend: key_<button>=<SDL key name> replaces default key of
+        /// button (key_up=Up key_button1=Right_Ctrl), '_' stands for space
+        std::vector<std::pair<button, std::string>> keys;
+        /// log=<level> sets every category, log_<category>=<level> one of
+        /// them (log=warn log_gl=debug); levels: trace debug info warn
+        /// error off
+        std::array<log_level, log_category_count> log_levels{
+            { log_level::info, log_level::info, log_level::info, log_level::info,
+              log_level::info }
+        };
+        /// gl backend: swap interval, see vsync_mode
+        vsync_mode vsync = vsync_mode::on;
+        /// frame cap, 0 - none (vsync alone paces frames)
+        std::uint32_t max_fps = 0;
+        /// limiter spins with yield this last part of wait instead of
+        /// sleeping, in microseconds: sleep is cheap but wakes late
+        std::uint32_t spin_us = 1500;
+        /// write log to file instead of stderr
+        std::string log_file;
+    };
+
+/// on success return empty string, otherwise error description
+    std::string parse_config(std::string_view text, engine_config& out);
+
+} // end namespace eng
@@ -0,0 +1,945 @@
+#include "engine_soft.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "atlas.hxx"
+#include "command_list.hxx"
+#include "engine_config.hxx"
+#include "frame_pacing.hxx"
+#include "image.hxx"
+#include "log.hxx"
+#include "profiler.hxx"
+#include "texture_loader.hxx"
+#include "transform.hxx"
+#include "worker_pool.hxx"
+
+namespace eng
+{
+
+    class texture_soft final : public texture
+    {
+    public:
+        explicit texture_soft(std::string_view path)
+            : img(load_png_image(path))
+        {
+        }
+        /// async load, samples one transparent pixel until adopt
+        explicit texture_soft(std::shared_ptr<texture_request> request_)
+            : img{ std::vector<unsigned char>(4, 0), 1, 1 }
+            , status(texture_state::loading)
+            , request(std::move(request_))
+        {
+        }
+        /// transparent atlas page, images are pasted in later
+        texture_soft(std::uint32_t width, std::uint32_t height)
+            : img{ std::vector<unsigned char>(std::size_t(width) * height * 4, 0),
+                   width, height }
+        {
+        }
+        ~texture_soft() override
+        {
+            if (request)
+            {
+                request->cancelled = true;
+            }
+        }
+
+        std::uint32_t get_width() const final
+        {
+            return status == texture_state::ready ? img.width : 0;
+        }
+        std::uint32_t get_height() const final
+        {
+            return status == texture_state::ready ? img.height : 0;
+        }
+        texture_state get_state() const final { return status; }
+
+        /// take decoded image if loader is done, return true when done
+        bool adopt()
+        {
+            if (!request->done.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (request->error.empty())
+            {
+                img    = std::move(request->img);
+                status = texture_state::ready;
+            }
+            else
+            {
+                eng_LOG(error, texture, "{}: {}", request->path, request->error);
+                status = texture_state::failed;
+            }
+            request.reset();
+            return true;
+        }
+
+        /// copy src into texture with top left corner at x, y
+        void paste(const image& src, std::uint32_t x, std::uint32_t y)
+        {
+            copy_image(src, img, x, y);
+        }
+
+        /// take rendered surface, row 0 top; stored bottom row first as
+        /// gl framebuffer texture is
+        void copy_surface(const std::uint32_t* pixels)
+        {
+            for (std::uint32_t y = 0; y < img.height; ++y)
+            {
+                const std::uint32_t* src = &pixels[std::size_t(img.height - 1 - y) * img.width];
+                unsigned char*       dst = &img.pixels[std::size_t(y) * img.width * 4];
+                for (std::uint32_t x = 0; x < img.width; ++x)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        dst[x * 4 + c] = static_cast<unsigned char>(src[x] >> (c * 8));
+                    }
+                }
+            }
+        }
+
+        /// nearest filter, repeat wrap (gl defaults used by gl backend)
+        const unsigned char* sample(float u, float v) const
+        {
+            const float   fu = u - std::floor(u);
+            const float   fv = v - std::floor(v);
+            std::uint32_t x  = static_cast<std::uint32_t>(fu * img.width);
+            std::uint32_t y  = static_cast<std::uint32_t>(fv * img.height);
+            x                = std::min(x, img.width - 1);
+            y                = std::min(y, img.height - 1);
+            return &img.pixels[(std::size_t(y) * img.width + x) * 4];
+        }
+
+    private:
+        image         img;
+        texture_state status = texture_state::ready;
+
+        std::shared_ptr<texture_request> request;
+    };
+
+    /// image placed into atlas page, samples page texture
+    struct atlas_texture_soft final : public texture
+    {
+        atlas_texture_soft(const texture_soft* page_, const uv_remap& remap_,
+                           std::uint32_t width_, std::uint32_t height_)
+            : page(page_)
+            , remap(remap_)
+            , width(width_)
+            , height(height_)
+        {
+        }
+        /// async load, samples transparent placeholder page until placed
+        atlas_texture_soft(std::shared_ptr<texture_request> request_,
+                           const texture_soft*              placeholder)
+            : page(placeholder)
+            , status(texture_state::loading)
+            , request(std::move(request_))
+        {
+        }
+        ~atlas_texture_soft() override
+        {
+            if (request)
+            {
+                request->cancelled = true;
+            }
+        }
+
+        std::uint32_t get_width() const final { return width; }
+        std::uint32_t get_height() const final { return height; }
+        texture_state get_state() const final { return status; }
+
+        const texture_soft* page;
+        uv_remap            remap;
+        std::uint32_t       width  = 0;
+        std::uint32_t       height = 0;
+        texture_state       status = texture_state::ready;
+        /// set while async load is in flight
+        std::shared_ptr<texture_request> request;
+    };
+
+    /// pixels triangles are rasterized into, RGBA same byte order as color
+    struct surface
+    {
+        std::uint32_t              width  = 0;
+        std::uint32_t              height = 0;
+        std::vector<std::uint32_t> pixels;
+        /// cleared by tiles lazily on next rasterize
+        bool clear_pending = true;
+    };
+
+    /// render target keeps its surface and texture sampling it, texture is
+    /// updated when drawing leaves target
+    struct render_target_soft final : public render_target
+    {
+        render_target_soft(std::uint32_t width, std::uint32_t height)
+            : color(width, height)
+        {
+            canvas.width  = width;
+            canvas.height = height;
+            canvas.pixels.assign(std::size_t(width) * height, 0);
+            // kept between frames as gl framebuffer is
+            canvas.clear_pending = false;
+        }
+        texture* get_texture() final { return &color; }
+
+        surface      canvas;
+        texture_soft color;
+    };
+
+    /// triangle in framebuffer pixels, y goes down
+    struct raster_tri
+    {
+        float               x[3];
+        float               y[3];
+        float               u[3];
+        float               v[3];
+        float               rgba[3][4];
+        const texture_soft* tex = nullptr;
+    };
+
+    struct vertex_buffer_soft final : public vertex_buffer
+    {
+        vertex_buffer_soft(const tri2* tris_, std::size_t count)
+            : tris(tris_, tris_ + count)
+        {
+        }
+        /// rasterizer takes triangles, shared vertexes are copied
+        explicit vertex_buffer_soft(const mesh& m)
+            : tris(m.indexes.size() / 3)
+        {
+            for (std::size_t i = 0; i < tris.size() * 3; ++i)
+            {
+                tris[i / 3].v[i % 3] = m.vertexes[m.indexes[i]];
+            }
+        }
+        std::size_t size() const final { return tris.size() * 3; }
+
+        std::vector<tri2> tris;
+    };
+
+    class engine_soft final : public engine
+    {
+    public:
+        std::string initialize(std::string_view config_text) final
+        {
+            std::string error = parse_config(config_text, config);
+            if (!error.empty())
+            {
+                return error;
+            }
+            width  = config.width;
+            height = config.height;
+            pixels.assign(std::size_t(width) * height, 0);
+            clear_pending = true;
+
+            unsigned threads = config.threads;
+            if (threads == 0)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            workers = std::make_unique<worker_pool>(threads - 1);
+            loader  = std::make_unique<texture_loader>(config.loader_threads);
+            atlas   = std::make_unique<atlas_allocator>(config.atlas_size,
+                                                      config.atlas_padding);
+
+            resize_tiles();
+
+            // no window to sync with, max_fps alone paces frames
+            pacing.initialize(config.max_fps, config.spin_us);
+            start = std::chrono::steady_clock::now();
+            return "";
+        }
+
+        double get_time_from_init() final
+        {
+            std::chrono::duration<double> seconds =
+                    std::chrono::steady_clock::now() - start;
+            return seconds.count();
+        }
+
+        /// no window - no input, only turn_off after frame limit
+        bool read_input(event& e) final
+        {
+            if (config.frames != 0 && frame_count >= config.frames &&
+                !turn_off_sent)
+            {
+                turn_off_sent = true;
+                e             = event::turn_off;
+                return true;
+            }
+            return false;
+        }
+        button_set get_held_buttons() const final { return button_set(); }
+        /// nothing to bind without keyboard
+        bool bind_key(button, std::string_view) final { return true; }
+
+        texture* create_texture(std::string_view path) final
+        {
+            return new texture_soft(path);
+        }
+        texture* create_texture_async(std::string_view path) final
+        {
+            auto* result = new texture_soft(loader->load(path));
+            pending.push_back(result);
+            return result;
+        }
+        texture* create_atlas_texture(std::string_view path) final
+        {
+            const image         img  = load_png_image(path);
+            const texture_soft* page = nullptr;
+            const uv_remap      remap = paste_into_atlas(img, page);
+            return new atlas_texture_soft(page, remap, img.width, img.height);
+        }
+        texture* create_atlas_texture_async(std::string_view path) final
+        {
+            if (!atlas_placeholder)
+            {
+                // 1x1 transparent, loading images sample it
+                atlas_placeholder = std::make_unique<texture_soft>(1, 1);
+            }
+            auto* result =
+                    new atlas_texture_soft(loader->load(path), atlas_placeholder.get());
+            atlas_pending.push_back(result);
+            return result;
+        }
+        void destroy_texture(texture* t) final
+        {
+            pending.erase(std::remove(pending.begin(), pending.end(), t),
+                          pending.end());
+            atlas_pending.erase(
+                    std::remove(atlas_pending.begin(), atlas_pending.end(), t),
+                    atlas_pending.end());
+            delete t;
+        }
+
+        vertex_buffer* create_vertex_buffer(const tri2* tris, std::size_t count) final
+        {
+            return new vertex_buffer_soft(tris, count);
+        }
+        vertex_buffer* create_vertex_buffer(const mesh& m) final
+        {
+            return new vertex_buffer_soft(m);
+        }
+        void destroy_vertex_buffer(vertex_buffer* buffer) final { delete buffer; }
+        render_target* create_render_target(std::uint32_t w, std::uint32_t h) final
+        {
+            return new render_target_soft(w, h);
+        }
+        void destroy_render_target(render_target* t) final
+        {
+            if (t == target)
+            {
+                set_render_target(nullptr);
+            }
+            delete t;
+        }
+        void set_render_target(render_target* t) final
+        {
+            auto* next = static_cast<render_target_soft*>(t);
+            if (next == target)
+            {
+                return;
+            }
+            flush();
+            swap_surface(target != nullptr ? target->canvas : window);
+            if (target != nullptr)
+            {
+                target->color.copy_surface(target->canvas.pixels.data());
+            }
+            target = next;
+            swap_surface(target != nullptr ? target->canvas : window);
+            resize_tiles();
+        }
+        void clear(const color& c) final
+        {
+            flush();
+            std::uint32_t packed = 0;
+            const float   rgba[4] = { c.get_r(), c.get_g(), c.get_b(), c.get_a() };
+            for (int i = 0; i < 4; ++i)
+            {
+                packed |= static_cast<std::uint32_t>(
+                                  std::clamp(rgba[i], 0.f, 1.f) * 255.f + 0.5f)
+                          << (i * 8);
+            }
+            std::fill(pixels.begin(), pixels.end(), packed);
+            clear_pending = false;
+        }
+        /// no gpu to wait for, copied right away and handed out by poll
+        bool request_readback() final
+        {
+            if (readbacks.size() >= 3)
+            {
+                return false;
+            }
+            flush();
+            pixel_readback& r = readbacks.emplace_back();
+            r.width           = width;
+            r.height          = height;
+            r.frame           = frame_count;
+            r.pixels.resize(pixels.size() * 4);
+            for (std::size_t i = 0; i < pixels.size(); ++i)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    r.pixels[i * 4 + c] =
+                            static_cast<std::uint8_t>(pixels[i] >> (c * 8));
+                }
+            }
+            return true;
+        }
+        bool poll_readback(pixel_readback& out) final
+        {
+            if (readbacks.empty())
+            {
+                return false;
+            }
+            out = std::move(readbacks.front());
+            readbacks.pop_front();
+            return true;
+        }
+        void render(const tri0& t, const color& c) final
+        {
+            raster_tri r;
+            for (int i = 0; i < 3; ++i)
+            {
+                set_position(r, i, t.v[i].p);
+                set_color(r, i, c);
+            }
+            push(r);
+        }
+        void render(const tri1& t) final
+        {
+            raster_tri r;
+            for (int i = 0; i < 3; ++i)
+            {
+                set_position(r, i, t.v[i].p);
+                set_color(r, i, t.v[i].c);
+            }
+            push(r);
+        }
+        void render(const tri2& t, texture* tex, const mat2x3& m) final
+        {
+            raster_tri r;
+            uv_remap   remap;
+            if (auto* sub = dynamic_cast<const atlas_texture_soft*>(tex))
+            {
+                r.tex = sub->page;
+                remap = sub->remap;
+            }
+            else
+            {
+                r.tex = dynamic_cast<const texture_soft*>(tex);
+            }
+            assert(r.tex != nullptr);
+            for (int i = 0; i < 3; ++i)
+            {
+                set_position(r, i, transform(t.v[i].p, m));
+                set_color(r, i, t.v[i].c);
+                const vec2 t_p = remap.apply(t.v[i].t_p);
+                r.u[i]         = t_p.x;
+                r.v[i]         = t_p.y;
+            }
+            push(r);
+        }
+
+        void render(const vertex_buffer& buffer, texture* tex, const mat2x3& m) final
+        {
+            for (const tri2& t : static_cast<const vertex_buffer_soft&>(buffer).tris)
+            {
+                render(t, tex, m);
+            }
+        }
+
+        // every triangle already goes to one shared stream here
+        void begin_batch() final {}
+        void submit(const tri2& t, texture* tex, const mat2x3& m) final
+        {
+            render(t, tex, m);
+        }
+        void submit(const quad& q, texture* tex, const mat2x3& m) final
+        {
+            // triangles 0 1 2 and 0 2 3
+            tri2 t;
+            t.v[0] = q.v[0];
+            t.v[1] = q.v[1];
+            t.v[2] = q.v[2];
+            render(t, tex, m);
+            t.v[1] = q.v[2];
+            t.v[2] = q.v[3];
+            render(t, tex, m);
+        }
+        void submit(const mesh& msh, texture* tex, const mat2x3& m) final
+        {
+            tri2 t;
+            for (std::size_t i = 0; i + 2 < msh.indexes.size(); i += 3)
+            {
+                for (std::size_t j = 0; j < 3; ++j)
+                {
+                    t.v[j] = msh.vertexes[msh.indexes[i + j]];
+                }
+                render(t, tex, m);
+            }
+        }
+        void flush_batch() final {}
+        void render_instanced(const tri2* tris, std::size_t count, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            for (std::size_t i = 0; i < instance_count; ++i)
+            {
+                const sprite_instance& inst = instances[i];
+                for (std::size_t j = 0; j < count; ++j)
+                {
+                    tri2 t = tris[j];
+                    for (v2& v : t.v)
+                    {
+                        v.c   = v.c * inst.tint;
+                        v.t_p = vec2(inst.uv_origin.x + v.t_p.x * inst.uv_size.x,
+                                     inst.uv_origin.y + v.t_p.y * inst.uv_size.y);
+                    }
+                    render(t, tex, inst.m);
+                }
+            }
+        }
+        void render_instanced(const vertex_buffer& buffer, texture* tex,
+                              const sprite_instance* instances,
+                              std::size_t instance_count) final
+        {
+            const auto& mesh = static_cast<const vertex_buffer_soft&>(buffer);
+            render_instanced(mesh.tris.data(), mesh.tris.size(), tex, instances,
+                             instance_count);
+        }
+        void execute(const command_list* lists, std::size_t count) final
+        {
+            sort_commands(lists, count, sorted_commands, sort_scratch);
+            replay_commands(*this, lists, sorted_commands);
+        }
+
+        void swap_buffers() final
+        {
+            eng_PROFILE_SCOPE("swap_buffers");
+            flush();
+            pacing.frame_presented();
+            // no gpu here, decoded image is used as is, between frames so
+            // one frame never mixes placeholder and texture
+            pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                         [](texture_soft* t) { return t->adopt(); }),
+                          pending.end());
+            atlas_pending.erase(std::remove_if(atlas_pending.begin(), atlas_pending.end(),
+                                               [this](atlas_texture_soft* sub) {
+                                                   return place_in_atlas(*sub);
+                                               }),
+                                atlas_pending.end());
+            ++frame_count;
+            eng_PROFILE_FRAME();
+            // next frame starts from clear color, render targets keep
+            // their pixels
+            (target != nullptr ? window.clear_pending : clear_pending) = true;
+            pacing.wait_for_next_frame();
+        }
+
+        state_stats get_state_stats() const final { return state_stats(); }
+        frame_stats get_frame_stats() const final { return pacing.get_stats(); }
+
+        void uninitialize() final
+        {
+            set_render_target(nullptr);
+            if (frame_count != 0)
+            {
+                std::chrono::duration<double, std::milli> ms = raster_time;
+                eng_LOG(info, engine,
+                        "software raster: {} frames, {} triangles, {} ms raster "
+                        "per frame, {} threads",
+                        frame_count, submitted, ms.count() / frame_count,
+                        workers->get_thread_count());
+                std::ostringstream stats;
+                stats << pacing.get_stats();
+                eng_LOG(info, engine, "{}", stats.str());
+            }
+            if (!config.output.empty())
+            {
+                write_ppm(config.output);
+            }
+            if (!config.trace.empty())
+            {
+                const std::string error =
+                        write_chrome_trace(config.trace, config.trace_frames);
+                if (!error.empty())
+                {
+                    eng_LOG(error, engine, "{}", error);
+                }
+            }
+            workers.reset();
+            loader.reset();
+            atlas_pages.clear();
+            atlas_placeholder.reset();
+        }
+
+    private:
+        static constexpr std::uint32_t tile_size = 64;
+
+        void set_position(raster_tri& r, int i, const vec2& p) const
+        {
+            // ndc to pixels, row 0 is top of screen
+            r.x[i] = (p.x + 1.f) * 0.5f * width;
+            r.y[i] = (1.f - p.y) * 0.5f * height;
+        }
+
+        static void set_color(raster_tri& r, int i, const color& c)
+        {
+            r.rgba[i][0] = c.get_r();
+            r.rgba[i][1] = c.get_g();
+            r.rgba[i][2] = c.get_b();
+            r.rgba[i][3] = c.get_a();
+        }
+
+        /// clamp before conversion, far off-screen vertexes overflow uint
+        static std::uint32_t to_pixel(float coord, std::uint32_t limit)
+        {
+            return static_cast<std::uint32_t>(
+                    std::clamp(coord, 0.f, static_cast<float>(limit)));
+        }
+
+        /// place img into atlas, opening page if needed; return remap of
+        /// its texture coordinates into page
+        uv_remap paste_into_atlas(const image& img, const texture_soft*& page)
+        {
+            const atlas_allocator::placement place =
+                    atlas->place(img.width, img.height);
+            if (place.new_page)
+            {
+                atlas_pages.push_back(std::make_unique<texture_soft>(
+                        place.page_width, place.page_height));
+            }
+            texture_soft*       target_page = atlas_pages[place.page].get();
+            const std::uint32_t padding     = atlas->get_padding();
+            target_page->paste(pad_image(img, padding), place.rect.x - padding,
+                               place.rect.y - padding);
+            page = target_page;
+            return atlas_allocator::get_remap(place);
+        }
+
+        /// take decoded image of async atlas texture, true when done
+        bool place_in_atlas(atlas_texture_soft& sub)
+        {
+            if (!sub.request->done.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (sub.request->error.empty())
+            {
+                const image& img = sub.request->img;
+                sub.remap        = paste_into_atlas(img, sub.page);
+                sub.width        = img.width;
+                sub.height       = img.height;
+                sub.status       = texture_state::ready;
+            }
+            else
+            {
+                eng_LOG(error, texture, "{}: {}", sub.request->path,
+                        sub.request->error);
+                sub.status = texture_state::failed;
+            }
+            sub.request.reset();
+            return true;
+        }
+
+        /// draw triangles pushed so far into current surface
+        void flush()
+        {
+            const auto raster_start = std::chrono::steady_clock::now();
+            rasterize();
+            raster_time += std::chrono::steady_clock::now() - raster_start;
+
+            tris.clear();
+            for (auto& bin : tile_bins)
+            {
+                bin.clear();
+            }
+        }
+
+        /// exchange current surface with stored one
+        void swap_surface(surface& s)
+        {
+            std::swap(width, s.width);
+            std::swap(height, s.height);
+            std::swap(pixels, s.pixels);
+            std::swap(clear_pending, s.clear_pending);
+        }
+
+        void resize_tiles()
+        {
+            tiles_x = (width + tile_size - 1) / tile_size;
+            tiles_y = (height + tile_size - 1) / tile_size;
+            tile_bins.assign(std::size_t(tiles_x) * tiles_y, {});
+        }
+
+        /// put triangle into every tile its bounding box touches
+        void push(const raster_tri& r)
+        {
+            ++submitted;
+            const float min_x = std::min({ r.x[0], r.x[1], r.x[2] });
+            const float max_x = std::max({ r.x[0], r.x[1], r.x[2] });
+            const float min_y = std::min({ r.y[0], r.y[1], r.y[2] });
+            const float max_y = std::max({ r.y[0], r.y[1], r.y[2] });
+            if (max_x < 0.f || max_y < 0.f || min_x >= width || min_y >= height)
+            {
+                return;
+            }
+            const auto index = static_cast<std::uint32_t>(tris.size());
+            tris.push_back(r);
+
+            const std::uint32_t tx0 = to_pixel(min_x, width) / tile_size;
+            const std::uint32_t ty0 = to_pixel(min_y, height) / tile_size;
+            const std::uint32_t tx1 = std::min(to_pixel(max_x, width) / tile_size, tiles_x - 1);
+            const std::uint32_t ty1 = std::min(to_pixel(max_y, height) / tile_size, tiles_y - 1);
+            for (std::uint32_t ty = ty0; ty <= ty1; ++ty)
+            {
+                for (std::uint32_t tx = tx0; tx <= tx1; ++tx)
+                {
+                    tile_bins[ty * tiles_x + tx].push_back(index);
+                }
+            }
+        }
+
+        void rasterize()
+        {
+            const bool clear = clear_pending;
+            clear_pending    = false;
+            workers->run(tile_bins.size(), [&](std::size_t tile) {
+                eng_PROFILE_SCOPE("raster tile");
+                const std::uint32_t x0 = (tile % tiles_x) * tile_size;
+                const std::uint32_t y0 = static_cast<std::uint32_t>(tile / tiles_x) * tile_size;
+                const std::uint32_t x1 = std::min(x0 + tile_size, width);
+                const std::uint32_t y1 = std::min(y0 + tile_size, height);
+                if (clear)
+                {
+                    for (std::uint32_t y = y0; y < y1; ++y)
+                    {
+                        std::fill_n(&pixels[std::size_t(y) * width + x0], x1 - x0, 0u);
+                    }
+                }
+                // submission order inside tile keeps blending correct
+                for (std::uint32_t index : tile_bins[tile])
+                {
+                    draw(tris[index], x0, y0, x1, y1);
+                }
+            });
+        }
+
+        /// edge function of edge a->b: A * x + B * y + C
+        struct edge
+        {
+            float A;
+            float B;
+            float C;
+            bool  top_left;
+        };
+
+        static edge make_edge(float ax, float ay, float bx, float by)
+        {
+            edge e;
+            e.A = ay - by;
+            e.B = bx - ax;
+            e.C = (by - ay) * ax - (bx - ax) * ay;
+            // interior on the right of upward edge is left edge,
+            // horizontal edge going right has interior below - top edge
+            e.top_left = (by < ay) || (by == ay && bx > ax);
+            return e;
+        }
+
+        void draw(const raster_tri& src, std::uint32_t x0, std::uint32_t y0,
+                  std::uint32_t x1, std::uint32_t y1)
+        {
+            raster_tri t = src;
+            float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) -
+                         (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+            if (area == 0.f)
+            {
+                return;
+            }
+            if (area < 0.f)
+            {
+                // no culling as in gl defaults, just make winding positive
+                std::swap(t.x[1], t.x[2]);
+                std::swap(t.y[1], t.y[2]);
+                std::swap(t.u[1], t.u[2]);
+                std::swap(t.v[1], t.v[2]);
+                std::swap(t.rgba[1], t.rgba[2]);
+                area = -area;
+            }
+            // weight of vertex i comes from edge opposite to it
+            const edge e[3] = { make_edge(t.x[1], t.y[1], t.x[2], t.y[2]),
+                                make_edge(t.x[2], t.y[2], t.x[0], t.y[0]),
+                                make_edge(t.x[0], t.y[0], t.x[1], t.y[1]) };
+
+            const float min_x = std::min({ t.x[0], t.x[1], t.x[2] });
+            const float max_x = std::max({ t.x[0], t.x[1], t.x[2] });
+            const float min_y = std::min({ t.y[0], t.y[1], t.y[2] });
+            const float max_y = std::max({ t.y[0], t.y[1], t.y[2] });
+            const std::uint32_t bx0 = std::max(x0, to_pixel(min_x, width));
+            const std::uint32_t by0 = std::max(y0, to_pixel(min_y, height));
+            const std::uint32_t bx1 = std::min(x1, to_pixel(max_x + 1.f, width));
+            const std::uint32_t by1 = std::min(y1, to_pixel(max_y + 1.f, height));
+
+            const float inv_area = 1.f / area;
+            for (std::uint32_t y = by0; y < by1; ++y)
+            {
+                const float    py  = y + 0.5f;
+                std::uint32_t* row = &pixels[std::size_t(y) * width];
+                for (std::uint32_t x = bx0; x < bx1; x += 4)
+                {
+                    const unsigned mask = coverage(e, x, py);
+                    for (unsigned lane = 0; lane < 4 && x + lane < bx1; ++lane)
+                    {
+                        if ((mask & (1u << lane)) == 0)
+                        {
+                            continue;
+                        }
+                        const float px = x + lane + 0.5f;
+                        const float l0 = (e[0].A * px + e[0].B * py + e[0].C) * inv_area;
+                        const float l1 = (e[1].A * px + e[1].B * py + e[1].C) * inv_area;
+                        const float l2 = 1.f - l0 - l1;
+                        shade(t, l0, l1, l2, row[x + lane]);
+                    }
+                }
+            }
+        }
+
+        /// bit per pixel x..x+3 of row py inside triangle
+        static unsigned coverage(const edge (&e)[3], std::uint32_t x, float py)
+        {
+#ifdef eng_HAS_SSE2
+            const __m128 px   = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)),
+                                         _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+            const __m128 zero = _mm_setzero_ps();
+            __m128       inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const edge& ed : e)
+            {
+                const __m128 w = _mm_add_ps(
+                        _mm_mul_ps(_mm_set1_ps(ed.A), px),
+                        _mm_set1_ps(ed.B * py + ed.C));
+                const __m128 pass = ed.top_left ? _mm_cmpge_ps(w, zero)
+                                                : _mm_cmpgt_ps(w, zero);
+                inside = _mm_and_ps(inside, pass);
+            }
+            return static_cast<unsigned>(_mm_movemask_ps(inside));
+#else
+            unsigned mask = 0;
+            for (unsigned lane = 0; lane < 4; ++lane)
+            {
+                const float px     = x + lane + 0.5f;
+                bool        inside = true;
+                for (const edge& ed : e)
+                {
+                    const float w = ed.A * px + ed.B * py + ed.C;
+                    inside        = inside && (ed.top_left ? w >= 0.f : w > 0.f);
+                }
+                mask |= inside ? 1u << lane : 0u;
+            }
+            return mask;
+#endif
+        }
+
+        /// blend GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA as gl backend does
+        static void shade(const raster_tri& t, float l0, float l1, float l2,
+                          std::uint32_t& dst)
+        {
+            float src[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                src[c] = t.rgba[0][c] * l0 + t.rgba[1][c] * l1 + t.rgba[2][c] * l2;
+            }
+            if (t.tex != nullptr)
+            {
+                const float          u     = t.u[0] * l0 + t.u[1] * l1 + t.u[2] * l2;
+                const float          v     = t.v[0] * l0 + t.v[1] * l1 + t.v[2] * l2;
+                const unsigned char* texel = t.tex->sample(u, v);
+                for (int c = 0; c < 4; ++c)
+                {
+                    src[c] *= texel[c] * (1.f / 255.f);
+                }
+            }
+            const float a = std::clamp(src[3], 0.f, 1.f);
+
+            std::uint32_t out = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                const float d     = ((dst >> (c * 8)) & 0xFF) * (1.f / 255.f);
+                const float value = std::clamp(src[c] * a + d * (1.f - a), 0.f, 1.f);
+                out |= static_cast<std::uint32_t>(value * 255.f + 0.5f) << (c * 8);
+            }
+            dst = out;
+        }
+
+        void write_ppm(const std::string& path) const
+        {
+            std::ofstream file(path, std::ios_base::binary);
+            file << "P6\n" << width << ' ' << height << "\n255\n";
+            for (std::uint32_t p : pixels)
+            {
+                const char rgb[3] = { static_cast<char>(p & 0xFF),
+                                      static_cast<char>((p >> 8) & 0xFF),
+                                      static_cast<char>((p >> 16) & 0xFF) };
+                file.write(rgb, 3);
+            }
+            if (!file)
+            {
+                eng_LOG(error, engine, "can't write {}", path);
+            }
+        }
+
+        engine_config config;
+        /// current surface: window or bound render target, the other one
+        /// waits in window or target->canvas
+        std::uint32_t width  = 0;
+        std::uint32_t height = 0;
+
+        /// RGBA, same byte order as color
+        std::vector<std::uint32_t> pixels;
+        bool                       clear_pending = true;
+        surface                    window;
+        render_target_soft*        target = nullptr;
+        std::deque<pixel_readback> readbacks;
+
+        std::vector<raster_tri>                 tris;
+        std::uint32_t                           tiles_x = 0;
+        std::uint32_t                           tiles_y = 0;
+        std::vector<std::vector<std::uint32_t>> tile_bins;
+        std::unique_ptr<worker_pool>            workers;
+        std::unique_ptr<texture_loader>         loader;
+        std::vector<texture_soft*>              pending;
+        std::vector<command_ref>                sorted_commands;
+        std::vector<command_ref>                sort_scratch;
+
+        std::unique_ptr<atlas_allocator>           atlas;
+        std::vector<std::unique_ptr<texture_soft>> atlas_pages;
+        std::unique_ptr<texture_soft>              atlas_placeholder;
+        std::vector<atlas_texture_soft*>           atlas_pending;
+
+        frame_pacer                           pacing;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration   raster_time{};
+        std::uint64_t                         submitted     = 0;
+        std::uint32_t                         frame_count   = 0;
+        bool                                  turn_off_sent = false;
+    };
+
+    engine* create_soft_engine()
+    {
+        return new engine_soft();
+    }
+
+} // end namespace eng
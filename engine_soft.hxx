@@ -0,0 +1,12 @@
+#pragma once
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// headless engine: rasterize into cpu framebuffer, no window, no gpu
+/// selected with "backend=software" in initialize config
+    engine* create_soft_engine();
+
+} // end namespace eng
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "bench.hxx"
+#include "entity_pool.hxx"
+#include "transform.hxx"
+
+/// cost of one projectile frame (update + despawn_dead + respawn of dead
+/// ones) per live entity, for growing pool sizes and every simd level
+/// usage: entity_bench [max_count]
+
+int main(int argc, char* argv[])
+{
+    const std::size_t max_count =
+            argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937                          random(42);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+
+    std::cout << "ns per live entity per frame\n"
+              << std::setw(10) << "count";
+    const eng::simd_level best = eng::get_best_simd_level();
+    for (int level = 0; level <= static_cast<int>(best); ++level)
+    {
+        std::cout << std::setw(10)
+                  << eng::to_string(static_cast<eng::simd_level>(level));
+    }
+    std::cout << '\n';
+
+    for (std::size_t count = 1000; count <= max_count; count *= 10)
+    {
+        std::cout << std::setw(10) << count;
+        for (int level = 0; level <= static_cast<int>(best); ++level)
+        {
+            eng::set_simd_level(static_cast<eng::simd_level>(level));
+            eng::entity_pool pool;
+            pool.reserve(count);
+            const auto spawn_one = [&] {
+                const float angle = unit(random) * 180.f;
+                pool.spawn(eng::vec2(unit(random), unit(random)), angle,
+                           eng::vec2(unit(random), unit(random)) * 0.01f,
+                           100.f + 100.f * unit(random));
+            };
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                spawn_one();
+            }
+            const double ns = eng::ns_per_item(count, [&] {
+                pool.update(1.f);
+                const std::size_t dead = pool.despawn_dead(
+                        eng::vec2(-1.f, -1.f), eng::vec2(1.f, 1.f));
+                // keep pool size constant, new ones replace the dead
+                for (std::size_t i = 0; i < dead; ++i)
+                {
+                    spawn_one();
+                }
+            });
+            std::cout << std::fixed << std::setprecision(3) << std::setw(10) << ns;
+        }
+        std::cout << '\n';
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "entity_pool.hxx"
+
+#include <cassert>
+
+#include "transform.hxx"
+
+namespace eng
+{
+
+    void entity_pool::reserve(std::size_t count)
+    {
+        x.reserve(count);
+        y.reserve(count);
+        heading.reserve(count);
+        velocity_x.reserve(count);
+        velocity_y.reserve(count);
+        lifetime.reserve(count);
+    }
+
+    void entity_pool::clear()
+    {
+        x.clear();
+        y.clear();
+        heading.clear();
+        velocity_x.clear();
+        velocity_y.clear();
+        lifetime.clear();
+    }
+
+    std::size_t entity_pool::spawn(const vec2& position, float heading_,
+                                   const vec2& velocity, float lifetime_)
+    {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        heading.push_back(heading_);
+        velocity_x.push_back(velocity.x);
+        velocity_y.push_back(velocity.y);
+        lifetime.push_back(lifetime_);
+        return x.size() - 1;
+    }
+
+    void entity_pool::despawn(std::size_t index)
+    {
+        assert(index < size());
+        const std::size_t last = size() - 1;
+        x[index]               = x[last];
+        y[index]               = y[last];
+        heading[index]         = heading[last];
+        velocity_x[index]      = velocity_x[last];
+        velocity_y[index]      = velocity_y[last];
+        lifetime[index]        = lifetime[last];
+        x.pop_back();
+        y.pop_back();
+        heading.pop_back();
+        velocity_x.pop_back();
+        velocity_y.pop_back();
+        lifetime.pop_back();
+    }
+
+    void entity_pool::update(float dt)
+    {
+        const std::size_t count = size();
+        std::size_t       i     = 0;
+#ifdef eng_HAS_SSE2
+        if (get_simd_level() != simd_level::scalar)
+        {
+            const __m128 step = _mm_set1_ps(dt);
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 px = _mm_loadu_ps(&x[i]);
+                const __m128 py = _mm_loadu_ps(&y[i]);
+                const __m128 vx = _mm_loadu_ps(&velocity_x[i]);
+                const __m128 vy = _mm_loadu_ps(&velocity_y[i]);
+                const __m128 t  = _mm_loadu_ps(&lifetime[i]);
+                _mm_storeu_ps(&x[i], _mm_add_ps(px, _mm_mul_ps(vx, step)));
+                _mm_storeu_ps(&y[i], _mm_add_ps(py, _mm_mul_ps(vy, step)));
+                _mm_storeu_ps(&lifetime[i], _mm_sub_ps(t, step));
+            }
+        }
+#endif
+        // same operations as simd lanes, results are bit-identical
+        for (; i < count; ++i)
+        {
+            x[i] += velocity_x[i] * dt;
+            y[i] += velocity_y[i] * dt;
+            lifetime[i] -= dt;
+        }
+    }
+
+    std::size_t entity_pool::despawn_dead(const vec2& min, const vec2& max)
+    {
+        const std::size_t before = size();
+        std::size_t       i      = 0;
+        // despawn pulls last entity into i, so i is checked again
+        // and size() shrinks under the loop
+        while (i < size())
+        {
+#ifdef eng_HAS_SSE2
+            if (get_simd_level() != simd_level::scalar)
+            {
+                // skip groups of 4 live entities, the common case
+                const __m128 lo_x = _mm_set1_ps(min.x);
+                const __m128 lo_y = _mm_set1_ps(min.y);
+                const __m128 hi_x = _mm_set1_ps(max.x);
+                const __m128 hi_y = _mm_set1_ps(max.y);
+                const __m128 zero = _mm_setzero_ps();
+                for (; i + 4 <= size(); i += 4)
+                {
+                    const __m128 px   = _mm_loadu_ps(&x[i]);
+                    const __m128 py   = _mm_loadu_ps(&y[i]);
+                    const __m128 live = _mm_and_ps(
+                            _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, lo_x),
+                                                  _mm_cmple_ps(px, hi_x)),
+                                       _mm_and_ps(_mm_cmpge_ps(py, lo_y),
+                                                  _mm_cmple_ps(py, hi_y))),
+                            _mm_cmpgt_ps(_mm_loadu_ps(&lifetime[i]), zero));
+                    if (_mm_movemask_ps(live) != 0xf)
+                    {
+                        break;
+                    }
+                }
+                if (i >= size())
+                {
+                    break;
+                }
+            }
+#endif
+            const bool live = x[i] >= min.x && x[i] <= max.x && y[i] >= min.y &&
+                              y[i] <= max.y && lifetime[i] > 0.f;
+            if (live)
+            {
+                ++i;
+            }
+            else
+            {
+                despawn(i);
+            }
+        }
+        return before - size();
+    }
+
+} // end namespace eng
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// moving entities (projectiles, tanks) as structure of arrays:
+/// one contiguous float array per field, index i is one entity.
+/// Indexes are dense [0, size()): despawn moves last entity into the
+/// freed slot, so index of other entity may change, don't keep it
+/// across despawn
+    class eng_DECLSPEC entity_pool
+    {
+    public:
+        std::size_t size() const { return x.size(); }
+        bool        empty() const { return x.empty(); }
+        void        reserve(std::size_t count);
+        void        clear();
+
+        /// heading in degrees (as mat2x3::rotate), velocity and lifetime in
+        /// units per update dt; return index of new entity
+        std::size_t spawn(const vec2& position, float heading,
+                          const vec2& velocity, float lifetime);
+        /// O(1): last entity takes index place
+        void despawn(std::size_t index);
+
+        /// position += velocity * dt, lifetime -= dt for every entity
+        void update(float dt);
+        /// despawn entities with lifetime <= 0 or position outside
+        /// [min, max]; return how many were removed
+        std::size_t despawn_dead(const vec2& min, const vec2& max);
+
+        const float* get_x() const { return x.data(); }
+        const float* get_y() const { return y.data(); }
+        const float* get_heading() const { return heading.data(); }
+        const float* get_velocity_x() const { return velocity_x.data(); }
+        const float* get_velocity_y() const { return velocity_y.data(); }
+        const float* get_lifetime() const { return lifetime.data(); }
+
+    private:
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> heading;
+        std::vector<float> velocity_x;
+        std::vector<float> velocity_y;
+        std::vector<float> lifetime;
+    };
+
+} // end namespace eng
@@ -0,0 +1,49 @@
+#include "fixed_timestep.hxx"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace eng
+{
+
+    fixed_timestep::fixed_timestep(double step_seconds_, std::uint32_t max_steps_)
+        : step_seconds(step_seconds_)
+        , max_steps(max_steps_)
+    {
+        assert(step_seconds > 0.0 && max_steps > 0);
+    }
+
+    void fixed_timestep::begin_frame(double now)
+    {
+        if (started)
+        {
+            // clock never goes back, but don't trust caller with it
+            accumulator += std::max(now - last_time, 0.0);
+        }
+        started     = true;
+        last_time   = now;
+        frame_steps = 0;
+    }
+
+    bool fixed_timestep::step()
+    {
+        if (accumulator < step_seconds)
+        {
+            return false;
+        }
+        if (frame_steps == max_steps)
+        {
+            // keep fraction so alpha stays smooth after the stall
+            const double kept = std::fmod(accumulator, step_seconds);
+            dropped += accumulator - kept;
+            accumulator = kept;
+            return false;
+        }
+        accumulator -= step_seconds;
+        ++frame_steps;
+        ++tick;
+        return true;
+    }
+
+} // end namespace eng
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// fixed rate simulation under any render rate:
+///
+///     timestep.begin_frame(engine->get_time_from_init());
+///     while (timestep.step())
+///     {
+///         simulate(timestep.get_step());
+///     }
+///     render(blend(previous, current, timestep.get_alpha()));
+///
+/// Every step simulates the same get_step() seconds, so cost of one
+/// simulated second is fixed. Frames faster than step rate run no step
+/// and only move alpha, slower ones run several steps
+    class eng_DECLSPEC fixed_timestep
+    {
+    public:
+        /// step_seconds - simulated time of one step, max_steps - catch up
+        /// limit per frame, time beyond it is dropped (game slows down
+        /// instead of spending ever more frame time on simulation)
+        explicit fixed_timestep(double step_seconds = 1.0 / 60.0,
+                                std::uint32_t max_steps = 5);
+
+        /// add time passed since previous call, first call only
+        /// remembers now
+        void begin_frame(double now);
+        /// return true while one more step is due in this frame
+        bool step();
+
+        double get_step() const { return step_seconds; }
+        /// part of next step already passed [0, 1): blend previous
+        /// simulated state with current one by it
+        float get_alpha() const
+        {
+            return static_cast<float>(accumulator / step_seconds);
+        }
+        /// steps simulated since creation
+        std::uint64_t get_tick() const { return tick; }
+        /// seconds dropped because more than max_steps were due
+        double get_dropped() const { return dropped; }
+
+    private:
+        double        step_seconds;
+        std::uint32_t max_steps;
+        double        accumulator = 0.0;
+        double        last_time   = 0.0;
+        bool          started     = false;
+        std::uint32_t frame_steps = 0;
+        std::uint64_t tick        = 0;
+        double        dropped     = 0.0;
+    };
+
+} // end namespace eng
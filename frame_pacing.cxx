@@ -0,0 +1,160 @@
+#include "frame_pacing.hxx"
+
+#include <algorithm>
+#include <ostream>
+#include <thread>
+
+namespace eng
+{
+
+    using ms_duration = std::chrono::duration<double, std::milli>;
+
+    bool parse_vsync_mode(std::string_view name, vsync_mode& out)
+    {
+        if (name == "off")
+        {
+            out = vsync_mode::off;
+        }
+        else if (name == "on")
+        {
+            out = vsync_mode::on;
+        }
+        else if (name == "adaptive")
+        {
+            out = vsync_mode::adaptive;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    void frame_histogram::add(double ms)
+    {
+        const auto bucket = static_cast<std::size_t>(std::max(ms, 0.0) / bucket_ms);
+        ++buckets[std::min(bucket, bucket_count - 1)];
+        ++count;
+        sum += ms;
+        max = std::max(max, ms);
+    }
+
+    double frame_histogram::percentile(double p) const
+    {
+        if (count == 0)
+        {
+            return 0.0;
+        }
+        const auto    rank = static_cast<std::uint32_t>(p * (count - 1)) + 1;
+        std::uint32_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                return std::min((i + 1) * bucket_ms, max);
+            }
+        }
+        return max;
+    }
+
+    void frame_pacer::initialize(std::uint32_t max_fps, std::uint32_t spin_us)
+    {
+        *this = frame_pacer();
+        if (max_fps != 0)
+        {
+            period = std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(1.0 / max_fps));
+        }
+        spin = std::chrono::microseconds(spin_us);
+    }
+
+    void frame_pacer::frame_presented()
+    {
+        const clock::time_point now = clock::now();
+        if (presented)
+        {
+            frame_times.add(ms_duration(now - last_present).count());
+        }
+        else
+        {
+            // schedule starts with first frame, loading before it doesn't
+            // shorten its wait
+            deadline = now;
+        }
+        presented    = true;
+        last_present = now;
+        if (input_pending)
+        {
+            const double ms = ms_duration(now - pending_input).count();
+            ++latency_samples;
+            latency_sum_ms += ms;
+            latency_max_ms = std::max(latency_max_ms, ms);
+            input_pending  = false;
+        }
+    }
+
+    void frame_pacer::wait_for_next_frame()
+    {
+        if (period == clock::duration::zero())
+        {
+            return;
+        }
+        const clock::time_point start = clock::now();
+        deadline += period;
+        if (deadline <= start)
+        {
+            // late frame starts schedule anew, no burst of short frames
+            // to catch up
+            deadline = start;
+            return;
+        }
+        if (deadline - start > spin)
+        {
+            std::this_thread::sleep_for(deadline - start - spin);
+        }
+        while (clock::now() < deadline)
+        {
+            std::this_thread::yield();
+        }
+        waited_ms += ms_duration(clock::now() - start).count();
+    }
+
+    void frame_pacer::input_seen(clock::time_point oldest)
+    {
+        // events of several pumps may wait for one frame, oldest counts
+        if (!input_pending || oldest < pending_input)
+        {
+            pending_input = oldest;
+        }
+        input_pending = true;
+    }
+
+    frame_stats frame_pacer::get_stats() const
+    {
+        frame_stats s;
+        s.frames  = frame_times.get_count();
+        s.mean_ms = frame_times.get_mean();
+        s.p50_ms  = frame_times.percentile(0.5);
+        s.p90_ms  = frame_times.percentile(0.9);
+        s.p99_ms  = frame_times.percentile(0.99);
+        s.max_ms  = frame_times.get_max();
+        s.wait_ms = s.frames != 0 ? waited_ms / s.frames : 0.0;
+        s.latency_samples = latency_samples;
+        s.latency_mean_ms =
+                latency_samples != 0 ? latency_sum_ms / latency_samples : 0.0;
+        s.latency_max_ms = latency_max_ms;
+        return s;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const frame_stats& s)
+    {
+        stream << "frames: " << s.frames << " frame ms: mean " << s.mean_ms
+               << " p50 " << s.p50_ms << " p90 " << s.p90_ms << " p99 " << s.p99_ms
+               << " max " << s.max_ms << " limiter wait " << s.wait_ms
+               << " input latency ms: mean " << s.latency_mean_ms << " max "
+               << s.latency_max_ms << " of " << s.latency_samples << " inputs";
+        return stream;
+    }
+
+} // end namespace eng
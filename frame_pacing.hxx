@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// swap interval of gl backend ("vsync" config key)
+    enum class vsync_mode
+    {
+        /// swap at once, may tear
+        off,
+        /// wait for vertical blank
+        on,
+        /// wait for vertical blank unless frame is late, then swap at once
+        /// (EXT_swap_control_tear), falls back to on
+        adaptive
+    };
+
+/// "off", "on", "adaptive" -> vsync_mode; false on unknown name
+    bool parse_vsync_mode(std::string_view name, vsync_mode& out);
+
+/// frame times in 0.25 ms buckets up to 100 ms, longer ones share last
+/// bucket; percentiles are upper bound of their bucket
+    class frame_histogram
+    {
+    public:
+        static constexpr double      bucket_ms    = 0.25;
+        static constexpr std::size_t bucket_count = 400;
+
+        void add(double ms);
+        /// p in [0, 1], 0 when empty
+        double percentile(double p) const;
+        std::uint32_t get_count() const { return count; }
+        double        get_mean() const { return count != 0 ? sum / count : 0.0; }
+        double        get_max() const { return max; }
+
+    private:
+        std::array<std::uint32_t, bucket_count> buckets{};
+        std::uint32_t                           count = 0;
+        double                                  sum   = 0.0;
+        double                                  max   = 0.0;
+    };
+
+/// frame cap and timing shared by backends. swap_buffers calls
+/// frame_presented right after frame goes to display, then
+/// wait_for_next_frame before input is read: waiting before input and
+/// not after it keeps events as fresh as possible when frame is drawn.
+/// Limiter sleeps until spin time is left (sleep overshoots by up to a
+/// scheduler tick) and yields in loop for the rest
+    class frame_pacer
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        /// max_fps 0 - no cap
+        void initialize(std::uint32_t max_fps, std::uint32_t spin_us);
+
+        void frame_presented();
+        void wait_for_next_frame();
+        /// oldest input event passed to game in coming frame, latency is
+        /// taken from it to frame_presented of that frame
+        void input_seen(clock::time_point oldest);
+
+        frame_stats get_stats() const;
+
+    private:
+        clock::duration   period{};
+        clock::duration   spin{};
+        clock::time_point deadline;
+        clock::time_point last_present;
+        bool              presented = false;
+
+        clock::time_point pending_input;
+        bool              input_pending = false;
+
+        frame_histogram frame_times;
+        double          waited_ms       = 0.0;
+        std::uint32_t   latency_samples = 0;
+        double          latency_sum_ms  = 0.0;
+        double          latency_max_ms  = 0.0;
+    };
+
+} // end namespace eng
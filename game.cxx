@@ -1,14 +1,23 @@
 #include <algorithm>
 #include <array>
-#include <cassert>
 #include <cmath>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 
 
+#include "command_list.hxx"
 #include "engine.hxx"
+#include "entity_pool.hxx"
+#include "fixed_timestep.hxx"
+#include "log.hxx"
+#include "mesh_cache.hxx"
+#include "profiler.hxx"
+#include "worker_pool.hxx"
 
 eng::v0 blend(const eng::v0& vl, const eng::v0& vr, const float a)
 {
@@ -27,52 +36,140 @@ eng::tri0 blend(const eng::tri0& tl, const eng::tri0& tr, const float a)
     return r;
 }
 
-int main(int /*argc*/, char* /*argv*/ [])
+///sprite file holds one quad: its first 2 triangles are 0 1 2 and 0 2 3 of
+///4 vertexes in order eng::quad draws them; more triangles may only repeat
+///these vertexes and are not drawn
+bool is_sprite_quad(const eng::mesh& m)
+{
+    constexpr std::array<std::uint16_t, 6> quad_indexes = { 0, 1, 2, 0, 2, 3 };
+    return m.vertexes.size() == 4 && m.indexes.size() >= 6 &&
+           std::equal(quad_indexes.begin(), quad_indexes.end(), m.indexes.begin());
+}
+
+///binary ppm, alpha dropped
+void write_screenshot(const eng::pixel_readback& shot)
+{
+    const std::string path = "screenshot_" + std::to_string(shot.frame) + ".ppm";
+    std::ofstream     file(path, std::ios_base::binary);
+    file << "P6\n" << shot.width << ' ' << shot.height << "\n255\n";
+    for (std::size_t i = 0; i < shot.pixels.size(); i += 4)
+    {
+        file.write(reinterpret_cast<const char*>(&shot.pixels[i]), 3);
+    }
+    if (!file)
+    {
+        eng_LOG(error, game, "can't write {}", path);
+        return;
+    }
+    eng_LOG(info, game, "saved {}", path);
+}
+
+int main(int argc, char* argv[])
 {
     std::unique_ptr<eng::engine, void (*)(eng::engine*)> engine(
             eng::create_engine(), eng::destroy_engine);
 
-    const std::string error = engine->initialize("");
+    // engine config as first argument, e.g. "backend=software frames=600"
+    const std::string error = engine->initialize(argc > 1 ? argv[1] : "");
     if (!error.empty())
     {
         std::cerr << error << std::endl;
         return EXIT_FAILURE;
     }
 
-    eng::texture* texture = engine->create_texture("tank2d.png");
-    eng::texture* pula = engine->create_texture("pula.png");
+    // decoded in background and drawn transparent until placed; both
+    // share one atlas page, so tank and bullet go in one draw call
+    eng::texture* texture = engine->create_atlas_texture_async("tank2d.png");
+    eng::texture* pula    = engine->create_atlas_texture_async("pula.png");
 
     if (nullptr == texture)
     {
-        std::cerr << "failed load texture\n";
+        eng_LOG(error, game, "failed load texture");
         return EXIT_FAILURE;
     }
 
+    eng::mesh_cache meshes;
+    ///blend below reads 4 triangles, edited file with less is not reloaded
+    const auto      pos_mesh       = meshes.load<eng::tri0>("vert_pos.txt", 4);
+    const auto      pos_color_mesh = meshes.load<eng::tri1>("vert_pos_color.txt");
+    const auto      tex_color_mesh = meshes.load<eng::tri2>("vert_tex_color.txt");
+    ///sprite quad for pulas: first 2 triangles of file, uploaded once as
+    ///4 vertexes and 6 indexes
+    eng::mesh sprite = meshes.get_indexed(tex_color_mesh);
+    if (!is_sprite_quad(sprite))
+    {
+        eng_LOG(error, game, "vert_tex_color.txt is not one quad");
+        return EXIT_FAILURE;
+    }
+    sprite.indexes.resize(6);
+    eng::vertex_buffer* pula_quad = engine->create_vertex_buffer(sprite);
+    ///tank quad, taken again when file is reloaded as one quad
+    eng::quad quad;
+    std::copy(sprite.vertexes.begin(), sprite.vertexes.end(), quad.v);
+    std::uint32_t quad_version = meshes.get_version(tex_color_mesh);
+
+    ///simulation runs 60 steps per second whatever frame rate is
+    eng::fixed_timestep timestep(1.0 / 60.0);
+
+    ///speeds per second of simulated time
+    constexpr float forward_speed  = 0.45f;
+    constexpr float backward_speed = 0.3f;
+    ///degree per second
+    constexpr float turn_speed = 180.f;
+    constexpr float pula_speed = 1.5f;
+    ///seconds pula lives at most, window is left much earlier
+    constexpr float pula_lifetime = 10.f;
+
+    ///tank and pulas are prepared on all cores, one command list per job
+    eng::worker_pool workers(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    std::vector<eng::command_list> lists(workers.get_thread_count());
+    ///pulas share mesh and texture, they differ only by matrix
+    std::vector<eng::sprite_instance> pula_instances;
+
     bool continue_loop  = true;
     ///angle of main texture ( as default)
     float def = 0.0f;
-    ///delta x for pula
-    float dx_p = 0.f;
-    ///delta y for pula
-    float dy_p = 0.f;
-    ///bool value for init fire
-    bool fire = false;
-    ///angle of pula
-    float pula_angle = 0.f;
-    ///default matrix rotate for 0 degree angle
-    eng::mat2x3 rot = eng::mat2x3::rotate(def);
     ///delta x and y for main texture
     float dx = 0.f, dy = 0.f;
-    ///default matrix move for 0 and 0 move as x and y
-    eng::mat2x3 delta = eng::mat2x3::move(eng::vec2(dx, dy));
+    ///tank before last step, frame is drawn between it and current one
+    float prev_def = def, prev_dx = dx, prev_dy = dy;
+    ///every pula in flight, moves pula_speed per second along its angle
+    eng::entity_pool pulas;
     int  current_shader = 0;
+    ///start key asks for screenshot of next frame, saved when gpu is done
+    bool take_screenshot = false;
+
+    ///check for keeping texture in window
+    const auto can_move = [&]() {
+        if (dx + 0.015f * std::sin(def * eng::pi / 180.f) - 0.9f >= 0.0000000001f and
+            ((def >= -90 and def <= 90) or (def <= -270 and def >= 270)))
+            return false;
+        if (dy + 0.015f * std::cos(def * eng::pi / 180.f) - 0.9f >= 0.0000000001f  and
+            ((def >= 0 and def <= 180) or (def >= -360 and def <= -180)))
+            return false;
+        if (dx - 0.015f * std::sin(def * eng::pi / 180.f) - -0.9f <= 0.0000000001f  and
+            ((def >= 90 and def <= 270) or (def >= -270 and def <= -90)))
+            return false;
+        if (dy - 0.015f * std::cos(def * eng::pi / 180.f) - -0.9f <= 0.0000000001f and
+            ((def >= 180 and def <= 360) or (def >= -180 and def <= -0)))
+            return false;
+        return true;
+    };
+    ///move main texture along its angle, negative distance moves back
+    const auto move_tank = [&](float distance) {
+        if (!can_move())
+            return;
+        dx += static_cast<float>(distance * std::sin(def * eng::pi / 180.f));
+        dy += static_cast<float>(distance * std::cos(def * eng::pi / 180.f));
+    };
+
     while (continue_loop)
     {
         eng::event event;
 
         while (engine->read_input(event))
         {
-            std::cout << event << std::endl;
+            eng_LOG(info, game, "{}", eng::to_string(event));
             switch (event)
             {
                 case eng::event::turn_off:
@@ -85,100 +182,79 @@ int main(int /*argc*/, char* /*argv*/ [])
                         current_shader = 0;
                     }
                     break;
-                case eng::event::down_pressed:
-                    ///check for keeping texture in window
-                    if (dx + 0.015f * std::sin(def * M_PI / 180.f) - 0.9f >= 0.0000000001f and
-                        ((def >= -90 and def <= 90) or (def <= -270 and def >= 270)))
-                        break;
-                    if (dy + 0.015f * std::cos(def * M_PI / 180.f) - 0.9f >= 0.0000000001f  and
-                        ((def >= 0 and def <= 180) or (def >= -360 and def <= -180)))
-                        break;
-                    if (dx - 0.015f * std::sin(def * M_PI / 180.f) - -0.9f <= 0.0000000001f  and
-                        ((def >= 90 and def <= 270) or (def >= -270 and def <= -90)))
-                        break;
-                    if (dy - 0.015f * std::cos(def * M_PI / 180.f) - -0.9f <= 0.0000000001f and
-                        ((def >= 180 and def <= 360) or (def >= -180 and def <= -0)))
-                        break;
-                    dx -= static_cast<float>(0.010f * std::sin(def * M_PI / 180.f));
-                    dy -= static_cast<float>(0.010f * std::cos(def * M_PI / 180.f));
-                    ///generate move matrix with dx and dy
-                    delta = eng::mat2x3::move(eng::vec2(dx, dy));
-                    break;
-                case eng::event::up_pressed:
-                    ///check for keeping texture in window
-                    if (dx + 0.015f * std::sin(def * M_PI / 180.f) - 0.9f >= 0.0000000001f and
-                            ((def >= -90 and def <= 90) or (def <= -270 and def >= 270)))
-                        break;
-                    if (dy + 0.015f * std::cos(def * M_PI / 180.f) - 0.9f >= 0.0000000001f  and
-                            ((def >= 0 and def <= 180) or (def >= -360 and def <= -180)))
-                        break;
-                    if (dx - 0.015f * std::sin(def * M_PI / 180.f) - -0.9f <= 0.0000000001f  and
-                            ((def >= 90 and def <= 270) or (def >= -270 and def <= -90)))
-                        break;
-                    if (dy - 0.015f * std::cos(def * M_PI / 180.f) - -0.9f <= 0.0000000001f and
-                            ((def >= 180 and def <= 360) or (def >= -180 and def <= -0)))
-                        break;
-                    dx += static_cast<float>(0.015f * std::sin(def * M_PI / 180.f));
-                    dy += static_cast<float>(0.015f * std::cos(def * M_PI / 180.f ));
-                    ///generate move matrix with dx and dy
-                    delta = eng::mat2x3::move(eng::vec2(dx, dy));
-                    break;
-                case eng::event::left_pressed:
-                    ///generate rotate matrix for angle -9 degree
-                    rot = eng::mat2x3::rotate(-9.f + def);
-                    ///change angle of main texture to def-9 degree
-                    def -= 9.f;
-                    break;
-                case eng::event::right_pressed:
-                    ///generate rotate matrix for angle 9 degree
-                    rot = eng::mat2x3::rotate(9.f + def);
-                    ///change angle of main texture to def+9 degree
-                    def += 9.f;
+                case eng::event::select_pressed:
+                {
+                    std::ostringstream stats;
+                    stats << engine->get_state_stats() << '\n'
+                          << engine->get_frame_stats();
+                    eng_LOG(info, game, "{}", stats.str());
                     break;
+                }
+                case eng::event::left_pressed:break;
                 case eng::event::left_released:break;
+                case eng::event::right_pressed:break;
                 case eng::event::right_released:break;
+                case eng::event::up_pressed:break;
                 case eng::event::up_released:break;
+                case eng::event::down_pressed:break;
                 case eng::event::down_released:break;
-                case eng::event::select_pressed:break;
                 case eng::event::select_released:break;
-                case eng::event::start_pressed:break;
+                case eng::event::start_pressed:
+                    take_screenshot = true;
+                    break;
                 case eng::event::start_released:break;
                 case eng::event::button1_pressed:break;
                 case eng::event::button2_pressed:
-                    if (!fire) {
-                        ///set fire is up
-                        fire = true;
-                        ///set angle of pula as main angle
-                        pula_angle = def;
-                        ///set dx and dy for pula
-                        dy_p = dy;
-                        dx_p = dx;
-                    }
+                    ///new pula starts from tank center along main angle
+                    pulas.spawn(eng::vec2(dx, dy), def,
+                                eng::vec2(static_cast<float>(pula_speed * std::sin(def * eng::pi / 180.f)),
+                                          static_cast<float>(pula_speed * std::cos(def * eng::pi / 180.f))),
+                                pula_lifetime);
                     break;
                 case eng::event::button2_released:break;
             }
+        }
+
+        ///keys held down, tank moves every step until they are released
+        const eng::button_set held = engine->get_held_buttons();
+        const auto is_held = [&](eng::button b) {
+            return held.test(static_cast<std::size_t>(b));
+        };
+        timestep.begin_frame(engine->get_time_from_init());
+        while (timestep.step())
+        {
+            eng_PROFILE_SCOPE("simulate step");
+            const float step = static_cast<float>(timestep.get_step());
+            prev_def = def;
+            prev_dx  = dx;
+            prev_dy  = dy;
+            if (is_held(eng::button::left))
+                def -= turn_speed * step;
+            if (is_held(eng::button::right))
+                def += turn_speed * step;
             ///keep main angle in range (-360;360) degree
             if (def >= 360.f) def -= 360.f;
             if (def <= -360.f) def += 360.f;
+            if (is_held(eng::button::up))
+                move_tank(forward_speed * step);
+            if (is_held(eng::button::down))
+                move_tank(-backward_speed * step);
+            ///pulas leaving window are gone
+            pulas.update(step);
+            pulas.despawn_dead(eng::vec2(-1.f, -1.f), eng::vec2(1.f, 1.f));
         }
 
+        meshes.poll_changes();
+
         if (current_shader == 0)
         {
-            std::ifstream file("vert_pos.txt");
-            assert(!!file);
-
-            eng::tri0 tr1;
-            eng::tri0 tr2;
-            eng::tri0 tr11;
-            eng::tri0 tr22;
-
-            file >> tr1 >> tr2 >> tr11 >> tr22;
+            const eng::mesh_view<eng::tri0> tris = meshes.get(pos_mesh);
 
             float time  = engine->get_time_from_init();
             float beta = std::sin(time);
 
-            eng::tri0 t1 = blend(tr1, tr11, beta);
-            eng::tri0 t2 = blend(tr2, tr22, beta);
+            eng::tri0 t1 = blend(tris[0], tris[2], beta);
+            eng::tri0 t2 = blend(tris[1], tris[3], beta);
 
             engine->render(t1, eng::color(1.f, 0.f, 0.f, 1.f));
             engine->render(t2, eng::color(0.f, 1.f, 0.f, 1.f));
@@ -186,68 +262,104 @@ int main(int /*argc*/, char* /*argv*/ [])
 
         if (current_shader == 1)
         {
-            std::ifstream file("vert_pos_color.txt");
-            assert(!!file);
-
-            eng::tri1 tr1;
-            eng::tri1 tr2;
-
-            file >> tr1 >> tr2;
-
-            engine->render(tr1);
-            engine->render(tr2);
+            for (const eng::tri1& tr : meshes.get(pos_color_mesh))
+            {
+                engine->render(tr);
+            }
         }
 
         if (current_shader == 2)
         {
-            std::ifstream file("vert_tex_color.txt");
-            assert(!!file);
-
-            eng::tri2 tr1;
-            eng::tri2 tr2;
-            eng::tri2 tr3;
-            eng::tri2 tr4;
-
-            file >> tr1 >> tr2;
-            tr3 = tr1;
-            tr4 = tr2;
+            eng_PROFILE_SCOPE("draw tank and pulas");
+            ///sprite quad, same for tank and pula: file has triangles
+            ///0 1 2 and 0 2 3 of it, as quad draws them; edit that is not
+            ///one quad keeps previous one
+            if (meshes.get_version(tex_color_mesh) != quad_version)
+            {
+                quad_version = meshes.get_version(tex_color_mesh);
+                const eng::mesh& sprite_mesh = meshes.get_indexed(tex_color_mesh);
+                if (is_sprite_quad(sprite_mesh))
+                {
+                    std::copy(sprite_mesh.vertexes.begin(),
+                              sprite_mesh.vertexes.end(), quad.v);
+                }
+                else
+                {
+                    eng_LOG(warn, game, "vert_tex_color.txt is not one quad, kept old");
+                }
+            }
 
             // float time = engine->get_time_freng_init();
             // float s    = std::sin(time);
             // float c    = std::sin(time);
 
 
-            eng::mat2x3 aspect;
             ///matrix for norm coordinates
-            aspect.row1.x = 640.f / 480.f;
-            aspect.row2.x = 0.f;
-            aspect.row1.y = 0.f;
-            aspect.row2.y = 1.f;
+            constexpr eng::mat2x3 aspect(eng::vec2(640.f / 480.f, 0.f),
+                                         eng::vec2(0.f, 1.f), eng::vec2());
+            constexpr eng::mat2x3 tank_scale = eng::mat2x3::scale(0.25f);
+            constexpr eng::mat2x3 pula_scale = eng::mat2x3::scale(0.05f);
+            ///tank between previous and current step, angle the short way
+            const float alpha = timestep.get_alpha();
+            float       turn  = def - prev_def;
+            if (turn > 180.f) turn -= 360.f;
+            if (turn < -180.f) turn += 360.f;
+            const eng::mat2x3 rot   = eng::mat2x3::rotate(prev_def + turn * alpha);
+            const eng::mat2x3 delta = eng::mat2x3::move(
+                    eng::vec2(prev_dx + (dx - prev_dx) * alpha, prev_dy + (dy - prev_dy) * alpha));
             ///group rotate scale and move matrixes
-            eng::mat2x3 m = aspect * rot * eng::mat2x3::scale(0.25f) * delta;
-
-            engine->render(tr1, texture, m);
-            engine->render(tr2, texture, m);
-            if (fire) {
-                std::cout << pula_angle << std::endl;
-                eng::mat2x3 p = aspect * eng::mat2x3::rotate(pula_angle) * eng::mat2x3::scale(0.05)
-                                * eng::mat2x3::move(eng::vec2(dx_p, dy_p));
-                engine->render(tr3, pula, p);
-                engine->render(tr4, pula, p);
-                dx_p += static_cast<float>(0.025f * std::sin(pula_angle * M_PI / 180.f));
-                dy_p += static_cast<float>(0.025f * std::cos(pula_angle * M_PI / 180.f ));
-                if (dx_p >= 1.f or dx_p <= -1.f or dy_p <= -1.f or dy_p >= 1.f){
-                    pula_angle = 0.f;
-                    fire = false;
-                    dx_p = 0.f;
-                    dy_p = 0.f;
+            eng::mat2x3 m = aspect * rot * tank_scale * delta;
+
+            const float* pula_x     = pulas.get_x();
+            const float* pula_y     = pulas.get_y();
+            const float* pula_angle = pulas.get_heading();
+            const float* pula_vx    = pulas.get_velocity_x();
+            const float* pula_vy    = pulas.get_velocity_y();
+            ///pula moves straight, so its previous place is one step back
+            const float back = static_cast<float>(timestep.get_step()) * (1.f - alpha);
+            ///every job fills its share of pula instances, tank goes in list
+            pula_instances.resize(pulas.size());
+            workers.run(lists.size(), [&](std::size_t job) {
+                eng::command_list& list = lists[job];
+                list.clear();
+                if (job == 0)
+                {
+                    list.draw(&quad, 1, texture, m, 0);
+                }
+                const std::size_t first = pulas.size() * job / lists.size();
+                const std::size_t last  = pulas.size() * (job + 1) / lists.size();
+                for (std::size_t i = first; i < last; ++i)
+                {
+                    pula_instances[i].m =
+                            aspect * eng::mat2x3::rotate(pula_angle[i]) * pula_scale *
+                            eng::mat2x3::move(eng::vec2(pula_x[i] - pula_vx[i] * back,
+                                                        pula_y[i] - pula_vy[i] * back));
                 }
+            });
+            engine->execute(lists.data(), lists.size());
+            ///all pulas in one draw call over tank
+            engine->render_instanced(*pula_quad, pula, pula_instances.data(),
+                                     pula_instances.size());
+        }
+
+        if (take_screenshot && engine->request_readback())
+        {
+            take_screenshot = false;
+        }
+        eng::pixel_readback shot;
+        while (engine->poll_readback(shot))
+        {
+            ///failed readback has no pixels, engine logged why
+            if (!shot.pixels.empty())
+            {
+                write_screenshot(shot);
             }
         }
 
         engine->swap_buffers();
     }
 
+    engine->destroy_vertex_buffer(pula_quad);
     engine->uninitialize();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,263 @@
+#include "gl_debug.hxx"
+
+#include <limits>
+#include <sstream>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_opengl.h>
+#include <SDL2/SDL_opengl_glext.h>
+
+namespace eng
+{
+
+#if eng_GL_DEBUG
+    namespace gl_debug_detail
+    {
+        std::atomic<bool> message_pending{ false };
+        std::uint32_t     countdown  = std::numeric_limits<std::uint32_t>::max();
+        gl_call_site*     last_clean = nullptr;
+    } // namespace gl_debug_detail
+
+    namespace
+    {
+        gl_debug_mode mode          = gl_debug_mode::off;
+        std::uint32_t poll_interval = 1;
+        /// sites with errors, in order of first error
+        gl_call_site* first_site = nullptr;
+        gl_call_site* last_site  = nullptr;
+        /// errors found by frame check or callback outside any check
+        gl_call_site frame_site{ "swap_buffers", 0 };
+
+        /// debug callback message waiting for next check, gl thread only
+        /// (output is synchronous)
+        struct
+        {
+            std::uint32_t id = 0;
+            std::string   text;
+        } pending_message;
+
+        PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback = nullptr;
+
+        void add_error(gl_call_site& site, std::uint32_t code,
+                       std::string_view message)
+        {
+            if (site.errors++ == 0)
+            {
+                if (last_site == nullptr)
+                {
+                    first_site = &site;
+                }
+                else
+                {
+                    last_site->next = &site;
+                }
+                last_site = &site;
+            }
+            site.last_code    = code;
+            site.last_message = message;
+            site.after        = gl_debug_detail::last_clean;
+        }
+
+        const char* error_name(GLenum error)
+        {
+            switch (error)
+            {
+                case GL_INVALID_ENUM:
+                    return "GL_INVALID_ENUM";
+                case GL_INVALID_VALUE:
+                    return "GL_INVALID_VALUE";
+                case GL_INVALID_OPERATION:
+                    return "GL_INVALID_OPERATION";
+                case GL_INVALID_FRAMEBUFFER_OPERATION:
+                    return "GL_INVALID_FRAMEBUFFER_OPERATION";
+                case GL_OUT_OF_MEMORY:
+                    return "GL_OUT_OF_MEMORY";
+            }
+            return "unknown gl error";
+        }
+
+        /// glGetError until clean; error flags are sticky per kind, so
+        /// few iterations at most. Return true if there was an error
+        bool poll_errors(gl_call_site& site)
+        {
+            bool found = false;
+            for (int i = 0; i < 8; ++i)
+            {
+                const GLenum error = glGetError();
+                if (error == GL_NO_ERROR)
+                {
+                    break;
+                }
+                add_error(site, error, error_name(error));
+                found = true;
+            }
+            return found;
+        }
+
+        void take_message(gl_call_site& site)
+        {
+            gl_debug_detail::message_pending.store(false,
+                                                   std::memory_order_relaxed);
+            add_error(site, pending_message.id, pending_message.text);
+        }
+
+        void GLAPIENTRY on_debug_message(GLenum /*source*/, GLenum type, GLuint id,
+                                         GLenum severity, GLsizei length,
+                                         const GLchar* message,
+                                         const void* /*user*/)
+        {
+            // notifications (buffer placed in vram and such) are noise here
+            if (severity == GL_DEBUG_SEVERITY_NOTIFICATION ||
+                type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP)
+            {
+                return;
+            }
+            // one call may raise several, last one wins
+            pending_message.id = id;
+            pending_message.text =
+                    length < 0 ? std::string(message) : std::string(message, length);
+            gl_debug_detail::message_pending.store(true, std::memory_order_relaxed);
+        }
+
+        bool enable_callback()
+        {
+            if (SDL_GL_ExtensionSupported("GL_KHR_debug"))
+            {
+                // desktop core 4.3 names it without suffix, gles with KHR
+                glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(
+                        SDL_GL_GetProcAddress("glDebugMessageCallback"));
+                if (glDebugMessageCallback == nullptr)
+                {
+                    glDebugMessageCallback =
+                            reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(
+                                    SDL_GL_GetProcAddress("glDebugMessageCallbackKHR"));
+                }
+            }
+            else if (SDL_GL_ExtensionSupported("GL_ARB_debug_output"))
+            {
+                // same signature, ARB enums share values with KHR ones
+                glDebugMessageCallback = reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKPROC>(
+                        SDL_GL_GetProcAddress("glDebugMessageCallbackARB"));
+            }
+            if (glDebugMessageCallback == nullptr)
+            {
+                return false;
+            }
+            glDebugMessageCallback(on_debug_message, nullptr);
+            // ARB_debug_output has no GL_DEBUG_OUTPUT switch, it is on
+            // in debug contexts: drop INVALID_ENUM from this call
+            glEnable(GL_DEBUG_OUTPUT);
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            while (glGetError() != GL_NO_ERROR)
+            {
+            }
+            return true;
+        }
+    } // namespace
+
+    void gl_debug_detail::check(gl_call_site& site)
+    {
+        bool found = false;
+        if (message_pending.load(std::memory_order_relaxed))
+        {
+            take_message(site);
+            found = true;
+        }
+        if (mode == gl_debug_mode::poll)
+        {
+            countdown = poll_interval;
+            found     = poll_errors(site) || found;
+        }
+        else
+        {
+            countdown = std::numeric_limits<std::uint32_t>::max();
+        }
+        if (!found)
+        {
+            last_clean = &site;
+        }
+    }
+
+    gl_debug_mode gl_debug_initialize(gl_debug_mode wanted,
+                                      std::uint32_t poll_interval_)
+    {
+        mode          = wanted;
+        poll_interval = poll_interval_ == 0 ? 1 : poll_interval_;
+        if (mode == gl_debug_mode::callback && !enable_callback())
+        {
+            mode = gl_debug_mode::frame;
+        }
+        gl_debug_detail::countdown = mode == gl_debug_mode::poll
+                                             ? poll_interval
+                                             : std::numeric_limits<std::uint32_t>::max();
+        return mode;
+    }
+
+    void gl_debug_end_frame()
+    {
+        if (gl_debug_detail::message_pending.load(std::memory_order_relaxed))
+        {
+            take_message(frame_site);
+        }
+        if (mode == gl_debug_mode::frame)
+        {
+            poll_errors(frame_site);
+        }
+    }
+
+    void gl_debug_uninitialize()
+    {
+        if (mode == gl_debug_mode::callback)
+        {
+            glDebugMessageCallback(nullptr, nullptr);
+        }
+        mode = gl_debug_mode::off;
+    }
+
+    std::string gl_debug_report()
+    {
+        std::ostringstream out;
+        for (const gl_call_site* site = first_site; site != nullptr;
+             site                     = site->next)
+        {
+            out << site->file << ':' << site->line << ": " << site->errors
+                << " gl error(s), last: " << site->last_message << " (0x"
+                << std::hex << site->last_code << std::dec << ')';
+            if (site->after != nullptr)
+            {
+                out << ", raised after " << site->after->file << ':'
+                    << site->after->line;
+            }
+            out << '\n';
+        }
+        return out.str();
+    }
+
+#endif // eng_GL_DEBUG
+
+    bool parse_gl_debug_mode(std::string_view name, gl_debug_mode& out)
+    {
+        if (name == "callback")
+        {
+            out = gl_debug_mode::callback;
+        }
+        else if (name == "poll")
+        {
+            out = gl_debug_mode::poll;
+        }
+        else if (name == "frame")
+        {
+            out = gl_debug_mode::frame;
+        }
+        else if (name == "off")
+        {
+            out = gl_debug_mode::off;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+} // end namespace eng
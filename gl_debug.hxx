@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// eng_GL_DEBUG 1 - eng_GL_CHECK() reports gl errors per call site,
+/// 0 - eng_GL_CHECK() expands to nothing, gl errors are never queried.
+/// Default: on in debug builds, off when NDEBUG is defined
+#ifndef eng_GL_DEBUG
+#ifdef NDEBUG
+#define eng_GL_DEBUG 0
+#else
+#define eng_GL_DEBUG 1
+#endif
+#endif
+
+namespace eng
+{
+
+/// how errors are found when eng_GL_DEBUG is on ("gl_debug" config key)
+    enum class gl_debug_mode
+    {
+        off,
+        /// KHR_debug / ARB_debug_output callback, synchronous, so message
+        /// lands on check right after offending call; no glGetError
+        callback,
+        /// glGetError on every N-th check, N = 1 points at exact call
+        poll,
+        /// glGetError once per swap_buffers
+        frame
+    };
+
+/// place of eng_GL_CHECK() in source, errors found there add up in it
+    struct gl_call_site
+    {
+        gl_call_site(const char* file_, int line_)
+            : file(file_)
+            , line(line_)
+        {
+        }
+
+        const char*   file;
+        int           line;
+        std::uint32_t errors = 0;
+        /// gl error enum or debug message id of last error
+        std::uint32_t last_code = 0;
+        std::string   last_message;
+        /// previous site checked clean, error came from calls in between
+        const gl_call_site* after = nullptr;
+        gl_call_site*       next  = nullptr;
+    };
+
+#if eng_GL_DEBUG
+    namespace gl_debug_detail
+    {
+        /// set by debug callback, checks decrement in poll mode
+        extern std::atomic<bool> message_pending;
+        extern std::uint32_t     countdown;
+        extern gl_call_site*     last_clean;
+
+        void check(gl_call_site& site);
+    } // namespace gl_debug_detail
+
+/// once per eng_GL_CHECK(): few instructions, no gl call unless due
+    inline void gl_debug_check(gl_call_site& site)
+    {
+        if (gl_debug_detail::message_pending.load(std::memory_order_relaxed) ||
+            --gl_debug_detail::countdown == 0)
+        {
+            gl_debug_detail::check(site);
+        }
+        else
+        {
+            gl_debug_detail::last_clean = &site;
+        }
+    }
+
+/// after context creation and loading of gl functions; callback mode
+/// without debug extension falls back to frame. Return mode in use
+    gl_debug_mode gl_debug_initialize(gl_debug_mode wanted,
+                                      std::uint32_t poll_interval);
+/// frame mode check, and home of callback messages raised outside checks
+    void gl_debug_end_frame();
+/// turn callback off before context is destroyed
+    void gl_debug_uninitialize();
+/// one line per call site with errors, empty if there were none
+    std::string gl_debug_report();
+#else
+    inline gl_debug_mode gl_debug_initialize(gl_debug_mode, std::uint32_t)
+    {
+        return gl_debug_mode::off;
+    }
+    inline void        gl_debug_end_frame() {}
+    inline void        gl_debug_uninitialize() {}
+    inline std::string gl_debug_report() { return {}; }
+#endif
+
+/// "callback", "poll", "frame", "off"; false on unknown name
+    bool parse_gl_debug_mode(std::string_view name, gl_debug_mode& out);
+
+} // end namespace eng
+
+#if eng_GL_DEBUG
+#define eng_GL_CHECK()                                                         \
+    {                                                                          \
+        static ::eng::gl_call_site eng_gl_site{ __FILE__, __LINE__ };          \
+        ::eng::gl_debug_check(eng_gl_site);                                    \
+    }
+#else
+#define eng_GL_CHECK()
+#endif
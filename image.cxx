@@ -0,0 +1,59 @@
+#include "image.hxx"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "log.hxx"
+#include "picopng.hxx"
+
+namespace eng
+{
+
+    image load_png_image(std::string_view path)
+    {
+        std::vector<unsigned char> png_file_in_memory;
+        std::ifstream              ifs(std::string(path), std::ios_base::binary);
+        if (!ifs)
+        {
+            throw std::runtime_error("can't load texture");
+        }
+        ifs.seekg(0, std::ios_base::end);
+        std::streamoff pos_in_file = ifs.tellg();
+        png_file_in_memory.resize(static_cast<size_t>(pos_in_file));
+        ifs.seekg(0, std::ios_base::beg);
+        if (!ifs)
+        {
+            throw std::runtime_error("can't load texture1");
+        }
+
+        ifs.read(reinterpret_cast<char*>(png_file_in_memory.data()), pos_in_file);
+        if (!ifs.good())
+        {
+            throw std::runtime_error("can't load texture3");
+        }
+
+        image         result;
+        unsigned long w = 0;
+        unsigned long h = 0;
+        int error = decodePNG(result.pixels, w, h, &png_file_in_memory[0],
+                              png_file_in_memory.size(), false);
+
+        // if there's an error, display it
+        if (error != 0)
+        {
+            eng_LOG(error, texture, "png decode error {}", error);
+            throw std::runtime_error("can't load texture2");
+        }
+        // no color conversion is done, so only RGBA 8-bit images fit
+        if (result.pixels.size() != static_cast<size_t>(w) * h * 4)
+        {
+            throw std::runtime_error("texture is not RGBA 8-bit: " +
+                                     std::string(path));
+        }
+        result.width  = static_cast<std::uint32_t>(w);
+        result.height = static_cast<std::uint32_t>(h);
+        return result;
+    }
+
+} // end namespace eng
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace eng
+{
+
+/// decoded 32-bit RGBA pixels, first row is top of picture
+    struct image
+    {
+        std::vector<unsigned char> pixels;
+        std::uint32_t              width  = 0;
+        std::uint32_t              height = 0;
+    };
+
+/// read and decode png file
+/// throw std::runtime_error on io error or not RGBA 8-bit png
+    image load_png_image(std::string_view path);
+
+} // end namespace eng
@@ -0,0 +1,151 @@
+#include "input.hxx"
+
+#include <string>
+
+#include <SDL2/SDL.h>
+
+namespace eng
+{
+
+    static_assert(SDL_NUM_SCANCODES <= 512, "scancode table too small");
+    static_assert(pressed_event(button::left) == event::left_pressed &&
+                          released_event(button::button2) ==
+                                  event::button2_released,
+                  "button order must follow event order");
+
+    static constexpr std::array<std::string_view, button_count> button_names = {
+        { "left", "right", "up", "down", "select", "start", "button1", "button2" }
+    };
+
+    bool parse_button(std::string_view name, button& out)
+    {
+        for (std::size_t i = 0; i < button_names.size(); ++i)
+        {
+            if (button_names[i] == name)
+            {
+                out = static_cast<button>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    input_pump::input_pump()
+    {
+        table.fill(unbound);
+        const std::array<std::pair<button, SDL_Scancode>, button_count> defaults{
+            { { button::up, SDL_SCANCODE_W },
+              { button::left, SDL_SCANCODE_A },
+              { button::down, SDL_SCANCODE_S },
+              { button::right, SDL_SCANCODE_D },
+              { button::button1, SDL_SCANCODE_LCTRL },
+              { button::button2, SDL_SCANCODE_SPACE },
+              { button::select, SDL_SCANCODE_ESCAPE },
+              { button::start, SDL_SCANCODE_RETURN } }
+        };
+        for (const auto& [b, scancode] : defaults)
+        {
+            const auto index = static_cast<std::size_t>(b);
+            table[static_cast<std::size_t>(scancode)] =
+                    static_cast<std::uint8_t>(index);
+            keys[index] = static_cast<std::uint32_t>(scancode);
+        }
+    }
+
+    void input_pump::pump()
+    {
+        SDL_PumpEvents();
+        queued = false;
+        constexpr int batch_size = 64;
+        SDL_Event     batch[batch_size];
+        int           count = 0;
+        do
+        {
+            count = SDL_PeepEvents(batch, batch_size, SDL_GETEVENT, SDL_FIRSTEVENT,
+                                   SDL_LASTEVENT);
+            for (int i = 0; i < count; ++i)
+            {
+                const SDL_Event& e = batch[i];
+                if (e.type == SDL_QUIT)
+                {
+                    push(event::turn_off);
+                    continue;
+                }
+                if (e.type != SDL_KEYDOWN && e.type != SDL_KEYUP)
+                {
+                    continue;
+                }
+                const auto scancode = static_cast<std::size_t>(e.key.keysym.scancode);
+                if (scancode >= scancode_count || table[scancode] == unbound)
+                {
+                    continue;
+                }
+                const std::size_t index = table[scancode];
+                const auto        b     = static_cast<button>(index);
+                // SDL queue is in arrival order, first key is oldest
+                if (!queued && e.key.repeat == 0)
+                {
+                    queued       = true;
+                    oldest_ticks = e.key.timestamp;
+                }
+                if (e.type == SDL_KEYDOWN)
+                {
+                    if (e.key.repeat == 0)
+                    {
+                        held.set(index);
+                        push(pressed_event(b));
+                    }
+                }
+                else
+                {
+                    held.reset(index);
+                    push(released_event(b));
+                }
+            }
+        } while (count == batch_size);
+    }
+
+    bool input_pump::pop(event& e)
+    {
+        if (head == tail)
+        {
+            return false;
+        }
+        e = ring[tail % ring_size];
+        ++tail;
+        return true;
+    }
+
+    bool input_pump::bind(button b, std::string_view key_name)
+    {
+        const SDL_Scancode scancode =
+                SDL_GetScancodeFromName(std::string(key_name).c_str());
+        if (scancode == SDL_SCANCODE_UNKNOWN ||
+            static_cast<std::size_t>(scancode) >= scancode_count)
+        {
+            return false;
+        }
+        const auto index = static_cast<std::size_t>(b);
+        if (table[keys[index]] == index)
+        {
+            table[keys[index]] = unbound;
+        }
+        // key taken from other button leaves that one without key
+        table[static_cast<std::size_t>(scancode)] = static_cast<std::uint8_t>(index);
+        keys[index]                               = static_cast<std::uint32_t>(scancode);
+        held.reset(index);
+        return true;
+    }
+
+    void input_pump::push(event e)
+    {
+        if (head - tail == ring_size)
+        {
+            ++dropped;
+            return;
+        }
+        ring[head % ring_size] = e;
+        ++head;
+    }
+
+} // end namespace eng
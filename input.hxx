@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// "up", "left", "button1" ... -> button; false on unknown name
+    bool parse_button(std::string_view name, button& out);
+
+/// keyboard state of one frame: SDL queue is drained in batches once
+/// per pump, scancodes map to buttons through direct table, results
+/// are event ring for read_input and held button snapshot.
+/// Cost of pump depends only on events in SDL queue, not on bindings
+    class input_pump
+    {
+    public:
+        /// default keys: WASD, left ctrl, space, escape, enter
+        input_pump();
+
+        /// drain SDL queue, update held buttons, queue press and release
+        /// events (key repeat ignored) and turn_off on window close
+        void pump();
+        /// false when ring is empty
+        bool pop(event& e);
+        button_set get_held() const { return held; }
+        /// see engine::bind_key
+        bool bind(button b, std::string_view key_name);
+        /// SDL_GetTicks time of oldest key event queued by last pump,
+        /// false when it queued none
+        bool get_oldest_ticks(std::uint32_t& ticks) const
+        {
+            ticks = oldest_ticks;
+            return queued;
+        }
+        /// events lost because ring was full (held state stays right)
+        std::uint32_t get_dropped() const { return dropped; }
+
+    private:
+        void push(event e);
+
+        /// SDL_NUM_SCANCODES, checked in input.cxx
+        static constexpr std::size_t scancode_count = 512;
+        static constexpr std::uint8_t unbound        = 0xff;
+        static constexpr std::size_t ring_size      = 256;
+
+        std::array<std::uint8_t, scancode_count> table;
+        /// scancode bound to button, to unbind on remap
+        std::array<std::uint32_t, button_count> keys{};
+
+        std::array<event, ring_size> ring{};
+        std::uint32_t                head    = 0;
+        std::uint32_t                tail    = 0;
+        std::uint32_t                dropped = 0;
+        button_set                   held;
+        std::uint32_t                oldest_ticks = 0;
+        bool                         queued       = false;
+    };
+
+} // end namespace eng
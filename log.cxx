@@ -0,0 +1,448 @@
+#include "log.hxx"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng
+{
+
+    namespace log_detail
+    {
+        std::atomic<std::uint8_t> levels[log_category_count] = {
+            { static_cast<std::uint8_t>(log_level::info) },
+            { static_cast<std::uint8_t>(log_level::info) },
+            { static_cast<std::uint8_t>(log_level::info) },
+            { static_cast<std::uint8_t>(log_level::info) },
+            { static_cast<std::uint8_t>(log_level::info) }
+        };
+    } // namespace log_detail
+
+    namespace
+    {
+        constexpr std::array<std::string_view, 6> level_names = {
+            { "trace", "debug", "info", "warn", "error", "off" }
+        };
+        constexpr std::array<std::string_view, log_category_count> category_names = {
+            { "engine", "gl", "texture", "input", "game" }
+        };
+
+        /// arg_count of padding record filling ring up to its end
+        constexpr std::uint32_t skip_record = ~std::uint32_t(0);
+
+        constexpr std::uint32_t align8(std::uint32_t size) { return (size + 7) & ~7u; }
+
+        /// one writer (owner thread), one reader (writer thread); records
+        /// are contiguous, 8 byte aligned, never split by end of ring
+        struct log_ring
+        {
+            static constexpr std::size_t capacity = 1 << 16;
+
+            std::atomic<std::uint64_t> head{ 0 };
+            std::atomic<std::uint64_t> tail{ 0 };
+            std::atomic<std::uint64_t> dropped{ 0 };
+            /// end of record between begin_record and end_record
+            std::uint64_t              pending = 0;
+            alignas(8) std::array<std::uint8_t, capacity> bytes;
+        };
+
+        struct logger
+        {
+            const std::chrono::steady_clock::time_point start =
+                    std::chrono::steady_clock::now();
+
+            std::mutex                             mutex;
+            std::condition_variable                wake;
+            std::condition_variable                flushed;
+            std::vector<std::shared_ptr<log_ring>> rings;
+            std::thread                            thread;
+            bool                                   stop            = false;
+            std::uint64_t                          flush_requested = 0;
+            std::uint64_t                          flush_done      = 0;
+
+            /// output, touched by writer thread only except set_log_file
+            std::mutex out_mutex;
+            std::FILE* out = stderr;
+
+            void run();
+            /// format everything published so far; return false if idle
+            bool drain(std::string& text);
+        };
+
+        /// set once writer thread runs
+        std::atomic<logger*> started{ nullptr };
+
+        logger& get_logger()
+        {
+            // never destroyed: threads may log during static destruction
+            static logger* instance = [] {
+                auto* l   = new logger();
+                l->thread = std::thread([l] { l->run(); });
+                started.store(l);
+                return l;
+            }();
+            return *instance;
+        }
+
+        /// joins writer thread at exit so last messages reach output
+        struct logger_stopper
+        {
+            ~logger_stopper()
+            {
+                logger* started_logger = started.load();
+                if (started_logger == nullptr)
+                {
+                    return;
+                }
+                logger& l = *started_logger;
+                {
+                    std::lock_guard<std::mutex> lock(l.mutex);
+                    l.stop = true;
+                }
+                l.wake.notify_all();
+                if (l.thread.joinable())
+                {
+                    l.thread.join();
+                }
+            }
+        } stopper;
+
+        log_ring& get_thread_ring()
+        {
+            // logger keeps ring alive after thread exit, until it is drained
+            thread_local log_ring* ring = [] {
+                logger&                     l = get_logger();
+                std::lock_guard<std::mutex> lock(l.mutex);
+                l.rings.push_back(std::make_shared<log_ring>());
+                return l.rings.back().get();
+            }();
+            return *ring;
+        }
+
+        template <typename T>
+        T read_value(const std::uint8_t*& in)
+        {
+            T value;
+            std::memcpy(&value, in, sizeof(T));
+            in += sizeof(T);
+            return value;
+        }
+
+        void format_arg(const std::uint8_t*& in, std::string& text)
+        {
+            char buffer[32];
+            int  length = 0;
+            switch (static_cast<log_detail::arg_type>(*in++))
+            {
+                case log_detail::arg_type::boolean:
+                    text += read_value<std::uint64_t>(in) != 0 ? "true" : "false";
+                    return;
+                case log_detail::arg_type::signed_int:
+                    length = std::snprintf(buffer, sizeof(buffer), "%lld",
+                                           static_cast<long long>(
+                                                   read_value<std::int64_t>(in)));
+                    break;
+                case log_detail::arg_type::unsigned_int:
+                    length = std::snprintf(buffer, sizeof(buffer), "%llu",
+                                           static_cast<unsigned long long>(
+                                                   read_value<std::uint64_t>(in)));
+                    break;
+                case log_detail::arg_type::floating:
+                    length = std::snprintf(buffer, sizeof(buffer), "%g",
+                                           read_value<double>(in));
+                    break;
+                case log_detail::arg_type::pointer:
+                    length = std::snprintf(buffer, sizeof(buffer), "0x%llx",
+                                           static_cast<unsigned long long>(
+                                                   read_value<std::uint64_t>(in)));
+                    break;
+                case log_detail::arg_type::string:
+                {
+                    const auto size = read_value<std::uint32_t>(in);
+                    text.append(reinterpret_cast<const char*>(in), size);
+                    in += size;
+                    return;
+                }
+            }
+            text.append(buffer, static_cast<std::size_t>(std::max(length, 0)));
+        }
+
+        struct formatted
+        {
+            std::uint64_t time_ns;
+            std::string   line;
+        };
+
+        void format_record(const std::uint8_t* in, std::uint64_t start_ns,
+                           std::vector<formatted>& out)
+        {
+            const auto header = read_value<log_detail::record_header>(in);
+            const log_site& site = *header.site;
+
+            std::string line;
+            char        prefix[64];
+            const int   length = std::snprintf(
+                    prefix, sizeof(prefix), "%11.6f %-5s %-7s ",
+                    static_cast<double>(header.time_ns - start_ns) * 1e-9,
+                    level_names[static_cast<std::size_t>(site.level)].data(),
+                    category_names[static_cast<std::size_t>(site.category)].data());
+            line.append(prefix, static_cast<std::size_t>(std::max(length, 0)));
+
+            // "{}" takes next argument, missing ones stay as "{}"
+            std::uint32_t args_left = header.arg_count;
+            for (const char* f = header.format; *f != '\0'; ++f)
+            {
+                if (f[0] == '{' && f[1] == '}' && args_left > 0)
+                {
+                    format_arg(in, line);
+                    --args_left;
+                    ++f;
+                }
+                else
+                {
+                    line += *f;
+                }
+            }
+            if (site.level >= log_level::warn)
+            {
+                line += " (";
+                line += site.file;
+                line += ':';
+                line += std::to_string(site.line);
+                line += ')';
+            }
+            line += '\n';
+            out.push_back({ header.time_ns, std::move(line) });
+        }
+
+        void logger::run()
+        {
+            std::string text;
+            bool        busy = false;
+            for (;;)
+            {
+                std::uint64_t request  = 0;
+                bool          stopping = false;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    // keep going without sleep while rings have data
+                    if (!busy)
+                    {
+                        wake.wait_for(lock, std::chrono::milliseconds(2), [this] {
+                            return stop || flush_requested != flush_done;
+                        });
+                    }
+                    request  = flush_requested;
+                    stopping = stop;
+                }
+                // one pass covers everything published before request
+                busy = drain(text);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    flush_done = request;
+                }
+                flushed.notify_all();
+                if (stopping)
+                {
+                    while (drain(text))
+                    {
+                    }
+                    return;
+                }
+            }
+        }
+
+        bool logger::drain(std::string& text)
+        {
+            std::vector<std::shared_ptr<log_ring>> current;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                current = rings;
+            }
+            const std::uint64_t start_ns = static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            start.time_since_epoch())
+                            .count());
+
+            std::vector<formatted> lines;
+            std::uint64_t          dropped = 0;
+            for (const auto& ring : current)
+            {
+                dropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+                const std::uint64_t head = ring->head.load(std::memory_order_acquire);
+                std::uint64_t       tail = ring->tail.load(std::memory_order_relaxed);
+                while (tail != head)
+                {
+                    const std::uint8_t* record =
+                            ring->bytes.data() + tail % log_ring::capacity;
+                    std::uint32_t size      = 0;
+                    std::uint32_t arg_count = 0;
+                    std::memcpy(&size, record, sizeof(size));
+                    std::memcpy(&arg_count, record + sizeof(size), sizeof(arg_count));
+                    if (arg_count != skip_record)
+                    {
+                        format_record(record, start_ns, lines);
+                    }
+                    tail += align8(size);
+                }
+                ring->tail.store(tail, std::memory_order_release);
+            }
+            if (lines.empty() && dropped == 0)
+            {
+                return false;
+            }
+
+            // rings of different threads interleave by time
+            std::stable_sort(lines.begin(), lines.end(),
+                             [](const formatted& a, const formatted& b) {
+                                 return a.time_ns < b.time_ns;
+                             });
+            text.clear();
+            for (const formatted& f : lines)
+            {
+                text += f.line;
+            }
+            if (dropped != 0)
+            {
+                text += "log: " + std::to_string(dropped) +
+                        " message(s) dropped, ring was full\n";
+            }
+            std::lock_guard<std::mutex> lock(out_mutex);
+            std::fwrite(text.data(), 1, text.size(), out);
+            std::fflush(out);
+            return true;
+        }
+    } // namespace
+
+    namespace log_detail
+    {
+        std::uint8_t* begin_record(std::uint32_t size)
+        {
+            log_ring&           ring    = get_thread_ring();
+            const std::uint32_t aligned = align8(size);
+            if (aligned > log_ring::capacity / 2)
+            {
+                ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            std::uint64_t       head   = ring.head.load(std::memory_order_relaxed);
+            const std::uint64_t offset = head % log_ring::capacity;
+            const std::uint64_t pad    = offset + aligned > log_ring::capacity
+                                                 ? log_ring::capacity - offset
+                                                 : 0;
+            const std::uint64_t used =
+                    head - ring.tail.load(std::memory_order_acquire);
+            if (used + pad + aligned > log_ring::capacity)
+            {
+                ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            if (pad != 0)
+            {
+                const auto pad_size = static_cast<std::uint32_t>(pad);
+                std::memcpy(ring.bytes.data() + offset, &pad_size, sizeof(pad_size));
+                std::memcpy(ring.bytes.data() + offset + sizeof(pad_size),
+                            &skip_record, sizeof(skip_record));
+                head += pad;
+            }
+            ring.pending = head + aligned;
+            return ring.bytes.data() + head % log_ring::capacity;
+        }
+
+        void end_record()
+        {
+            log_ring& ring = get_thread_ring();
+            ring.head.store(ring.pending, std::memory_order_release);
+        }
+
+        std::uint64_t now_ns()
+        {
+            return static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count());
+        }
+    } // namespace log_detail
+
+    bool parse_log_level(std::string_view name, log_level& out)
+    {
+        for (std::size_t i = 0; i < level_names.size(); ++i)
+        {
+            if (level_names[i] == name)
+            {
+                out = static_cast<log_level>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parse_log_category(std::string_view name, log_category& out)
+    {
+        for (std::size_t i = 0; i < category_names.size(); ++i)
+        {
+            if (category_names[i] == name)
+            {
+                out = static_cast<log_category>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void set_log_level(log_level level)
+    {
+        for (auto& current : log_detail::levels)
+        {
+            current.store(static_cast<std::uint8_t>(level), std::memory_order_relaxed);
+        }
+    }
+
+    void set_log_level(log_category category, log_level level)
+    {
+        log_detail::levels[static_cast<std::size_t>(category)].store(
+                static_cast<std::uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    std::string set_log_file(std::string_view path)
+    {
+        std::FILE* file = stderr;
+        if (!path.empty())
+        {
+            file = std::fopen(std::string(path).c_str(), "w");
+            if (file == nullptr)
+            {
+                return "error: can't open log file: " + std::string(path);
+            }
+        }
+        log_flush();
+        logger&                     l = get_logger();
+        std::lock_guard<std::mutex> lock(l.out_mutex);
+        if (l.out != stderr)
+        {
+            std::fclose(l.out);
+        }
+        l.out = file;
+        return "";
+    }
+
+    void log_flush()
+    {
+        logger&                      l = get_logger();
+        std::unique_lock<std::mutex> lock(l.mutex);
+        if (l.stop)
+        {
+            return;
+        }
+        const std::uint64_t request = ++l.flush_requested;
+        l.wake.notify_all();
+        l.flushed.wait(lock, [&] { return l.flush_done >= request; });
+    }
+
+} // end namespace eng
@@ -0,0 +1,221 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+    enum class log_level : std::uint8_t
+    {
+        trace,
+        debug,
+        info,
+        warn,
+        error,
+        /// filter only: nothing passes
+        off
+    };
+
+    enum class log_category : std::uint8_t
+    {
+        engine,
+        gl,
+        texture,
+        input,
+        game
+    };
+    constexpr std::size_t log_category_count = 5;
+
+/// "trace" ... "error", "off"; false on unknown name
+    bool eng_DECLSPEC parse_log_level(std::string_view name, log_level& out);
+/// "engine", "gl", "texture", "input", "game"; false on unknown name
+    bool eng_DECLSPEC parse_log_category(std::string_view name, log_category& out);
+
+/// messages below level are dropped before any argument is encoded;
+/// default info for every category
+    void eng_DECLSPEC set_log_level(log_level level);
+    void eng_DECLSPEC set_log_level(log_category category, log_level level);
+/// write next messages to file instead of stderr, empty path - stderr
+/// on success return empty string
+    std::string eng_DECLSPEC set_log_file(std::string_view path);
+/// wait until writer thread has written everything logged before the call
+    void eng_DECLSPEC log_flush();
+
+/// where message comes from, one static per eng_LOG
+    struct log_site
+    {
+        log_level    level;
+        log_category category;
+        const char*  file;
+        int          line;
+    };
+
+    namespace log_detail
+    {
+        /// kind of encoded argument, one byte before its payload
+        enum class arg_type : std::uint8_t
+        {
+            boolean,
+            signed_int,
+            unsigned_int,
+            floating,
+            pointer,
+            /// std::uint32_t length, then bytes
+            string
+        };
+
+        /// current level per category, relaxed load on every eng_LOG
+        extern eng_DECLSPEC std::atomic<std::uint8_t> levels[log_category_count];
+
+        inline bool enabled(log_level level, log_category category)
+        {
+            return static_cast<std::uint8_t>(level) >=
+                   levels[static_cast<std::size_t>(category)].load(
+                           std::memory_order_relaxed);
+        }
+
+        /// space for size bytes in ring of calling thread, nullptr if ring
+        /// is full (message is counted as dropped)
+        std::uint8_t* eng_DECLSPEC begin_record(std::uint32_t size);
+        /// publish record from begin_record to writer thread
+        void eng_DECLSPEC end_record();
+
+        template <typename T>
+        constexpr arg_type type_of()
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return arg_type::boolean;
+            else if constexpr (std::is_floating_point_v<T>)
+                return arg_type::floating;
+            else if constexpr (std::is_enum_v<T> || std::is_signed_v<T>)
+                return arg_type::signed_int;
+            else if constexpr (std::is_unsigned_v<T>)
+                return arg_type::unsigned_int;
+            else
+                return arg_type::pointer;
+        }
+
+        inline std::string_view as_string(const char* s)
+        {
+            return s == nullptr ? std::string_view("(null)") : std::string_view(s);
+        }
+        inline std::string_view as_string(std::string_view s) { return s; }
+        inline std::string_view as_string(const std::string& s) { return s; }
+
+        template <typename T>
+        constexpr bool is_string_v =
+                std::is_convertible_v<const T&, std::string_view> ||
+                std::is_same_v<std::decay_t<T>, char*> ||
+                std::is_same_v<std::decay_t<T>, const char*>;
+
+        template <typename T>
+        std::uint32_t arg_size(const T& value)
+        {
+            if constexpr (is_string_v<T>)
+                return 1 + sizeof(std::uint32_t) +
+                       static_cast<std::uint32_t>(as_string(value).size());
+            else
+                return 1 + 8;
+        }
+
+        template <typename T>
+        std::uint8_t* put_arg(std::uint8_t* out, const T& value)
+        {
+            if constexpr (is_string_v<T>)
+            {
+                const std::string_view s    = as_string(value);
+                const auto             size = static_cast<std::uint32_t>(s.size());
+                *out++                      = static_cast<std::uint8_t>(arg_type::string);
+                std::memcpy(out, &size, sizeof(size));
+                std::memcpy(out + sizeof(size), s.data(), size);
+                return out + sizeof(size) + size;
+            }
+            else
+            {
+                constexpr arg_type type = type_of<T>();
+                *out++                  = static_cast<std::uint8_t>(type);
+                if constexpr (type == arg_type::floating)
+                {
+                    const double v = static_cast<double>(value);
+                    std::memcpy(out, &v, 8);
+                }
+                else if constexpr (type == arg_type::pointer)
+                {
+                    const auto v = reinterpret_cast<std::uint64_t>(
+                            static_cast<const void*>(value));
+                    std::memcpy(out, &v, 8);
+                }
+                else if constexpr (type == arg_type::unsigned_int ||
+                                   type == arg_type::boolean)
+                {
+                    const auto v = static_cast<std::uint64_t>(value);
+                    std::memcpy(out, &v, 8);
+                }
+                else
+                {
+                    const auto v = static_cast<std::int64_t>(value);
+                    std::memcpy(out, &v, 8);
+                }
+                return out + 8;
+            }
+        }
+
+        struct record_header
+        {
+            std::uint32_t   size;
+            std::uint32_t   arg_count;
+            const log_site* site;
+            const char*     format;
+            std::uint64_t   time_ns;
+        };
+
+        std::uint64_t eng_DECLSPEC now_ns();
+
+        /// encode arguments as bytes, formatting waits for writer thread
+        template <typename... Args>
+        void write(const log_site& site, const char* format, const Args&... args)
+        {
+            const std::uint32_t size =
+                    static_cast<std::uint32_t>(sizeof(record_header)) +
+                    (0 + ... + arg_size(args));
+            std::uint8_t* out = begin_record(size);
+            if (out == nullptr)
+            {
+                return;
+            }
+            const record_header header{ size, sizeof...(Args), &site, format,
+                                        now_ns() };
+            std::memcpy(out, &header, sizeof(header));
+            out += sizeof(header);
+            ((out = put_arg(out, args)), ...);
+            end_record();
+        }
+    } // namespace log_detail
+
+} // end namespace eng
+
+/// eng_LOG(level, category, "format {} with {}", args...)
+/// level and category are names of log_level and log_category values.
+/// Arguments: numbers, bool, enums (as numbers), strings (copied),
+/// pointers. Caller pays filter check and memcpy to its thread ring,
+/// formatting and output happen on writer thread; full ring drops message
+#define eng_LOG(level, category, ...)                                          \
+    do                                                                         \
+    {                                                                          \
+        if (::eng::log_detail::enabled(::eng::log_level::level,                \
+                                       ::eng::log_category::category))         \
+        {                                                                      \
+            static constexpr ::eng::log_site eng_log_site{                     \
+                ::eng::log_level::level, ::eng::log_category::category,        \
+                __FILE__, __LINE__                                             \
+            };                                                                 \
+            ::eng::log_detail::write(eng_log_site, __VA_ARGS__);               \
+        }                                                                      \
+    } while (false)
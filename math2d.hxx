@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+namespace eng
+{
+
+    inline constexpr double pi = 3.14159265358979323846;
+
+/// header-only math: everything inline and constexpr where possible
+/// so calls from game code are inlined and constant transforms fold
+/// at compile time
+
+    class color
+    {
+    public:
+        constexpr color() = default;
+        constexpr explicit color(std::uint32_t rgba_)
+            : rgba(rgba_)
+        {
+        }
+        constexpr color(float r, float g, float b, float a)
+            : rgba(pack(a) << 24 | pack(b) << 16 | pack(g) << 8 | pack(r))
+        {
+            assert(r <= 1 && r >= 0);
+            assert(g <= 1 && g >= 0);
+            assert(b <= 1 && b >= 0);
+            assert(a <= 1 && a >= 0);
+        }
+
+        constexpr float get_r() const { return unpack(rgba >> 0); }
+        constexpr float get_g() const { return unpack(rgba >> 8); }
+        constexpr float get_b() const { return unpack(rgba >> 16); }
+        constexpr float get_a() const { return unpack(rgba >> 24); }
+
+        constexpr void set_r(const float r) { set(r, 0); }
+        constexpr void set_g(const float g) { set(g, 8); }
+        constexpr void set_b(const float b) { set(b, 16); }
+        constexpr void set_a(const float a) { set(a, 24); }
+
+        /// packed as a << 24 | b << 16 | g << 8 | r
+        constexpr std::uint32_t get_rgba() const { return rgba; }
+
+    private:
+        static constexpr std::uint32_t pack(float channel)
+        {
+            return static_cast<std::uint32_t>(channel * 255);
+        }
+        static constexpr float unpack(std::uint32_t shifted)
+        {
+            return (shifted & 0xFF) / 255.f;
+        }
+        constexpr void set(float channel, unsigned shift)
+        {
+            rgba &= ~(0xFFu << shift);
+            rgba |= pack(channel) << shift;
+        }
+
+        std::uint32_t rgba = 0;
+    };
+
+/// per channel product, as tint times vertex color in shaders
+    constexpr color operator*(const color& c1, const color& c2)
+    {
+        std::uint32_t rgba = 0;
+        for (unsigned shift = 0; shift < 32; shift += 8)
+        {
+            const std::uint32_t a = (c1.get_rgba() >> shift) & 0xFF;
+            const std::uint32_t b = (c2.get_rgba() >> shift) & 0xFF;
+            rgba |= (a * b + 127) / 255 << shift;
+        }
+        return color(rgba);
+    }
+
+/// position in 2d space
+    struct vec2
+    {
+        constexpr vec2() = default;
+        constexpr vec2(float x_, float y_)
+            : x(x_)
+            , y(y_)
+        {
+        }
+        float x = 0.f;
+        float y = 0.f;
+    };
+
+    constexpr vec2 operator+(const vec2& v1, const vec2& v2)
+    {
+        return vec2(v1.x + v2.x, v1.y + v2.y);
+    }
+
+    constexpr vec2 operator-(const vec2& v1, const vec2& v2)
+    {
+        return vec2(v1.x - v2.x, v1.y - v2.y);
+    }
+
+    constexpr vec2 operator*(const vec2& v, float s)
+    {
+        return vec2(v.x * s, v.y * s);
+    }
+
+/// matrix for manipulate coordinates
+/// point p goes to p * m + delta (see transform)
+    struct mat2x3
+    {
+        /// all zeros, use identity() for unit matrix
+        constexpr mat2x3() = default;
+        constexpr mat2x3(vec2 row1_, vec2 row2_, vec2 delta_)
+            : row1(row1_)
+            , row2(row2_)
+            , delta(delta_)
+        {
+        }
+        static constexpr mat2x3 identity() { return scale(1.0f); }
+        static constexpr mat2x3 scale(float scal)
+        {
+            return mat2x3(vec2(scal, 0.f), vec2(0.f, scal), vec2());
+        }
+        /// alpha in degrees
+        static mat2x3 rotate(float alpha)
+        {
+            alpha = static_cast<float>(alpha * pi / 180.f);
+            const float c = std::cos(alpha);
+            const float s = std::sin(alpha);
+            return mat2x3(vec2(c, -s), vec2(s, c), vec2());
+        }
+        static constexpr mat2x3 move(vec2 delta)
+        {
+            mat2x3 result = identity();
+            result.delta  = delta;
+            return result;
+        }
+        vec2 row1;
+        vec2 row2;
+        vec2 delta;
+    };
+
+/// linear part only, delta is not applied
+    constexpr vec2 operator*(const vec2& v, const mat2x3& m)
+    {
+        return vec2(v.x * m.row1.x + v.y * m.row2.x, v.x * m.row1.y + v.y * m.row2.y);
+    }
+
+/// full affine transform: v * m + m.delta, same as u_matrix in shaders
+    constexpr vec2 transform(const vec2& v, const mat2x3& m)
+    {
+        return v * m + m.delta;
+    }
+
+/// apply m1 first, then m2
+    constexpr mat2x3 operator*(const mat2x3& m1, const mat2x3& m2)
+    {
+        mat2x3 result;
+        result.row1.x  = m1.row1.x * m2.row1.x + m1.row1.y * m2.row2.x;
+        result.row1.y  = m1.row1.x * m2.row1.y + m1.row1.y * m2.row2.y;
+        result.row2.x  = m1.row2.x * m2.row1.x + m1.row2.y * m2.row2.x;
+        result.row2.y  = m1.row2.x * m2.row1.y + m1.row2.y * m2.row2.y;
+        result.delta.x = m1.delta.x * m2.row1.x + m1.delta.y * m2.row2.x + m2.delta.x;
+        result.delta.y = m1.delta.x * m2.row1.y + m1.delta.y * m2.row2.y + m2.delta.y;
+        return result;
+    }
+
+    // compile-time checks, also document the conventions
+    static_assert(transform(vec2(1.f, 2.f), mat2x3::move(vec2(1.f, 1.f))).y == 3.f);
+    static_assert((mat2x3::scale(2.f) * mat2x3::move(vec2(1.f, 0.f))).delta.x == 1.f);
+    static_assert(color(1.f, 0.f, 0.f, 1.f).get_rgba() == 0xFF0000FF);
+
+} // end namespace eng
@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+#include "mesh_cache.hxx"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/// load time and peak memory of one geometry file through mesh_cache:
+/// text files are parsed, binary mesh files (mesh_convert) are mapped.
+/// Run once per file, peak memory is of whole process
+/// usage: mesh_bench <tri0|tri1|tri2> <file>
+
+/// peak resident set in MB, 0 where it can't be read
+static double peak_rss_mb()
+{
+#ifndef _WIN32
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_maxrss / 1024.0; // kB on linux
+    }
+#endif
+    return 0.0;
+}
+
+template <typename T>
+static int measure(const char* path)
+{
+    using clock = std::chrono::steady_clock;
+    using ms    = std::chrono::duration<double, std::milli>;
+
+    const double        rss_start = peak_rss_mb();
+    eng::mesh_cache     meshes;
+    const auto          start = clock::now();
+    eng::mesh_handle<T> handle;
+    try
+    {
+        handle = meshes.load<T>(path);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    const auto   loaded   = clock::now();
+    const double rss_load = peak_rss_mb();
+
+    // mapped file is paged in by first read of every triangle
+    const eng::mesh_view<T> tris = meshes.get(handle);
+    volatile float          sum  = 0.f;
+    for (const T& t : tris)
+    {
+        sum = sum + t.v[0].p.x;
+    }
+    const auto   touched   = clock::now();
+    const double rss_touch = peak_rss_mb();
+
+    std::cout << std::fixed << std::setprecision(1) << path << ": "
+              << tris.size() << " triangles, load " << ms(loaded - start).count()
+              << " ms (+" << rss_load - rss_start << " MB peak), first read "
+              << ms(touched - loaded).count() << " ms (+"
+              << rss_touch - rss_start << " MB peak)\n";
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <tri0|tri1|tri2> <file>\n";
+        return EXIT_FAILURE;
+    }
+    const std::string_view format(argv[1]);
+    if (format == "tri0")
+    {
+        return measure<eng::tri0>(argv[2]);
+    }
+    if (format == "tri1")
+    {
+        return measure<eng::tri1>(argv[2]);
+    }
+    if (format == "tri2")
+    {
+        return measure<eng::tri2>(argv[2]);
+    }
+    std::cerr << "unknown format: " << format << '\n';
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,335 @@
+#include "mesh_cache.hxx"
+
+#include <cassert>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+
+#ifdef __linux__
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace eng
+{
+
+    namespace fs = std::filesystem;
+
+    template <typename T>
+    struct mesh_entry
+    {
+        fs::path           path;
+        fs::file_time_type write_time{};
+        std::vector<T>     parsed;
+        mesh_file<T>       mapped;
+        mesh_view<T>       triangles;
+        /// tri2 only, built by mesh_cache::get_indexed for indexed_version
+        mesh               indexed;
+        std::uint32_t      version         = 0;
+        std::uint32_t      indexed_version = 0;
+        bool               indexed_built   = false;
+        bool               dirty   = false;
+        /// files with less triangles are rejected
+        std::size_t min_triangles = 0;
+    };
+
+    /// map binary file or parse text file
+    /// return false and keep entry untouched if file can't be read or has
+    /// less than entry.min_triangles
+    template <typename T>
+    static bool read_triangles(mesh_entry<T>& entry)
+    {
+        const std::string path = entry.path.string();
+        if (is_mesh_file(path))
+        {
+            mesh_file<T> mapped;
+            try
+            {
+                mapped = mesh_file<T>(path);
+            }
+            catch (const std::runtime_error&)
+            {
+                return false;
+            }
+            if (mapped.get_triangles().size() < entry.min_triangles)
+            {
+                return false;
+            }
+            entry.mapped = std::move(mapped);
+            entry.parsed.clear();
+            entry.parsed.shrink_to_fit();
+            entry.triangles = entry.mapped.get_triangles();
+            return true;
+        }
+
+        std::ifstream file(entry.path);
+        if (!file)
+        {
+            return false;
+        }
+        std::vector<T> result;
+        T              t;
+        while (file >> t)
+        {
+            result.push_back(t);
+        }
+        if (result.size() < entry.min_triangles)
+        {
+            return false;
+        }
+        entry.parsed.swap(result);
+        entry.mapped    = mesh_file<T>();
+        entry.triangles = mesh_view<T>{ entry.parsed.data(), entry.parsed.size() };
+        return true;
+    }
+
+    struct mesh_cache::impl
+    {
+        std::tuple<std::vector<mesh_entry<tri0>>, std::vector<mesh_entry<tri1>>,
+                   std::vector<mesh_entry<tri2>>>
+                entries;
+
+        template <typename T>
+        std::vector<mesh_entry<T>>& of()
+        {
+            return std::get<std::vector<mesh_entry<T>>>(entries);
+        }
+
+        template <typename F>
+        void for_each_entry(F&& f)
+        {
+            std::apply(
+                    [&](auto&... lists) {
+                        (..., [&](auto& list) {
+                            for (auto& entry : list)
+                            {
+                                f(entry);
+                            }
+                        }(lists));
+                    },
+                    entries);
+        }
+
+#ifdef __linux__
+        /// inotify watches directories, editors often replace files by rename
+        int                                    notify_fd = -1;
+        std::vector<std::pair<int, fs::path>> watched_dirs;
+
+        impl()
+        {
+            notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        }
+        ~impl()
+        {
+            if (notify_fd != -1)
+            {
+                close(notify_fd);
+            }
+        }
+
+        void watch(const fs::path& file)
+        {
+            if (notify_fd == -1)
+            {
+                return;
+            }
+            const fs::path dir = file.parent_path();
+            for (const auto& watched : watched_dirs)
+            {
+                if (watched.second == dir)
+                {
+                    return;
+                }
+            }
+            const int wd =
+                    inotify_add_watch(notify_fd, dir.c_str(),
+                                      IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            if (wd != -1)
+            {
+                watched_dirs.emplace_back(wd, dir);
+            }
+        }
+
+        /// drain pending notifications, mark changed files dirty
+        void collect_changes()
+        {
+            if (notify_fd == -1)
+            {
+                poll_write_times();
+                return;
+            }
+            alignas(inotify_event) char buffer[4096];
+            for (;;)
+            {
+                const ssize_t length = read(notify_fd, buffer, sizeof(buffer));
+                if (length <= 0)
+                {
+                    break;
+                }
+                for (char* ptr = buffer; ptr < buffer + length;)
+                {
+                    const auto* e = reinterpret_cast<const inotify_event*>(ptr);
+                    ptr += sizeof(inotify_event) + e->len;
+                    if (e->len == 0)
+                    {
+                        continue;
+                    }
+                    fs::path dir;
+                    for (const auto& watched : watched_dirs)
+                    {
+                        if (watched.first == e->wd)
+                        {
+                            dir = watched.second;
+                        }
+                    }
+                    const fs::path changed = dir / e->name;
+                    for_each_entry([&](auto& entry) {
+                        if (entry.path == changed)
+                        {
+                            entry.dirty = true;
+                        }
+                    });
+                }
+            }
+        }
+#else
+        void watch(const fs::path&) {}
+
+        void collect_changes() { poll_write_times(); }
+#endif
+        /// fallback without change notifications: compare mtime
+        /// not more often than 4 times per second
+        std::chrono::steady_clock::time_point last_poll{};
+
+        void poll_write_times()
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - last_poll < std::chrono::milliseconds(250))
+            {
+                return;
+            }
+            last_poll = now;
+            for_each_entry([](auto& entry) {
+                std::error_code ec;
+                const auto      write_time = fs::last_write_time(entry.path, ec);
+                if (!ec && write_time != entry.write_time)
+                {
+                    entry.dirty = true;
+                }
+            });
+        }
+    };
+
+    mesh_cache::mesh_cache()
+        : pimpl(new impl())
+    {
+    }
+
+    mesh_cache::~mesh_cache() = default;
+
+    template <typename T>
+    mesh_handle<T> mesh_cache::load(std::string_view path, std::size_t min_triangles)
+    {
+        std::error_code ec;
+        fs::path        full_path = fs::absolute(fs::path(path), ec).lexically_normal();
+        if (ec)
+        {
+            throw std::runtime_error("can't resolve mesh path: " + std::string(path));
+        }
+
+        auto& list = pimpl->of<T>();
+        for (std::size_t i = 0; i < list.size(); ++i)
+        {
+            if (list[i].path == full_path)
+            {
+                return mesh_handle<T>{ static_cast<std::uint32_t>(i) };
+            }
+        }
+
+        mesh_entry<T> entry;
+        entry.path          = full_path;
+        entry.min_triangles = min_triangles;
+        entry.write_time = fs::last_write_time(full_path, ec);
+        if (ec || !read_triangles(entry))
+        {
+            throw std::runtime_error("can't load mesh: " + std::string(path));
+        }
+        pimpl->watch(full_path);
+        list.push_back(std::move(entry));
+        return mesh_handle<T>{ static_cast<std::uint32_t>(list.size() - 1) };
+    }
+
+    template <typename T>
+    mesh_view<T> mesh_cache::get(mesh_handle<T> h) const
+    {
+        const auto& list = pimpl->of<T>();
+        assert(h.index < list.size());
+        return list[h.index].triangles;
+    }
+
+    const mesh& mesh_cache::get_indexed(mesh_handle<tri2> h) const
+    {
+        auto& list = pimpl->of<tri2>();
+        assert(h.index < list.size());
+        mesh_entry<tri2>& entry = list[h.index];
+        // built on demand: loading big mapped file must not touch all of it
+        if (!entry.indexed_built || entry.indexed_version != entry.version)
+        {
+            if (!make_mesh(entry.triangles.first, entry.triangles.size(),
+                           entry.indexed))
+            {
+                entry.indexed = mesh();
+            }
+            entry.indexed_version = entry.version;
+            entry.indexed_built   = true;
+        }
+        return entry.indexed;
+    }
+
+    template <typename T>
+    std::uint32_t mesh_cache::get_version(mesh_handle<T> h) const
+    {
+        const auto& list = pimpl->of<T>();
+        assert(h.index < list.size());
+        return list[h.index].version;
+    }
+
+    std::size_t mesh_cache::poll_changes()
+    {
+        pimpl->collect_changes();
+
+        std::size_t reloaded = 0;
+        pimpl->for_each_entry([&](auto& entry) {
+            if (!entry.dirty)
+            {
+                return;
+            }
+            entry.dirty = false;
+            std::error_code ec;
+            entry.write_time = fs::last_write_time(entry.path, ec);
+            // keep previous geometry if file is gone for a moment
+            if (read_triangles(entry))
+            {
+                ++entry.version;
+                ++reloaded;
+            }
+        });
+        return reloaded;
+    }
+
+    template mesh_handle<tri0> mesh_cache::load<tri0>(std::string_view, std::size_t);
+    template mesh_handle<tri1> mesh_cache::load<tri1>(std::string_view, std::size_t);
+    template mesh_handle<tri2> mesh_cache::load<tri2>(std::string_view, std::size_t);
+    template mesh_view<tri0> mesh_cache::get(mesh_handle<tri0>) const;
+    template mesh_view<tri1> mesh_cache::get(mesh_handle<tri1>) const;
+    template mesh_view<tri2> mesh_cache::get(mesh_handle<tri2>) const;
+    template std::uint32_t mesh_cache::get_version(mesh_handle<tri0>) const;
+    template std::uint32_t mesh_cache::get_version(mesh_handle<tri1>) const;
+    template std::uint32_t mesh_cache::get_version(mesh_handle<tri2>) const;
+
+} // end namespace eng
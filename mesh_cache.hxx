@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "engine.hxx"
+#include "mesh_file.hxx"
+
+namespace eng
+{
+
+/// stable reference to geometry inside mesh_cache
+    template <typename T>
+    struct mesh_handle
+    {
+        std::uint32_t index = 0;
+    };
+
+/// keep geometry files resident in memory
+/// every file parsed once, parsed again only after it changed on disk
+/// binary mesh files (see mesh_file.hxx) are mapped instead of parsed
+/// T is one of tri0, tri1, tri2
+    class eng_DECLSPEC mesh_cache
+    {
+    public:
+        mesh_cache();
+        ~mesh_cache();
+        mesh_cache(const mesh_cache&) = delete;
+        mesh_cache& operator=(const mesh_cache&) = delete;
+
+        /// load file first time, same path returns same handle
+        /// throw std::runtime_error if file can't be read or has less than
+        /// min_triangles; reload with less keeps previous triangles, so
+        /// caller may index first min_triangles without checks
+        template <typename T>
+        mesh_handle<T> load(std::string_view path, std::size_t min_triangles = 0);
+
+        /// triangles of mesh, view valid until next poll_changes
+        template <typename T>
+        mesh_view<T> get(mesh_handle<T> h) const;
+
+        /// same triangles with shared vertexes merged, built on first call
+        /// after load or reload; empty when they need more than 16 bit
+        /// indexes. Reference valid until next poll_changes
+        const mesh& get_indexed(mesh_handle<tri2> h) const;
+
+        /// increment on every reload of this mesh
+        template <typename T>
+        std::uint32_t get_version(mesh_handle<T> h) const;
+
+        /// call once per frame, never touch file data if nothing changed
+        /// return count of reloaded meshes
+        std::size_t poll_changes();
+
+    private:
+        struct impl;
+        std::unique_ptr<impl> pimpl;
+    };
+
+} // end namespace eng
@@ -0,0 +1,65 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "engine.hxx"
+#include "mesh_file.hxx"
+
+/// convert text geometry (vert_*.txt) into binary mesh file
+/// usage: mesh_convert <tri0|tri1|tri2> <input.txt> <output>
+
+template <typename T>
+static int convert(const char* input, const char* output)
+{
+    std::ifstream file(input);
+    if (!file)
+    {
+        std::cerr << "can't open " << input << '\n';
+        return EXIT_FAILURE;
+    }
+    std::vector<T> tris;
+    T              t;
+    while (file >> t)
+    {
+        tris.push_back(t);
+    }
+    eng::write_mesh_file(output, eng::mesh_view<T>{ tris.data(), tris.size() });
+    std::cout << input << " -> " << output << ": " << tris.size()
+              << " triangles\n";
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4)
+    {
+        std::cerr << "usage: " << argv[0] << " <tri0|tri1|tri2> <input> <output>\n";
+        return EXIT_FAILURE;
+    }
+    const std::string_view format(argv[1]);
+    try
+    {
+        if (format == "tri0")
+        {
+            return convert<eng::tri0>(argv[2], argv[3]);
+        }
+        if (format == "tri1")
+        {
+            return convert<eng::tri1>(argv[2], argv[3]);
+        }
+        if (format == "tri2")
+        {
+            return convert<eng::tri2>(argv[2], argv[3]);
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    std::cerr << "unknown format: " << format << '\n';
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,206 @@
+#include "mesh_file.hxx"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace eng
+{
+
+    /// map whole file read-only, return nullptr on failure
+    static void* map_file(const std::string& path, std::size_t& size)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                  nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+        LARGE_INTEGER file_size{};
+        GetFileSizeEx(file, &file_size);
+        size           = static_cast<std::size_t>(file_size.QuadPart);
+        HANDLE mapping = size == 0 ? nullptr
+                                   : CreateFileMappingA(file, nullptr, PAGE_READONLY,
+                                                        0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr)
+        {
+            return nullptr;
+        }
+        void* result = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        return result;
+#else
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return nullptr;
+        }
+        struct stat st
+        {
+        };
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+        size         = static_cast<std::size_t>(st.st_size);
+        void* result = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // mapping keeps its own reference to file
+        close(fd);
+        return result == MAP_FAILED ? nullptr : result;
+#endif
+    }
+
+    static void unmap_file(void* ptr, std::size_t size)
+    {
+#ifdef _WIN32
+        (void)size;
+        UnmapViewOfFile(ptr);
+#else
+        munmap(ptr, size);
+#endif
+    }
+
+    template <typename T>
+    mesh_file<T>::mesh_file(std::string_view path)
+    {
+        const std::string file_path(path);
+        mapping = map_file(file_path, mapping_size);
+        if (mapping == nullptr)
+        {
+            throw std::runtime_error("can't map mesh file: " + file_path);
+        }
+
+        mesh_file_header header;
+        if (mapping_size < sizeof(header))
+        {
+            unmap();
+            throw std::runtime_error("mesh file too small: " + file_path);
+        }
+        std::memcpy(&header, mapping, sizeof(header));
+
+        const mesh_file_header expected;
+        if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+            header.version != expected.version ||
+            header.vertex_format != mesh_format<T>::id ||
+            header.vertex_size * 3 != sizeof(T) ||
+            header.data_offset % alignof(T) != 0 ||
+            header.data_offset > mapping_size ||
+            // divide, product of crafted count may wrap around
+            header.triangle_count > (mapping_size - header.data_offset) / sizeof(T))
+        {
+            unmap();
+            throw std::runtime_error("bad mesh file header: " + file_path);
+        }
+
+        const auto* bytes = static_cast<const unsigned char*>(mapping);
+        triangles.first =
+                reinterpret_cast<const T*>(bytes + header.data_offset);
+        triangles.count = static_cast<std::size_t>(header.triangle_count);
+    }
+
+    template <typename T>
+    mesh_file<T>::~mesh_file()
+    {
+        unmap();
+    }
+
+    template <typename T>
+    mesh_file<T>::mesh_file(mesh_file&& other) noexcept
+        : mapping(std::exchange(other.mapping, nullptr))
+        , mapping_size(std::exchange(other.mapping_size, 0))
+        , triangles(std::exchange(other.triangles, mesh_view<T>()))
+    {
+    }
+
+    template <typename T>
+    mesh_file<T>& mesh_file<T>::operator=(mesh_file&& other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            mapping      = std::exchange(other.mapping, nullptr);
+            mapping_size = std::exchange(other.mapping_size, 0);
+            triangles    = std::exchange(other.triangles, mesh_view<T>());
+        }
+        return *this;
+    }
+
+    template <typename T>
+    void mesh_file<T>::unmap()
+    {
+        if (mapping != nullptr)
+        {
+            unmap_file(mapping, mapping_size);
+        }
+        mapping      = nullptr;
+        mapping_size = 0;
+        triangles    = mesh_view<T>();
+    }
+
+    bool is_mesh_file(std::string_view path)
+    {
+        std::ifstream file(std::string(path), std::ios_base::binary);
+        char          magic[4] = {};
+        file.read(magic, sizeof(magic));
+        const mesh_file_header expected;
+        return file.good() &&
+               std::memcmp(magic, expected.magic, sizeof(magic)) == 0;
+    }
+
+    template <typename T>
+    void write_mesh_file(std::string_view path, mesh_view<T> tris)
+    {
+        mesh_file_header header;
+        header.vertex_format  = mesh_format<T>::id;
+        header.vertex_size    = sizeof(T) / 3;
+        header.triangle_count = tris.size();
+        header.data_offset    = sizeof(header);
+
+        // write aside and rename: readers that still map old file
+        // keep old pages instead of crashing on truncated mapping
+        const std::string file_path(path);
+        const std::string tmp_path = file_path + ".tmp";
+        {
+            std::ofstream file(tmp_path,
+                               std::ios_base::binary | std::ios_base::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(tris.begin()),
+                       static_cast<std::streamsize>(tris.size() * sizeof(T)));
+            if (!file)
+            {
+                throw std::runtime_error("can't write mesh file: " + file_path);
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, file_path, ec);
+        if (ec)
+        {
+            throw std::runtime_error("can't write mesh file: " + file_path);
+        }
+    }
+
+    template class mesh_file<tri0>;
+    template class mesh_file<tri1>;
+    template class mesh_file<tri2>;
+    template void write_mesh_file(std::string_view, mesh_view<tri0>);
+    template void write_mesh_file(std::string_view, mesh_view<tri1>);
+    template void write_mesh_file(std::string_view, mesh_view<tri2>);
+
+} // end namespace eng
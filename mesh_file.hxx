@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// binary geometry file:
+/// mesh_file_header followed by triangle_count triangles stored exactly
+/// as tri0/tri1/tri2 lay out in memory (native byte order)
+    struct mesh_file_header
+    {
+        char          magic[4]       = { 'E', 'N', 'G', 'M' };
+        std::uint32_t version        = 1;
+        std::uint32_t vertex_format  = 0; ///< 0 - v0, 1 - v1, 2 - v2
+        std::uint32_t vertex_size    = 0; ///< sizeof(v0/v1/v2) when written
+        std::uint64_t triangle_count = 0;
+        std::uint64_t data_offset    = 0; ///< from file begin
+    };
+
+    static_assert(sizeof(mesh_file_header) == 32, "header layout changed");
+
+    template <typename T>
+    struct mesh_format;
+    template <>
+    struct mesh_format<tri0>
+    {
+        static constexpr std::uint32_t id = 0;
+    };
+    template <>
+    struct mesh_format<tri1>
+    {
+        static constexpr std::uint32_t id = 1;
+    };
+    template <>
+    struct mesh_format<tri2>
+    {
+        static constexpr std::uint32_t id = 2;
+    };
+
+    static_assert(std::is_trivially_copyable_v<tri0> &&
+                          std::is_trivially_copyable_v<tri1> &&
+                          std::is_trivially_copyable_v<tri2>,
+                  "triangles are stored in files as raw bytes");
+
+/// read-only contiguous triangles, does not own memory
+    template <typename T>
+    struct mesh_view
+    {
+        const T*    first = nullptr;
+        std::size_t count = 0;
+
+        const T*    begin() const { return first; }
+        const T*    end() const { return first + count; }
+        std::size_t size() const { return count; }
+        bool        empty() const { return count == 0; }
+        const T&    operator[](std::size_t i) const { return first[i]; }
+    };
+
+/// binary geometry file mapped into memory, triangles are never copied
+    template <typename T>
+    class eng_DECLSPEC mesh_file
+    {
+    public:
+        mesh_file() = default;
+        /// throw std::runtime_error on missing file or wrong header
+        explicit mesh_file(std::string_view path);
+        ~mesh_file();
+        mesh_file(mesh_file&& other) noexcept;
+        mesh_file& operator=(mesh_file&& other) noexcept;
+        mesh_file(const mesh_file&) = delete;
+        mesh_file& operator=(const mesh_file&) = delete;
+
+        mesh_view<T> get_triangles() const { return triangles; }
+
+    private:
+        void unmap();
+
+        void*        mapping      = nullptr;
+        std::size_t  mapping_size = 0;
+        mesh_view<T> triangles;
+    };
+
+/// return true if file starts with binary mesh magic
+    bool eng_DECLSPEC is_mesh_file(std::string_view path);
+
+/// write triangles in binary format
+/// throw std::runtime_error if file can't be written
+    template <typename T>
+    void eng_DECLSPEC write_mesh_file(std::string_view path, mesh_view<T> tris);
+
+} // end namespace eng
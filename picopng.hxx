@@ -1,5 +1,12 @@
+#include <cstring>
 #include <vector>
 
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PICOPNG_SSE2 1
+#endif
+
 /*
 decodePNG: The picoPNG function, decodes a PNG file buffer in memory, into a raw
 pixel buffer.
@@ -53,6 +60,13 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
     //     3. This notice may not be removed or altered from any source
     //     distribution.
 
+    // Altered for this project: inflate decodes Huffman codes through a lookup
+    // table and reads the stream a 64-bit word at a time, scanline unfiltering
+    // uses SSE2 for 3 and 4 byte pixels. Output is the same as the original
+    // version, except for two fixed out of bounds reads: bpp < 8 images took
+    // the previous line from the output buffer, Adam7 passes unfiltered the
+    // full image width.
+
     // picoPNG is a PNG decoder in one C++ function of around 500 lines. Use
     // picoPNG for
     // programs that need only 1 .cpp file. Since it's a single function, it's
@@ -86,24 +100,15 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
     };          // code length code lengths
     struct Zlib // nested functions for zlib decompression
     {
-        static unsigned long readBitFromStream(size_t&              bitp,
-                                               const unsigned char* bits)
-        {
-            unsigned long result = (bits[bitp >> 3] >> (bitp & 0x7)) & 1;
-            bitp++;
-            return result;
-        }
-        static unsigned long readBitsFromStream(size_t&              bitp,
-                                                const unsigned char* bits,
-                                                size_t               nbits)
-        {
-            unsigned long result = 0;
-            for (size_t i = 0; i < nbits; i++)
-                result += (readBitFromStream(bitp, bits)) << i;
-            return result;
-        }
         struct HuffmanTree
         {
+            // codes of at most FASTBITS bits are decoded with one lookup in
+            // "fast", longer ones fall back to walking tree2d bit by bit
+            enum
+            {
+                FASTBITS = 9,
+                LONGCODE = 0x8000
+            };
             int makeFromLengths(const std::vector<unsigned long>& bitlen,
                                 unsigned long                     maxbitlen)
             { // make tree given the lengths
@@ -153,8 +158,37 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                                       numcodes; // subtract numcodes from
                         // address to get address value
                     }
+                makeFastTable();
                 return 0;
             }
+            void makeFastTable()
+            { // index is the next FASTBITS bits of the stream (first bit in
+                // the lowest position), entry is symbol << 4 | code length,
+                // LONGCODE | tree position after FASTBITS bits for longer codes,
+                // or 0 for invalid codes. Built by walking tree2d so it decodes
+                // exactly like decode() does
+                unsigned long numcodes = (unsigned long)tree2d.size() / 2;
+                fast.assign(1u << FASTBITS, 0);
+                for (unsigned long i = 0; i < fast.size(); i++)
+                {
+                    size_t treepos = 0;
+                    for (unsigned long len = 1; len <= FASTBITS; len++)
+                    {
+                        unsigned long result =
+                                tree2d[2 * treepos + ((i >> (len - 1)) & 1)];
+                        if (result < numcodes)
+                        {
+                            fast[i] = (unsigned short)(result << 4 | len);
+                            break;
+                        }
+                        treepos = result - numcodes;
+                        if (treepos >= numcodes)
+                            break; // leave the error to decode()
+                        if (len == FASTBITS)
+                            fast[i] = (unsigned short)(LONGCODE | treepos);
+                    }
+                }
+            }
             int decode(bool& decoded, unsigned long& result, size_t& treepos,
                        unsigned long bit) const
             { // Decodes a symbol from the tree
@@ -170,15 +204,55 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
             // tree: The one dimension is "0"
             // or "1", the other contains all
             // nodes and leaves of the tree.
+            std::vector<unsigned short> fast; // lookup table for short codes
         };
         struct Inflator
         {
-            int  error;
+            int    error;
+            size_t inavail; // bytes that may really be read from the stream
+            unsigned long long peekBits(size_t               bitp,
+                                        const unsigned char* bits) const
+            { // next 57 bits or more, first bit in the lowest position. One
+                // 8 byte load in the middle of the stream, past its end the
+                // bits read as 0
+                size_t             p    = bitp >> 3;
+                unsigned long long word = 0;
+                if (p + 8 <= inavail)
+                    word = (unsigned long long)bits[p] |
+                           (unsigned long long)bits[p + 1] << 8 |
+                           (unsigned long long)bits[p + 2] << 16 |
+                           (unsigned long long)bits[p + 3] << 24 |
+                           (unsigned long long)bits[p + 4] << 32 |
+                           (unsigned long long)bits[p + 5] << 40 |
+                           (unsigned long long)bits[p + 6] << 48 |
+                           (unsigned long long)bits[p + 7] << 56;
+                else
+                    for (size_t i = 0; i < 8 && p + i < inavail; i++)
+                        word |= (unsigned long long)bits[p + i] << (8 * i);
+                return word >> (bitp & 0x7);
+            }
+            unsigned long readBitFromStream(size_t&              bitp,
+                                            const unsigned char* bits) const
+            {
+                unsigned long result = (unsigned long)(peekBits(bitp, bits) & 1);
+                bitp++;
+                return result;
+            }
+            unsigned long readBitsFromStream(size_t&              bitp,
+                                             const unsigned char* bits,
+                                             size_t               nbits) const
+            { // nbits is at most 16 in deflate
+                unsigned long result = (unsigned long)(
+                        peekBits(bitp, bits) & ((1ull << nbits) - 1));
+                bitp += nbits;
+                return result;
+            }
             void inflate(std::vector<unsigned char>&       out,
                          const std::vector<unsigned char>& in, size_t inpos = 0)
             {
                 size_t bp = 0, pos = 0; // bit pointer and byte pointer
                 error                = 0;
+                inavail              = in.size() - inpos;
                 unsigned long BFINAL = 0;
                 while (!BFINAL && !error)
                 {
@@ -229,9 +303,26 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                                               size_t               inlength)
             { // decode a single symbol from given list of bits with given code
                 // tree. return value is the symbol
+                size_t treepos = 0;
+                if ((bp >> 3) + 1 < inavail) // all FASTBITS bits are in the stream
+                {
+                    unsigned long entry =
+                            codetree.fast[(unsigned long)peekBits(bp, in) &
+                                          ((1u << HuffmanTree::FASTBITS) - 1)];
+                    if (entry & HuffmanTree::LONGCODE)
+                    { // continue bit by bit from where the table stopped
+                        bp += HuffmanTree::FASTBITS;
+                        treepos = entry & ~HuffmanTree::LONGCODE;
+                    }
+                    else if (entry)
+                    {
+                        bp += entry & 15;
+                        return entry >> 4;
+                    }
+                }
                 bool          decoded;
                 unsigned long ct;
-                for (size_t treepos = 0;;)
+                for (;;)
                 {
                     if ((bp & 0x07) == 0 && (bp >> 3) > inlength)
                     {
@@ -380,6 +471,54 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                 if (error)
                     return;
             }
+            bool decodeFast(std::vector<unsigned char>& out,
+                            const unsigned char* in, size_t& bp, size_t& pos)
+            { // one literal or length/distance pair from a single peekBits:
+                // at most 15 + 5 + 15 + 13 bits. Returns false without
+                // consuming anything when a code is not in the fast tables,
+                // is invalid or may run past the stream or the out buffer,
+                // then inflateHuffmanBlock takes the careful path
+                if ((bp >> 3) + 8 > inavail || pos + 258 >= out.size())
+                    return false;
+                const unsigned long mask  = (1u << HuffmanTree::FASTBITS) - 1;
+                unsigned long long  word  = peekBits(bp, in);
+                unsigned long       entry = codetree.fast[word & mask];
+                if (entry == 0 || (entry & HuffmanTree::LONGCODE))
+                    return false;
+                unsigned long code = entry >> 4, used = entry & 15;
+                if (code <= 255) // literal symbol
+                {
+                    out[pos++] = (unsigned char)(code);
+                    bp += used;
+                    return true;
+                }
+                if (code < 257 || code > 285)
+                    return false; // end code and invalid codes
+                size_t length = LENBASE[code - 257];
+                length += (word >> used) & ((1u << LENEXTRA[code - 257]) - 1);
+                used += LENEXTRA[code - 257];
+                entry = codetreeD.fast[(word >> used) & mask];
+                if (entry == 0 || (entry & HuffmanTree::LONGCODE) ||
+                    (entry >> 4) > 29)
+                    return false;
+                unsigned long codeD = entry >> 4;
+                used += entry & 15;
+                size_t dist = DISTBASE[codeD];
+                dist += (word >> used) & ((1u << DISTEXTRA[codeD]) - 1);
+                used += DISTEXTRA[codeD];
+                if (dist > pos)
+                    return false;
+                bp += used;
+                unsigned char*       dst = &out[pos];
+                const unsigned char* src = dst - dist;
+                if (dist >= length) // no overlap, copy at once
+                    std::memcpy(dst, src, length);
+                else // overlap repeats the last dist bytes
+                    for (size_t i = 0; i < length; i++)
+                        dst[i] = src[i];
+                pos += length;
+                return true;
+            }
             void inflateHuffmanBlock(std::vector<unsigned char>& out,
                                      const unsigned char* in, size_t& bp,
                                      size_t& pos, size_t inlength,
@@ -398,6 +537,8 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                 }
                 for (;;)
                 {
+                    if (decodeFast(out, in, bp, pos))
+                        continue;
                     unsigned long code =
                             huffmanDecodeSymbol(in, bp, codetree, inlength);
                     if (error)
@@ -437,15 +578,21 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                             return;
                         } // error, bit pointer will jump past memory
                         dist += readBitsFromStream(bp, in, numextrabitsD);
-                        size_t start = pos, back = start - dist; // backwards
-                        if (pos + length >= out.size())
-                            out.resize((pos + length) * 2); // reserve more room
-                        for (size_t i = 0; i < length; i++)
+                        if (dist > pos)
                         {
-                            out[pos++] = out[back++];
-                            if (back >= start)
-                                back = start - dist;
-                        }
+                            error = 54;
+                            return;
+                        } // error: distance points before the start of output
+                        if (pos + length > out.size())
+                            out.resize((pos + length) * 2); // reserve more room
+                        unsigned char*       dst = &out[pos];
+                        const unsigned char* src = dst - dist;
+                        if (dist >= length) // no overlap, copy at once
+                            std::memcpy(dst, src, length);
+                        else // overlap repeats the last dist bytes
+                            for (size_t i = 0; i < length; i++)
+                                dst[i] = src[i];
+                        pos += length;
                     }
                 }
             }
@@ -476,8 +623,10 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                     error = 23;
                     return;
                 } // error: reading outside of in buffer
-                for (unsigned long n = 0; n < LEN; n++)
-                    out[pos++] = in[p++]; // read LEN bytes of literal data
+                if (LEN) // read LEN bytes of literal data
+                    std::memcpy(&out[pos], &in[p], LEN);
+                pos += LEN;
+                p += LEN;
                 bp = p * 8;
             }
         };
@@ -701,13 +850,14 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                 else // less than 8 bits per pixel, so fill it up bit per bit
                 {
                     std::vector<unsigned char> templine(
-                            (info.width * bpp + 7) >> 3); // only used if bpp < 8
+                            (info.width * bpp + 7) >> 3), // only used if bpp < 8
+                            prevtempline(templine.size());
                     for (size_t y = 0, obp = 0; y < info.height; y++)
                     {
                         unsigned long        filterType = scanlines[linestart];
                         const unsigned char* prevline =
-                                (y == 0) ? 0
-                                         : &out_[(y - 1) * info.width * bytewidth];
+                                (y == 0) ? 0 : &prevtempline[0]; // the packed
+                        // previous line, out_ is a continuous bit stream
                         unFilterScanline(&templine[0],
                                          &scanlines[linestart + 1], prevline,
                                          bytewidth, filterType, linelength);
@@ -717,6 +867,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                             setBitOfReversedStream(
                                     obp, out_,
                                     readBitFromReversedStream(bp, &templine[0]));
+                        templine.swap(prevtempline);
                         linestart +=
                                 (1 + linelength); // go to start of next scanline
                     }
@@ -819,12 +970,26 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                         recon[i]  = scanline[i];
                     break;
                 case 1:
+#ifdef PICOPNG_SSE2
+                    if (bytewidth == 3 || bytewidth == 4)
+                    {
+                        unFilterSubSse2(recon, scanline, bytewidth, length);
+                        break;
+                    }
+#endif
                     for (size_t i = 0; i < bytewidth; i++)
                         recon[i]  = scanline[i];
                     for (size_t i = bytewidth; i < length; i++)
                         recon[i]  = scanline[i] + recon[i - bytewidth];
                     break;
                 case 2:
+#ifdef PICOPNG_SSE2
+                    if (precon)
+                    {
+                        unFilterUpSse2(recon, scanline, precon, length);
+                        break;
+                    }
+#endif
                     if (precon)
                         for (size_t i = 0; i < length; i++)
                             recon[i]  = scanline[i] + precon[i];
@@ -833,6 +998,14 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                             recon[i]  = scanline[i];
                     break;
                 case 3:
+#ifdef PICOPNG_SSE2
+                    if (precon && (bytewidth == 3 || bytewidth == 4))
+                    {
+                        unFilterAverageSse2(recon, scanline, precon, bytewidth,
+                                            length);
+                        break;
+                    }
+#endif
                     if (precon)
                     {
                         for (size_t i = 0; i < bytewidth; i++)
@@ -850,6 +1023,14 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                     }
                     break;
                 case 4:
+#ifdef PICOPNG_SSE2
+                    if (precon && (bytewidth == 3 || bytewidth == 4))
+                    {
+                        unFilterPaethSse2(recon, scanline, precon, bytewidth,
+                                          length);
+                        break;
+                    }
+#endif
                     if (precon)
                     {
                         for (size_t i = 0; i < bytewidth; i++)
@@ -876,6 +1057,129 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                     return; // error: unexisting filter type given
             }
         }
+#ifdef PICOPNG_SSE2
+        // Sub, Average and Paeth depend on the pixel to the left, so they
+        // work one 3 or 4 byte pixel per step (16 bit lanes for Paeth); Up
+        // has no such dependency and takes 16 bytes per step. Pixels are
+        // moved as 4 bytes while 4 bytes are left in the line: for 3 byte
+        // pixels the extra byte is garbage that the next step overwrites.
+        // The rest of the line is done with the scalar formula
+        static __m128i loadPixel(const unsigned char* p)
+        {
+            int v;
+            std::memcpy(&v, p, 4);
+            return _mm_cvtsi32_si128(v);
+        }
+        static void storePixel(unsigned char* p, __m128i v)
+        {
+            int x = _mm_cvtsi128_si32(v);
+            std::memcpy(p, &x, 4);
+        }
+        static void unFilterSubSse2(unsigned char*       recon,
+                                    const unsigned char* scanline,
+                                    size_t bytewidth, size_t length)
+        {
+            __m128i a = _mm_setzero_si128();
+            size_t  i = 0;
+            if (bytewidth == 4) // prefix sum of 4 pixels in one register
+                for (; i + 16 <= length; i += 16)
+                {
+                    __m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+                    x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+                    x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+                    x = _mm_add_epi8(x, a);
+                    _mm_storeu_si128((__m128i*)(recon + i), x);
+                    a = _mm_shuffle_epi32(x, 0xFF); // last pixel to all lanes
+                }
+            for (; i + 4 <= length; i += bytewidth)
+            {
+                a = _mm_add_epi8(loadPixel(scanline + i), a);
+                storePixel(recon + i, a);
+            }
+            for (; i < length; i++)
+                recon[i] = scanline[i] + (i >= bytewidth ? recon[i - bytewidth] : 0);
+        }
+        static void unFilterUpSse2(unsigned char*       recon,
+                                   const unsigned char* scanline,
+                                   const unsigned char* precon, size_t length)
+        {
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16)
+                _mm_storeu_si128(
+                        (__m128i*)(recon + i),
+                        _mm_add_epi8(
+                                _mm_loadu_si128((const __m128i*)(scanline + i)),
+                                _mm_loadu_si128((const __m128i*)(precon + i))));
+            for (; i < length; i++)
+                recon[i] = scanline[i] + precon[i];
+        }
+        static void unFilterAverageSse2(unsigned char*       recon,
+                                        const unsigned char* scanline,
+                                        const unsigned char* precon,
+                                        size_t bytewidth, size_t length)
+        {
+            const __m128i one = _mm_set1_epi8(1);
+            __m128i       a   = _mm_setzero_si128();
+            size_t        i   = 0;
+            for (; i + 4 <= length; i += bytewidth)
+            {
+                __m128i b = loadPixel(precon + i);
+                // _mm_avg_epu8 rounds up, the filter rounds down
+                __m128i avg = _mm_sub_epi8(
+                        _mm_avg_epu8(a, b),
+                        _mm_and_si128(_mm_xor_si128(a, b), one));
+                a = _mm_add_epi8(loadPixel(scanline + i), avg);
+                storePixel(recon + i, a);
+            }
+            for (; i < length; i++)
+                recon[i] = scanline[i] +
+                           (((i >= bytewidth ? recon[i - bytewidth] : 0) +
+                             precon[i]) /
+                            2);
+        }
+        static void unFilterPaethSse2(unsigned char*       recon,
+                                      const unsigned char* scanline,
+                                      const unsigned char* precon,
+                                      size_t bytewidth, size_t length)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i       a = zero, c = zero; // left and upper left pixels
+            size_t        i = 0;
+            for (; i + 4 <= length; i += bytewidth)
+            {
+                __m128i b =
+                        _mm_unpacklo_epi8(loadPixel(precon + i), zero);
+                __m128i x = _mm_unpacklo_epi8(loadPixel(scanline + i),
+                                              zero);
+                // p = a + b - c, so p - a = b - c, p - b = a - c and
+                // p - c = (b - c) + (a - c)
+                __m128i pa = _mm_sub_epi16(b, c);
+                __m128i pb = _mm_sub_epi16(a, c);
+                __m128i pc = _mm_add_epi16(pa, pb);
+                pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+                pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+                pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+                __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                // ties prefer a, then b, then c
+                __m128i is_b    = _mm_cmpeq_epi16(smallest, pb);
+                __m128i nearest = _mm_or_si128(_mm_and_si128(is_b, b),
+                                               _mm_andnot_si128(is_b, c));
+                __m128i is_a = _mm_cmpeq_epi16(smallest, pa);
+                nearest      = _mm_or_si128(_mm_and_si128(is_a, a),
+                                            _mm_andnot_si128(is_a, nearest));
+                a = _mm_and_si128(_mm_add_epi16(x, nearest),
+                                  _mm_set1_epi16(0xFF));
+                storePixel(recon + i, _mm_packus_epi16(a, a));
+                c = b;
+            }
+            for (; i < length; i++)
+                recon[i] = scanline[i] +
+                           paethPredictor(
+                                   i >= bytewidth ? recon[i - bytewidth] : 0,
+                                   precon[i],
+                                   i >= bytewidth ? precon[i - bytewidth] : 0);
+        }
+#endif
         void adam7Pass(unsigned char* out, unsigned char* linen,
                        unsigned char* lineo, const unsigned char* in,
                        unsigned long w, size_t passleft, size_t passtop,
@@ -894,7 +1198,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                 unsigned char filterType = in[y * linelength],
                         *prevline  = (y == 0) ? 0 : lineo;
                 unFilterScanline(linen, &in[y * linelength + 1], prevline,
-                                 bytewidth, filterType, (w * bpp + 7) / 8);
+                                 bytewidth, filterType, linelength - 1);
                 if (error)
                     return;
                 if (bpp >= 8)
@@ -1103,7 +1407,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                 }
             return 0;
         }
-        unsigned char paethPredictor(
+        static unsigned char paethPredictor(
                 short a, short b,
                 short c) // Paeth predicter, used by PNG filter type 4
         {
@@ -1114,7 +1418,7 @@ int decodePNG(std::vector<unsigned char>& out_image, unsigned long& image_width,
                                                           : pb <= pc ? b : c);
         }
     };
-    PNG decoder;
+    PNG decoder{}; // error paths return before info is filled
     decoder.decode(out_image, in_png, in_size, convert_to_rgba32);
     image_width  = decoder.info.width;
     image_height = decoder.info.height;
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench.hxx"
+#include "picopng.hxx"
+
+/// decode speed of picopng over a set of png files
+/// usage: png_bench file.png [file.png ...]
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " file.png [file.png ...]\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << std::setw(32) << "file" << std::setw(12) << "size"
+              << std::setw(12) << "ms" << std::setw(12) << "MB/s" << '\n';
+
+    double total_ms    = 0;
+    double total_bytes = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::vector<unsigned char> file;
+        loadFile(file, argv[i]);
+
+        std::vector<unsigned char> pixels;
+        unsigned long              w = 0;
+        unsigned long              h = 0;
+        int                        error = 0;
+        const std::chrono::duration<double, std::milli> run = eng::time_per_run([&] {
+            error = decodePNG(pixels, w, h, file.data(), file.size(), false);
+        });
+        const double ms = run.count();
+        if (error != 0)
+        {
+            std::cerr << argv[i] << ": decode error " << error << '\n';
+            return EXIT_FAILURE;
+        }
+        total_ms += ms;
+        total_bytes += pixels.size();
+        std::cout << std::setw(32) << argv[i] << std::setw(12)
+                  << std::to_string(w) + "x" + std::to_string(h) << std::fixed
+                  << std::setprecision(3) << std::setw(12) << ms
+                  << std::setw(12) << pixels.size() / ms / 1000.0 << '\n';
+    }
+    std::cout << std::setw(32) << "total" << std::setw(12) << "" << std::setw(12)
+              << total_ms << std::setw(12) << total_bytes / total_ms / 1000.0
+              << '\n';
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+#include "profiler.hxx"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eng
+{
+
+    namespace
+    {
+        // fields are atomics so export may read ring of a running thread;
+        // relaxed stores compile to plain moves on x86 and arm
+        struct profile_event
+        {
+            std::atomic<const char*>   name{ nullptr };
+            std::atomic<std::uint64_t> begin{ 0 };
+            std::atomic<std::uint64_t> end{ 0 };
+        };
+
+        /// one writer thread, events overwrite oldest ones when full
+        struct profile_ring
+        {
+            static constexpr std::size_t capacity = 1 << 14;
+
+            explicit profile_ring(std::uint32_t id_)
+                : id(id_)
+            {
+            }
+
+            void push(const char* name, std::uint64_t begin, std::uint64_t end)
+            {
+                const std::uint64_t n = head.load(std::memory_order_relaxed);
+                profile_event&      e = events[n % capacity];
+                e.name.store(name, std::memory_order_relaxed);
+                e.begin.store(begin, std::memory_order_relaxed);
+                e.end.store(end, std::memory_order_relaxed);
+                head.store(n + 1, std::memory_order_release);
+            }
+
+            const std::uint32_t                  id;
+            std::atomic<std::uint64_t>           head{ 0 };
+            std::array<profile_event, capacity> events;
+        };
+
+        struct profile_registry
+        {
+            static constexpr std::size_t frame_capacity = 1024;
+
+            std::mutex                                 mutex;
+            std::vector<std::shared_ptr<profile_ring>> rings;
+            // tid 0 in trace, written from gl thread only
+            profile_ring                               gpu{ 0 };
+
+            std::atomic<std::uint64_t>                         frames{ 0 };
+            std::array<std::atomic<std::uint64_t>, frame_capacity> frame_ends;
+        };
+
+        profile_registry& get_registry()
+        {
+            // never destroyed: threads may record during static destruction
+            static profile_registry* registry = new profile_registry();
+            return *registry;
+        }
+
+        profile_ring& get_thread_ring()
+        {
+            // registry keeps ring alive after thread exit for export
+            thread_local profile_ring* ring = [] {
+                profile_registry&           registry = get_registry();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                const auto                  id =
+                        static_cast<std::uint32_t>(registry.rings.size() + 1);
+                registry.rings.push_back(std::make_shared<profile_ring>(id));
+                return registry.rings.back().get();
+            }();
+            return *ring;
+        }
+
+        struct trace_event
+        {
+            const char*   name;
+            std::uint64_t begin;
+            std::uint64_t end;
+            std::uint32_t tid;
+        };
+
+        /// copy events inside [from, to] out of ring; only newest half
+        /// is read so writer has to wrap half ring during the copy to tear it
+        void collect(const profile_ring& ring, std::uint64_t from,
+                     std::uint64_t to, std::vector<trace_event>& out)
+        {
+            const std::uint64_t head  = ring.head.load(std::memory_order_acquire);
+            const std::uint64_t count = std::min<std::uint64_t>(
+                    head, profile_ring::capacity / 2);
+            for (std::uint64_t n = head - count; n < head; ++n)
+            {
+                const profile_event& e = ring.events[n % profile_ring::capacity];
+                trace_event t{ e.name.load(std::memory_order_relaxed),
+                               e.begin.load(std::memory_order_relaxed),
+                               e.end.load(std::memory_order_relaxed), ring.id };
+                if (t.name != nullptr && t.begin >= from && t.end <= to)
+                {
+                    out.push_back(t);
+                }
+            }
+        }
+
+        void write_json_string(std::ostream& out, const char* s)
+        {
+            out << '"';
+            for (; *s != '\0'; ++s)
+            {
+                if (*s == '"' || *s == '\\')
+                {
+                    out << '\\';
+                }
+                out << *s;
+            }
+            out << '"';
+        }
+    } // namespace
+
+    std::uint64_t profile_now_ns()
+    {
+        return static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+    }
+
+    void profile_record(const char* name, std::uint64_t begin_ns,
+                        std::uint64_t end_ns)
+    {
+        get_thread_ring().push(name, begin_ns, end_ns);
+    }
+
+    void profile_record_gpu(const char* name, std::uint64_t begin_ns,
+                            std::uint64_t duration_ns)
+    {
+        get_registry().gpu.push(name, begin_ns, begin_ns + duration_ns);
+    }
+
+    void profile_end_frame()
+    {
+        profile_registry&   registry = get_registry();
+        const std::uint64_t n = registry.frames.load(std::memory_order_relaxed);
+        registry.frame_ends[n % profile_registry::frame_capacity].store(
+                profile_now_ns(), std::memory_order_relaxed);
+        registry.frames.store(n + 1, std::memory_order_release);
+    }
+
+    std::string write_chrome_trace(std::string_view path,
+                                   std::uint32_t    frame_count)
+    {
+        profile_registry&   registry = get_registry();
+        const std::uint64_t frames =
+                registry.frames.load(std::memory_order_acquire);
+        if (frames < 2 || frame_count == 0)
+        {
+            return "profile: no finished frames to write";
+        }
+        // first frame starts at previous boundary
+        const std::uint64_t count = std::min<std::uint64_t>(
+                { frame_count, frames - 1, profile_registry::frame_capacity - 1 });
+        const auto frame_end = [&](std::uint64_t n) {
+            return registry.frame_ends[n % profile_registry::frame_capacity].load(
+                    std::memory_order_relaxed);
+        };
+        const std::uint64_t from = frame_end(frames - 1 - count);
+        const std::uint64_t to   = frame_end(frames - 1);
+
+        std::vector<trace_event>   events;
+        std::vector<std::uint32_t> tids;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (const auto& ring : registry.rings)
+            {
+                collect(*ring, from, to, events);
+                tids.push_back(ring->id);
+            }
+        }
+        // gpu work of last frames finishes later, so it may reach past `to`
+        collect(registry.gpu, from, ~std::uint64_t(0), events);
+        std::sort(events.begin(), events.end(),
+                  [](const trace_event& a, const trace_event& b) {
+                      return a.begin < b.begin;
+                  });
+
+        std::ofstream out{ std::string(path) };
+        if (!out)
+        {
+            return "profile: can't open " + std::string(path);
+        }
+        out << "{\"traceEvents\":[\n";
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":0,"args":{"name":"gpu"}})";
+        for (std::uint32_t tid : tids)
+        {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << tid << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+        }
+        for (std::uint64_t n = frames - count; n < frames; ++n)
+        {
+            out << ",\n{\"name\":\"frame " << n << "\",\"ph\":\"i\",\"s\":\"g\","
+                << "\"pid\":1,\"tid\":0,\"ts\":" << (frame_end(n) - from) / 1000.0
+                << '}';
+        }
+        for (const trace_event& e : events)
+        {
+            out << ",\n{\"name\":";
+            write_json_string(out, e.name);
+            // chrome trace wants microseconds
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+                << ",\"ts\":" << (e.begin - from) / 1000.0
+                << ",\"dur\":" << (e.end - e.begin) / 1000.0 << '}';
+        }
+        out << "\n]}\n";
+        return out ? "" : "profile: can't write " + std::string(path);
+    }
+
+} // end namespace eng
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "engine.hxx"
+
+/// eng_PROFILE 1 - scope markers and gpu timers are recorded,
+/// 0 - eng_PROFILE_SCOPE expands to nothing and engine skips gpu queries.
+/// Default: on in debug builds, off when NDEBUG is defined
+#ifndef eng_PROFILE
+#ifdef NDEBUG
+#define eng_PROFILE 0
+#else
+#define eng_PROFILE 1
+#endif
+#endif
+
+namespace eng
+{
+
+/// steady clock nanoseconds, time base of every profile event
+    std::uint64_t eng_DECLSPEC profile_now_ns();
+
+/// store finished cpu scope in ring of calling thread (no locks after
+/// first call on a thread). name is kept by pointer: use string literals
+    void eng_DECLSPEC profile_record(const char* name, std::uint64_t begin_ns,
+                                     std::uint64_t end_ns);
+/// gpu time of work submitted from cpu at begin_ns, own "gpu" track
+    void eng_DECLSPEC profile_record_gpu(const char* name, std::uint64_t begin_ns,
+                                         std::uint64_t duration_ns);
+/// frame boundary, backends call it in swap_buffers (eng_PROFILE_FRAME)
+    void eng_DECLSPEC profile_end_frame();
+
+/// write events of last frame_count finished frames as chrome trace
+/// json (chrome://tracing, ui.perfetto.dev)
+/// on success return empty string
+    std::string eng_DECLSPEC write_chrome_trace(std::string_view path,
+                                                std::uint32_t    frame_count);
+
+/// records its lifetime as one event, see eng_PROFILE_SCOPE.
+/// Costs two clock reads (~50-100 ns): mark passes and jobs, not triangles
+    class profile_scope
+    {
+    public:
+        explicit profile_scope(const char* name_)
+            : name(name_)
+            , begin(profile_now_ns())
+        {
+        }
+        ~profile_scope() { profile_record(name, begin, profile_now_ns()); }
+        profile_scope(const profile_scope&) = delete;
+        profile_scope& operator=(const profile_scope&) = delete;
+
+    private:
+        const char*   name;
+        std::uint64_t begin;
+    };
+
+} // end namespace eng
+
+#define eng_PROFILE_CAT2(a, b) a##b
+#define eng_PROFILE_CAT(a, b) eng_PROFILE_CAT2(a, b)
+
+#if eng_PROFILE
+/// time from here to end of enclosing block
+#define eng_PROFILE_SCOPE(name)                                                \
+    const ::eng::profile_scope eng_PROFILE_CAT(eng_profile_scope_,             \
+                                               __LINE__)(name)
+/// frame boundary for trace export
+#define eng_PROFILE_FRAME() ::eng::profile_end_frame()
+#else
+#define eng_PROFILE_SCOPE(name)
+#define eng_PROFILE_FRAME()
+#endif
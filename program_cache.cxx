@@ -0,0 +1,163 @@
+#include "program_cache.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <system_error>
+
+namespace eng
+{
+
+    namespace fs = std::filesystem;
+
+    namespace
+    {
+        /// program file: header followed by size bytes of driver binary
+        struct program_file_header
+        {
+            char          magic[4] = { 'E', 'N', 'G', 'P' };
+            std::uint32_t version  = 1;
+            std::uint64_t key      = 0;
+            /// GLenum from glGetProgramBinary
+            std::uint32_t format = 0;
+            std::uint32_t size   = 0;
+        };
+
+        static_assert(sizeof(program_file_header) == 24, "header layout changed");
+
+        constexpr std::uint64_t fnv_offset = 0xcbf29ce484222325ull;
+        constexpr std::uint64_t fnv_prime  = 0x100000001b3ull;
+
+        std::uint64_t fnv1a(std::uint64_t hash, const void* data, std::size_t size)
+        {
+            const auto* bytes = static_cast<const unsigned char*>(data);
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ bytes[i]) * fnv_prime;
+            }
+            return hash;
+        }
+
+        /// suffix of temporary file: random per process, counter per call
+        std::string unique_suffix()
+        {
+            static const std::uint32_t process_salt = std::random_device{}();
+            static std::atomic<std::uint32_t> counter{ 0 };
+            char suffix[32];
+            std::snprintf(suffix, sizeof(suffix), ".%08x.%08x.tmp",
+                          static_cast<unsigned>(process_salt),
+                          static_cast<unsigned>(counter.fetch_add(1)));
+            return suffix;
+        }
+    } // namespace
+
+    program_cache::program_cache(std::string_view directory_)
+        : directory(directory_)
+    {
+    }
+
+    std::uint64_t program_cache::make_key(std::initializer_list<std::string_view> parts)
+    {
+        std::uint64_t hash = fnv_offset;
+        for (std::string_view part : parts)
+        {
+            const std::uint64_t size = part.size();
+            hash                     = fnv1a(hash, &size, sizeof(size));
+            hash                     = fnv1a(hash, part.data(), part.size());
+        }
+        return hash;
+    }
+
+    bool program_cache::load(std::uint64_t key, std::uint32_t& format,
+                             std::vector<std::uint8_t>& binary) const
+    {
+        std::ifstream file(path_of(key), std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        program_file_header       header;
+        const program_file_header expected;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            !std::equal(header.magic, header.magic + 4, expected.magic) ||
+            header.version != expected.version || header.key != key ||
+            header.size == 0)
+        {
+            return false;
+        }
+        // size comes from file, don't allocate more than file holds
+        const std::streamoff data_start = file.tellg();
+        if (!file.seekg(0, std::ios::end) ||
+            file.tellg() - data_start != std::streamoff(header.size) ||
+            !file.seekg(data_start))
+        {
+            return false;
+        }
+        binary.resize(header.size);
+        if (!file.read(reinterpret_cast<char*>(binary.data()),
+                       static_cast<std::streamsize>(binary.size())))
+        {
+            return false;
+        }
+        format = header.format;
+        return true;
+    }
+
+    bool program_cache::store(std::uint64_t key, std::uint32_t format,
+                              const std::vector<std::uint8_t>& binary) const
+    {
+        if (binary.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            return false;
+        }
+        std::error_code ec;
+        fs::create_directories(directory, ec);
+        if (ec)
+        {
+            return false;
+        }
+        const fs::path path = path_of(key);
+        fs::path       temp = path;
+        temp += unique_suffix();
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            program_file_header header;
+            header.key    = key;
+            header.format = format;
+            header.size   = static_cast<std::uint32_t>(binary.size());
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(binary.data()),
+                       static_cast<std::streamsize>(binary.size()));
+            if (!file.flush())
+            {
+                fs::remove(temp, ec);
+                return false;
+            }
+        }
+        fs::rename(temp, path, ec);
+        if (ec)
+        {
+            fs::remove(temp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    void program_cache::remove(std::uint64_t key) const
+    {
+        std::error_code ec;
+        fs::remove(path_of(key), ec);
+    }
+
+    fs::path program_cache::path_of(std::uint64_t key) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.prog",
+                      static_cast<unsigned long long>(key));
+        return directory / name;
+    }
+
+} // end namespace eng
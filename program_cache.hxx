@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace eng
+{
+
+/// linked gl programs kept on disk as driver binaries, one file per
+/// program named by its key. Key hashes everything driver output depends
+/// on: shader sources, attribute bindings, gl vendor, renderer and
+/// version strings. Files are checked by header only, driver itself
+/// rejects binaries it can't load (glProgramBinary fails to link)
+    class program_cache
+    {
+    public:
+        /// directory is created on first store
+        explicit program_cache(std::string_view directory);
+
+        /// 64 bit fnv-1a over parts, length of every part is hashed too,
+        /// so ("ab", "c") and ("a", "bc") give different keys
+        static std::uint64_t make_key(std::initializer_list<std::string_view> parts);
+
+        /// false when there is no entry or its file is broken (size in
+        /// header is checked against file before anything is allocated)
+        bool load(std::uint64_t key, std::uint32_t& format,
+                  std::vector<std::uint8_t>& binary) const;
+        /// written to temporary file with name unique to this call and
+        /// renamed, so other process never reads half of entry and two
+        /// writers of one key don't share temporary file; false when file
+        /// can't be written
+        bool store(std::uint64_t key, std::uint32_t format,
+                   const std::vector<std::uint8_t>& binary) const;
+        /// forget entry driver refused
+        void remove(std::uint64_t key) const;
+
+    private:
+        std::filesystem::path path_of(std::uint64_t key) const;
+
+        std::filesystem::path directory;
+    };
+
+} // end namespace eng
@@ -0,0 +1,78 @@
+#include "texture_loader.hxx"
+
+#include <exception>
+
+namespace eng
+{
+
+    texture_loader::texture_loader(unsigned thread_count)
+    {
+        if (thread_count == 0)
+        {
+            const unsigned cores = std::thread::hardware_concurrency();
+            thread_count         = cores > 1 ? cores - 1 : 1;
+        }
+        threads.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            threads.emplace_back(&texture_loader::worker_loop, this);
+        }
+    }
+
+    texture_loader::~texture_loader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            queue.clear();
+        }
+        wake.notify_all();
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    std::shared_ptr<texture_request> texture_loader::load(std::string_view path)
+    {
+        auto request  = std::make_shared<texture_request>();
+        request->path = path;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(request);
+        }
+        wake.notify_one();
+        return request;
+    }
+
+    void texture_loader::worker_loop()
+    {
+        for (;;)
+        {
+            std::shared_ptr<texture_request> request;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stop || !queue.empty(); });
+                if (stop)
+                {
+                    return;
+                }
+                request = std::move(queue.front());
+                queue.pop_front();
+            }
+            if (!request->cancelled.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    request->img = load_png_image(request->path);
+                }
+                catch (const std::exception& ex)
+                {
+                    request->error = ex.what();
+                }
+            }
+            request->done.store(true, std::memory_order_release);
+        }
+    }
+
+} // end namespace eng
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "image.hxx"
+
+namespace eng
+{
+
+/// one png file read and decoded in background
+/// img and error are written by loader thread before done is set,
+/// owner reads them only after it sees done == true
+    struct texture_request
+    {
+        std::string       path;
+        image             img;
+        std::string       error; ///< empty on success
+        std::atomic<bool> done{ false };
+        /// owner lost interest, loader skips the file if not started yet
+        std::atomic<bool> cancelled{ false };
+    };
+
+/// threads doing file read and png decode for engine::create_texture_async
+/// gpu upload is left to the render thread
+    class texture_loader
+    {
+    public:
+        /// 0 - one thread per core except the render one, at least 1
+        explicit texture_loader(unsigned thread_count);
+        /// drop queued requests and wait for the ones being decoded
+        ~texture_loader();
+        texture_loader(const texture_loader&) = delete;
+        texture_loader& operator=(const texture_loader&) = delete;
+
+        /// queue file, return at once
+        std::shared_ptr<texture_request> load(std::string_view path);
+
+    private:
+        void worker_loop();
+
+        std::vector<std::thread>                     threads;
+        std::mutex                                   mutex;
+        std::condition_variable                      wake;
+        std::deque<std::shared_ptr<texture_request>> queue;
+        bool                                         stop = false;
+    };
+
+} // end namespace eng
@@ -0,0 +1,357 @@
+#include "transform.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
+#ifdef eng_HAS_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define eng_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define eng_TARGET_AVX2
+#endif
+
+namespace eng
+{
+
+    // kernels read matrices and points as plain float arrays
+    static_assert(sizeof(vec2) == 2 * sizeof(float), "vec2 layout");
+    static_assert(sizeof(mat2x3) == 6 * sizeof(float), "mat2x3 layout");
+    static_assert(offsetof(mat2x3, row2) == 2 * sizeof(float), "mat2x3 layout");
+    static_assert(offsetof(mat2x3, delta) == 4 * sizeof(float), "mat2x3 layout");
+    static_assert(offsetof(v2, p) == 0, "v2 layout");
+
+    struct transform_kernels
+    {
+        void (*points)(const vec2*, vec2*, std::size_t, const mat2x3&);
+        void (*points_each)(const vec2*, vec2*, std::size_t, const mat2x3*);
+        void (*positions)(v2*, std::size_t, const mat2x3&);
+        void (*compose)(const mat2x3*, const mat2x3*, mat2x3*, std::size_t);
+    };
+
+    // every level does the same multiplications and additions in same
+    // order without fma, so results are bit-identical between levels
+
+    static void points_scalar(const vec2* in, vec2* out, std::size_t count,
+                              const mat2x3& m)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float x = in[i].x;
+            const float y = in[i].y;
+            out[i].x      = x * m.row1.x + y * m.row2.x + m.delta.x;
+            out[i].y      = x * m.row1.y + y * m.row2.y + m.delta.y;
+        }
+    }
+
+    static void points_each_scalar(const vec2* in, vec2* out, std::size_t count,
+                                   const mat2x3* m)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float x = in[i].x;
+            const float y = in[i].y;
+            out[i].x      = x * m[i].row1.x + y * m[i].row2.x + m[i].delta.x;
+            out[i].y      = x * m[i].row1.y + y * m[i].row2.y + m[i].delta.y;
+        }
+    }
+
+    static void positions_scalar(v2* v, std::size_t count, const mat2x3& m)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float x = v[i].p.x;
+            const float y = v[i].p.y;
+            v[i].p.x      = x * m.row1.x + y * m.row2.x + m.delta.x;
+            v[i].p.y      = x * m.row1.y + y * m.row2.y + m.delta.y;
+        }
+    }
+
+    static void compose_scalar(const mat2x3* a, const mat2x3* b, mat2x3* out,
+                               std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            out[i] = a[i] * b[i];
+        }
+    }
+
+    static const transform_kernels scalar_kernels = { points_scalar,
+                                                      points_each_scalar,
+                                                      positions_scalar,
+                                                      compose_scalar };
+
+#ifdef eng_HAS_SSE2
+    static const float* floats(const void* p)
+    {
+        return static_cast<const float*>(p);
+    }
+    static float* floats(void* p)
+    {
+        return static_cast<float*>(p);
+    }
+
+    /// two points x0 y0 x1 y1 -> transformed x0 y0 x1 y1
+    static __m128 point_pair_sse2(__m128 p, __m128 r1, __m128 r2, __m128 d)
+    {
+        const __m128 xs = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 ys = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, r1), _mm_mul_ps(ys, r2)), d);
+    }
+
+    static void points_sse2(const vec2* in, vec2* out, std::size_t count,
+                            const mat2x3& m)
+    {
+        const __m128 r1 = _mm_setr_ps(m.row1.x, m.row1.y, m.row1.x, m.row1.y);
+        const __m128 r2 = _mm_setr_ps(m.row2.x, m.row2.y, m.row2.x, m.row2.y);
+        const __m128 d  = _mm_setr_ps(m.delta.x, m.delta.y, m.delta.x, m.delta.y);
+        const float* src = floats(in);
+        float*       dst = floats(out);
+        std::size_t  i   = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 p0 = _mm_loadu_ps(src + 2 * i);
+            const __m128 p1 = _mm_loadu_ps(src + 2 * i + 4);
+            _mm_storeu_ps(dst + 2 * i, point_pair_sse2(p0, r1, r2, d));
+            _mm_storeu_ps(dst + 2 * i + 4, point_pair_sse2(p1, r1, r2, d));
+        }
+        points_scalar(in + i, out + i, count - i, m);
+    }
+
+    static void points_each_sse2(const vec2* in, vec2* out, std::size_t count,
+                                 const mat2x3* m)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float* mf   = floats(&m[i]);
+            const __m128 rows = _mm_loadu_ps(mf); // r1x r1y r2x r2y
+            const __m128 d =
+                    _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(mf + 4));
+            const __m128 p  = _mm_loadl_pi(_mm_setzero_ps(),
+                                          reinterpret_cast<const __m64*>(&in[i]));
+            const __m128 xy = _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 0, 0));
+            const __m128 prod = _mm_mul_ps(rows, xy);
+            const __m128 sum  = _mm_add_ps(prod, _mm_movehl_ps(prod, prod));
+            _mm_storel_pi(reinterpret_cast<__m64*>(&out[i]), _mm_add_ps(sum, d));
+        }
+    }
+
+    static void positions_sse2(v2* v, std::size_t count, const mat2x3& m)
+    {
+        const __m128 r1 = _mm_setr_ps(m.row1.x, m.row1.y, m.row1.x, m.row1.y);
+        const __m128 r2 = _mm_setr_ps(m.row2.x, m.row2.y, m.row2.x, m.row2.y);
+        const __m128 d  = _mm_setr_ps(m.delta.x, m.delta.y, m.delta.x, m.delta.y);
+        std::size_t  i  = 0;
+        for (; i + 2 <= count; i += 2)
+        {
+            // positions are 20 bytes apart, gather two of them
+            auto* p0 = reinterpret_cast<__m64*>(&v[i].p);
+            auto* p1 = reinterpret_cast<__m64*>(&v[i + 1].p);
+            __m128 p = _mm_loadl_pi(_mm_setzero_ps(), p0);
+            p        = _mm_loadh_pi(p, p1);
+            p        = point_pair_sse2(p, r1, r2, d);
+            _mm_storel_pi(p0, p);
+            _mm_storeh_pi(p1, p);
+        }
+        positions_scalar(v + i, count - i, m);
+    }
+
+    static void compose_sse2(const mat2x3* a, const mat2x3* b, mat2x3* out,
+                             std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float* af = floats(&a[i]);
+            const float* bf = floats(&b[i]);
+
+            const __m128 a_rows = _mm_loadu_ps(af);
+            const __m128 a_d    = _mm_loadl_pi(_mm_setzero_ps(),
+                                            reinterpret_cast<const __m64*>(af + 4));
+            __m128 b1 = _mm_loadl_pi(_mm_setzero_ps(),
+                                     reinterpret_cast<const __m64*>(bf));
+            __m128 b2 = _mm_loadl_pi(_mm_setzero_ps(),
+                                     reinterpret_cast<const __m64*>(bf + 2));
+            const __m128 b_d = _mm_loadl_pi(_mm_setzero_ps(),
+                                            reinterpret_cast<const __m64*>(bf + 4));
+            b1 = _mm_movelh_ps(b1, b1);
+            b2 = _mm_movelh_ps(b2, b2);
+
+            const __m128 xs   = _mm_shuffle_ps(a_rows, a_rows, _MM_SHUFFLE(2, 2, 0, 0));
+            const __m128 ys   = _mm_shuffle_ps(a_rows, a_rows, _MM_SHUFFLE(3, 3, 1, 1));
+            const __m128 rows = _mm_add_ps(_mm_mul_ps(xs, b1), _mm_mul_ps(ys, b2));
+
+            const __m128 dxs   = _mm_shuffle_ps(a_d, a_d, _MM_SHUFFLE(0, 0, 0, 0));
+            const __m128 dys   = _mm_shuffle_ps(a_d, a_d, _MM_SHUFFLE(1, 1, 1, 1));
+            const __m128 delta = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(dxs, b1), _mm_mul_ps(dys, b2)), b_d);
+
+            float* of = floats(&out[i]);
+            _mm_storeu_ps(of, rows);
+            _mm_storel_pi(reinterpret_cast<__m64*>(of + 4), delta);
+        }
+    }
+
+    static const transform_kernels sse2_kernels = { points_sse2, points_each_sse2,
+                                                    positions_sse2, compose_sse2 };
+
+    eng_TARGET_AVX2 static void points_avx2(const vec2* in, vec2* out,
+                                            std::size_t count, const mat2x3& m)
+    {
+        const __m256 r1 = _mm256_setr_ps(m.row1.x, m.row1.y, m.row1.x, m.row1.y,
+                                         m.row1.x, m.row1.y, m.row1.x, m.row1.y);
+        const __m256 r2 = _mm256_setr_ps(m.row2.x, m.row2.y, m.row2.x, m.row2.y,
+                                         m.row2.x, m.row2.y, m.row2.x, m.row2.y);
+        const __m256 d  = _mm256_setr_ps(m.delta.x, m.delta.y, m.delta.x, m.delta.y,
+                                        m.delta.x, m.delta.y, m.delta.x, m.delta.y);
+        const float* src = floats(in);
+        float*       dst = floats(out);
+        std::size_t  i   = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 p0 = _mm256_loadu_ps(src + 2 * i);
+            const __m256 p1 = _mm256_loadu_ps(src + 2 * i + 8);
+            // x0 x0 x1 x1 | x2 x2 x3 x3 and same for y
+            const __m256 t0 = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_moveldup_ps(p0), r1),
+                                  _mm256_mul_ps(_mm256_movehdup_ps(p0), r2)),
+                    d);
+            const __m256 t1 = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_moveldup_ps(p1), r1),
+                                  _mm256_mul_ps(_mm256_movehdup_ps(p1), r2)),
+                    d);
+            _mm256_storeu_ps(dst + 2 * i, t0);
+            _mm256_storeu_ps(dst + 2 * i + 8, t1);
+        }
+        points_scalar(in + i, out + i, count - i, m);
+    }
+
+    // per-item matrices are 24 bytes apart, 256-bit lanes don't pay off
+    // there, so avx2 reuses sse2 kernels for them
+    static const transform_kernels avx2_kernels = { points_avx2, points_each_sse2,
+                                                    positions_sse2, compose_sse2 };
+#endif
+
+    static simd_level detect_simd_level()
+    {
+#ifdef eng_HAS_SSE2
+#if (defined(__GNUC__) || defined(__clang__)) &&                               \
+        (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return simd_level::avx2;
+        }
+#elif defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 1);
+        const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 &&
+                                  (info[2] & (1 << 28)) != 0 &&
+                                  (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        if (os_saves_ymm && (info[1] & (1 << 5)) != 0)
+        {
+            return simd_level::avx2;
+        }
+#endif
+        return simd_level::sse2;
+#else
+        return simd_level::scalar;
+#endif
+    }
+
+    static const transform_kernels* kernels_for(simd_level level)
+    {
+#ifdef eng_HAS_SSE2
+        switch (level)
+        {
+            case simd_level::avx2:
+                return &avx2_kernels;
+            case simd_level::sse2:
+                return &sse2_kernels;
+            case simd_level::scalar:
+                break;
+        }
+#else
+        (void)level;
+#endif
+        return &scalar_kernels;
+    }
+
+    static std::atomic<simd_level>& active_level()
+    {
+        static std::atomic<simd_level> level{ get_best_simd_level() };
+        return level;
+    }
+
+    static const transform_kernels& active()
+    {
+        return *kernels_for(active_level().load(std::memory_order_relaxed));
+    }
+
+    simd_level get_best_simd_level()
+    {
+        static const simd_level best = detect_simd_level();
+        return best;
+    }
+
+    simd_level get_simd_level()
+    {
+        return active_level().load(std::memory_order_relaxed);
+    }
+
+    void set_simd_level(simd_level level)
+    {
+        level = std::min(level, get_best_simd_level());
+        active_level().store(level, std::memory_order_relaxed);
+    }
+
+    const char* to_string(simd_level level)
+    {
+        switch (level)
+        {
+            case simd_level::scalar:
+                return "scalar";
+            case simd_level::sse2:
+                return "sse2";
+            case simd_level::avx2:
+                return "avx2";
+        }
+        return "unknown";
+    }
+
+    void transform_points(const vec2* in, vec2* out, std::size_t count,
+                          const mat2x3& m)
+    {
+        active().points(in, out, count, m);
+    }
+
+    void transform_points(const vec2* in, vec2* out, std::size_t count,
+                          const mat2x3* m)
+    {
+        active().points_each(in, out, count, m);
+    }
+
+    void transform_vertexes(const v2* in, v2* out, std::size_t count,
+                            const mat2x3& m)
+    {
+        if (in != out)
+        {
+            std::memcpy(static_cast<void*>(out), in, count * sizeof(v2));
+        }
+        active().positions(out, count, m);
+    }
+
+    void compose(const mat2x3* a, const mat2x3* b, mat2x3* out,
+                 std::size_t count)
+    {
+        active().compose(a, b, out, count);
+    }
+
+} // end namespace eng
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+
+#include "engine.hxx"
+
+/// SSE2 is known at compile time: always on x86-64, on 32 bit x86 when
+/// compiler targets it. Kernels of all modules test eng_HAS_SSE2
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+        (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define eng_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace eng
+{
+
+/// bulk affine transforms, translation included: p * m + m.delta
+/// (same math as u_matrix in shaders, unlike operator*(vec2, mat2x3))
+/// in and out may be the same array
+
+/// instruction set used by kernels below
+    enum class simd_level
+    {
+        scalar,
+        sse2,
+        avx2
+    };
+
+/// best level supported by this cpu (detected once at runtime)
+    simd_level eng_DECLSPEC get_best_simd_level();
+/// currently used level
+    simd_level eng_DECLSPEC get_simd_level();
+/// force level (for benchmarks), clamped to what cpu supports
+    void eng_DECLSPEC set_simd_level(simd_level level);
+
+    const char* eng_DECLSPEC to_string(simd_level level);
+
+/// out[i] = in[i] * m + m.delta
+    void eng_DECLSPEC transform_points(const vec2* in, vec2* out,
+                                       std::size_t count, const mat2x3& m);
+/// out[i] = in[i] * m[i] + m[i].delta
+    void eng_DECLSPEC transform_points(const vec2* in, vec2* out,
+                                       std::size_t count, const mat2x3* m);
+/// copy vertexes, transform positions, keep color and texture coordinate
+    void eng_DECLSPEC transform_vertexes(const v2* in, v2* out,
+                                         std::size_t count, const mat2x3& m);
+/// out[i] = a[i] * b[i]
+    void eng_DECLSPEC compose(const mat2x3* a, const mat2x3* b, mat2x3* out,
+                              std::size_t count);
+
+} // end namespace eng
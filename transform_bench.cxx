@@ -0,0 +1,59 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bench.hxx"
+#include "engine.hxx"
+#include "transform.hxx"
+
+/// throughput of bulk transform kernels for every simd level cpu supports
+/// usage: transform_bench [vertex_count]
+
+int main(int argc, char* argv[])
+{
+    const std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 16;
+
+    std::vector<eng::vec2>   points(count);
+    std::vector<eng::vec2>   out(count);
+    std::vector<eng::v2>     vertexes(count);
+    std::vector<eng::v2>     out_vertexes(count);
+    std::vector<eng::mat2x3> matrices(count);
+    std::vector<eng::mat2x3> out_matrices(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        points[i]     = eng::vec2(i * 0.001f, 1.f - i * 0.002f);
+        vertexes[i].p = points[i];
+        matrices[i]   = eng::mat2x3::rotate(i * 0.1f) * eng::mat2x3::scale(0.5f) *
+                      eng::mat2x3::move(points[i]);
+    }
+    const eng::mat2x3 m = matrices[count / 2];
+
+    std::cout << "items: " << count << ", ns per item\n"
+              << std::setw(8) << "level" << std::setw(12) << "points"
+              << std::setw(12) << "per-matrix" << std::setw(12) << "v2"
+              << std::setw(12) << "compose" << '\n';
+
+    const eng::simd_level best = eng::get_best_simd_level();
+    for (int level = 0; level <= static_cast<int>(best); ++level)
+    {
+        eng::set_simd_level(static_cast<eng::simd_level>(level));
+        const double t_points = eng::ns_per_item(count, [&] {
+            eng::transform_points(points.data(), out.data(), count, m);
+        });
+        const double t_each = eng::ns_per_item(count, [&] {
+            eng::transform_points(points.data(), out.data(), count, matrices.data());
+        });
+        const double t_v2 = eng::ns_per_item(count, [&] {
+            eng::transform_vertexes(vertexes.data(), out_vertexes.data(), count, m);
+        });
+        const double t_compose = eng::ns_per_item(count, [&] {
+            eng::compose(matrices.data(), matrices.data(), out_matrices.data(), count);
+        });
+        std::cout << std::setw(8) << eng::to_string(eng::get_simd_level())
+                  << std::fixed << std::setprecision(3) << std::setw(12)
+                  << t_points << std::setw(12) << t_each << std::setw(12) << t_v2
+                  << std::setw(12) << t_compose << '\n';
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+#include "vertex_layout.hxx"
+
+#include <cmath>
+
+#include "transform.hxx"
+
+namespace eng
+{
+
+    // kernel reads position and texture coordinate as one float4
+    static_assert(offsetof(v2, p) == 0 && offsetof(v2, t_p) == 8, "v2 layout");
+    static_assert(sizeof(v2_packed) == 12 && offsetof(v2_packed, u) == 4 &&
+                          offsetof(v2_packed, c) == 8,
+                  "v2_packed layout");
+
+    namespace
+    {
+        constexpr float position_scale = 32767.f / packed_position_range;
+
+        bool pack_scalar(const v2& in, v2_packed& out)
+        {
+            const float x = in.p.x * position_scale;
+            const float y = in.p.y * position_scale;
+            const float u = in.t_p.x * 65535.f;
+            const float v = in.t_p.y * 65535.f;
+            // written so that nan fails too
+            if (!(std::abs(x) <= 32767.f && std::abs(y) <= 32767.f && u >= 0.f &&
+                  u <= 65535.f && v >= 0.f && v <= 65535.f))
+            {
+                return false;
+            }
+            // round to nearest, same as _mm_cvtps_epi32
+            out.x = static_cast<std::int16_t>(std::lrint(x));
+            out.y = static_cast<std::int16_t>(std::lrint(y));
+            out.u = static_cast<std::uint16_t>(std::lrint(u));
+            out.v = static_cast<std::uint16_t>(std::lrint(v));
+            out.c = in.c;
+            return true;
+        }
+
+#ifdef eng_HAS_SSE2
+        /// one vertex per iteration: scale x y u v, convert, pack to 16 bit
+        bool pack_sse2(const v2* in, v2_packed* out, std::size_t count)
+        {
+            const __m128 scale =
+                    _mm_setr_ps(position_scale, position_scale, 65535.f, 65535.f);
+            const __m128 low  = _mm_setr_ps(-32767.f, -32767.f, 0.f, 0.f);
+            const __m128 high = _mm_setr_ps(32767.f, 32767.f, 65535.f, 65535.f);
+            // u and v are moved to signed range for saturating pack and
+            // back by flipping top bit
+            const __m128i bias = _mm_setr_epi32(0, 0, 32768, 32768);
+            const __m128i flip = _mm_setr_epi16(0, 0, -32768, -32768, 0, 0, 0, 0);
+            __m128        bad  = _mm_setzero_ps();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const __m128 f = _mm_mul_ps(_mm_loadu_ps(&in[i].p.x), scale);
+                // not-compares are true for nan
+                bad = _mm_or_ps(bad, _mm_cmpnge_ps(f, low));
+                bad = _mm_or_ps(bad, _mm_cmpnle_ps(f, high));
+                const __m128i n = _mm_sub_epi32(_mm_cvtps_epi32(f), bias);
+                const __m128i p = _mm_xor_si128(_mm_packs_epi32(n, n), flip);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(&out[i]), p);
+                out[i].c = in[i].c;
+            }
+            return _mm_movemask_ps(bad) == 0;
+        }
+#endif
+    } // namespace
+
+    bool pack_vertexes(const v2* in, v2_packed* out, std::size_t count)
+    {
+#ifdef eng_HAS_SSE2
+        if (get_simd_level() != simd_level::scalar)
+        {
+            return pack_sse2(in, out, count);
+        }
+#endif
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (!pack_scalar(in[i], out[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // end namespace eng
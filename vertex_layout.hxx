@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "engine.hxx"
+
+namespace eng
+{
+
+/// how gl reads components of vertex attribute
+    enum class attrib_type : std::uint8_t
+    {
+        float32,
+        /// [0, 255] read as [0, 1]
+        unorm8,
+        /// [-32767, 32767] read as [-1, 1]
+        snorm16,
+        /// [0, 65535] read as [0, 1]
+        unorm16
+    };
+
+/// attribute of vertex struct: shader location, components and their
+/// type, byte offset in struct
+    struct vertex_attrib
+    {
+        std::uint8_t location;
+        std::uint8_t components;
+        attrib_type  type;
+        std::uint8_t offset;
+    };
+
+/// vertex_layout<V>::attribs lists attributes of V at compile time,
+/// gl backend sets attribute pointers from it. Locations match shader
+/// bindings: 0 position, 1 color, 2 texture coordinate
+    template <typename V>
+    struct vertex_layout;
+
+/// v2 in 12 bytes instead of 20, for streamed batches: position is
+/// snorm16 scaled by packed_position_range, texture coordinate unorm16
+    struct v2_packed
+    {
+        std::int16_t  x, y;
+        std::uint16_t u, v;
+        color         c;
+    };
+
+/// packed positions cover [-range, range] in ndc, so sprites partly off
+/// screen still fit; step is 1/8192 ndc, about 1/25 pixel at 640 wide
+    constexpr float packed_position_range = 4.f;
+
+/// false when some vertex doesn't fit v2_packed (position out of range,
+/// texture coordinate out of [0, 1]), out is partly written then
+    bool eng_DECLSPEC pack_vertexes(const v2* in, v2_packed* out, std::size_t count);
+
+    template <>
+    struct vertex_layout<v0>
+    {
+        static constexpr std::array<vertex_attrib, 1> attribs{ {
+                { 0, 2, attrib_type::float32, offsetof(v0, p) },
+        } };
+    };
+
+    template <>
+    struct vertex_layout<v1>
+    {
+        static constexpr std::array<vertex_attrib, 2> attribs{ {
+                { 0, 2, attrib_type::float32, offsetof(v1, p) },
+                { 1, 4, attrib_type::unorm8, offsetof(v1, c) },
+        } };
+    };
+
+    template <>
+    struct vertex_layout<v2>
+    {
+        static constexpr std::array<vertex_attrib, 3> attribs{ {
+                { 0, 2, attrib_type::float32, offsetof(v2, p) },
+                { 1, 4, attrib_type::unorm8, offsetof(v2, c) },
+                { 2, 2, attrib_type::float32, offsetof(v2, t_p) },
+        } };
+    };
+
+    template <>
+    struct vertex_layout<v2_packed>
+    {
+        static constexpr std::array<vertex_attrib, 3> attribs{ {
+                { 0, 2, attrib_type::snorm16, offsetof(v2_packed, x) },
+                { 1, 4, attrib_type::unorm8, offsetof(v2_packed, c) },
+                { 2, 2, attrib_type::unorm16, offsetof(v2_packed, u) },
+        } };
+    };
+
+} // end namespace eng
@@ -0,0 +1,93 @@
+#include "worker_pool.hxx"
+
+namespace eng
+{
+
+    worker_pool::worker_pool(unsigned thread_count)
+    {
+        threads.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i)
+        {
+            threads.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    worker_pool::~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    void worker_pool::run(std::size_t                             count,
+                          const std::function<void(std::size_t)>& f)
+    {
+        if (threads.empty() || count < 2)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                f(i);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job       = &f;
+            job_count = count;
+            next_job.store(0, std::memory_order_relaxed);
+            busy = threads.size();
+            ++generation;
+        }
+        wake.notify_all();
+        take_jobs();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+    void worker_pool::take_jobs()
+    {
+        for (;;)
+        {
+            const std::size_t i = next_job.fetch_add(1, std::memory_order_relaxed);
+            if (i >= job_count)
+            {
+                return;
+            }
+            (*job)(i);
+        }
+    }
+
+    void worker_pool::worker_loop()
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stop || generation != seen; });
+                if (stop)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+            take_jobs();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busy == 0)
+                {
+                    done.notify_one();
+                }
+            }
+        }
+    }
+
+} // end namespace eng
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng
+{
+
+/// fixed set of threads splitting one parallel loop between them
+/// calling thread works too, so pool of 0 threads runs loop inline
+    class worker_pool
+    {
+    public:
+        explicit worker_pool(unsigned thread_count);
+        ~worker_pool();
+        worker_pool(const worker_pool&) = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+
+        /// call job(i) for every i in [0, count) and wait for all of them
+        void run(std::size_t count, const std::function<void(std::size_t)>& job);
+
+        unsigned get_thread_count() const
+        {
+            return static_cast<unsigned>(threads.size()) + 1;
+        }
+
+    private:
+        void worker_loop();
+        void take_jobs();
+
+        std::vector<std::thread> threads;
+        std::mutex               mutex;
+        std::condition_variable  wake;
+        std::condition_variable  done;
+
+        const std::function<void(std::size_t)>* job = nullptr;
+        std::size_t                             job_count = 0;
+        std::atomic<std::size_t>                next_job{ 0 };
+        std::size_t                             busy       = 0;
+        std::uint64_t                           generation = 0;
+        bool                                    stop       = false;
+    };
+
+} // end namespace eng